@@ -0,0 +1,387 @@
+/* This file contains the member function definitions
+   for the Analyzer class template */
+
+#include "Analyzer.hpp"
+#include "Enigma.hpp"
+#include "Rotor.hpp"
+#include "BigNumber.hpp"
+#include "constants.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+  /* Function to format a byte count with a binary unit suffix. */
+  string formatBytes(BigNumber const& bytes)
+  {
+    char const* const units[] = {"bytes", "KiB", "MiB", "GiB", "TiB", "PiB"};
+    double size = bytes.toDouble();
+    int unit = 0;
+    for (; size >= 1024.0 && unit < 5; unit++) {
+      size /= 1024.0;
+    }
+    char formatted[64];
+    if (unit == 0) {
+      snprintf(formatted, sizeof(formatted), "%.0f %s", size, units[unit]);
+    } else {
+      snprintf(formatted, sizeof(formatted), "%.1f %s", size, units[unit]);
+    }
+    return formatted;
+  }
+}
+
+template <int ALPHABET_SIZE>
+BasicAnalyzer<ALPHABET_SIZE>::BasicAnalyzer(
+    BasicEnigma<ALPHABET_SIZE> const& enigma) :
+  enigma_(enigma),
+  period_(1),
+  number_of_cycles_(1),
+  is_period_known_(true),
+  reachable_states_(1)
+{
+  int number_of_rotors = enigma_.getNumberOfRotors();
+  if (number_of_rotors == 0) {
+    return;
+  }
+
+  // Only a middle rotor can double step.
+  if (enigma_.isDoubleStepping() && number_of_rotors > 2) {
+    simulateStepping();
+    return;
+  }
+
+  // steps_per_subsystem[i] is the number of steps rotor i makes during one
+  // period of the subsystem formed by rotors i to number_of_rotors - 1.
+  // Adding rotor i - 1 to the subsystem multiplies the period by
+  // period_factors[i - 1].
+  vector<BigNumber> steps_per_subsystem(number_of_rotors);
+  vector<uint32_t> period_factors(number_of_rotors, 1);
+
+  period_ = BigNumber(ALPHABET_SIZE);
+  steps_per_subsystem[number_of_rotors - 1] = BigNumber(ALPHABET_SIZE);
+
+  for (int i = number_of_rotors - 1; i > 0; i--) {
+    // Over one subsystem period rotor i makes whole revolutions, each of
+    // which steps rotor i - 1 once per notch.
+    BigNumber neighbour_steps = steps_per_subsystem[i];
+    neighbour_steps.divide(ALPHABET_SIZE);
+    neighbour_steps.multiply(enigma_.getRotor(i).getNumberOfNotches());
+
+    uint32_t common = gcd<uint32_t>(ALPHABET_SIZE,
+				    neighbour_steps.remainder(ALPHABET_SIZE));
+    period_factors[i - 1] = ALPHABET_SIZE / common;
+
+    period_.multiply(period_factors[i - 1]);
+    number_of_cycles_.multiply(common);
+    neighbour_steps.multiply(period_factors[i - 1]);
+    steps_per_subsystem[i - 1] = neighbour_steps;
+  }
+
+  for (int i = 0; i < number_of_rotors; i++) {
+    BigNumber steps = steps_per_subsystem[i];
+    for (int j = 0; j < i; j++) {
+      steps.multiply(period_factors[j]);
+    }
+    steps_per_period_.push_back(steps);
+  }
+  reachable_states_ = period_;
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getPeriod() const
+{
+  return period_;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicAnalyzer<ALPHABET_SIZE>::isPeriodKnown() const
+{
+  return is_period_known_;
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getReachableStates() const
+{
+  return reachable_states_;
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getNumberOfStates() const
+{
+  BigNumber states(1);
+  for (int i = 0; i < enigma_.getNumberOfRotors(); i++) {
+    states.multiply(ALPHABET_SIZE);
+  }
+  return states;
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getNumberOfCycles() const
+{
+  return number_of_cycles_;
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getStepsPerPeriod(int rotor_index) const
+{
+  return steps_per_period_[rotor_index];
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getFirstStep(int rotor_index) const
+{
+  if (!first_steps_.empty()) {
+    return first_steps_[rotor_index];
+  }
+  if (steps_per_period_[rotor_index].isZero()) {
+    return BigNumber(0);
+  }
+  return getStepTime(rotor_index, BigNumber(0));
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getTableSize() const
+{
+  BigNumber size = period_;
+  size.multiply(ALPHABET_SIZE);
+  return size;
+}
+
+template <int ALPHABET_SIZE>
+void BasicAnalyzer<ALPHABET_SIZE>::printReport(
+    ostream& out,
+    char const* const* const rotor_file_names) const
+{
+  int number_of_rotors = enigma_.getNumberOfRotors();
+  bool is_simulated = !first_steps_.empty();
+
+  out << "Rotors: " << number_of_rotors << endl;
+  out << "Rotor states: " << getNumberOfStates().toString() << endl;
+  if (!is_period_known_) {
+    out << "Stepping period: not worked out, as double stepping is only";
+    out << " followed for up to " << ANALYZER_MAX_SIMULATED_STATES;
+    out << " rotor states" << endl;
+  } else if (is_simulated) {
+    out << "Stepping period: " << period_.toString() << " keystrokes";
+    out << " (double stepping)" << endl;
+    out << "Reachable states: " << reachable_states_.toString();
+    if (reachable_states_.compare(period_) > 0) {
+      // Both fit in a double exactly, as they were counted one by one.
+      out << " (" << static_cast<uint64_t>(
+	  reachable_states_.toDouble() - period_.toDouble());
+      out << " before the cycle is entered)";
+    }
+    out << endl;
+  } else {
+    out << "Stepping period: " << period_.toString() << " keystrokes";
+    out << endl;
+    out << "Reachable states: " << period_.toString() << " (state space";
+    out << " splits into " << number_of_cycles_.toString() << " cycle(s) of";
+    out << " this length)" << endl;
+  }
+
+  for (int i = 0; i < number_of_rotors; i++) {
+    BasicRotor<ALPHABET_SIZE> const& rotor = enigma_.getRotor(i);
+    out << endl << "Rotor " << i << " (" << rotor_file_names[i] << "):";
+    out << " position " << rotor.getTopLetter();
+    if (rotor.getRingSetting() != 0) {
+      out << ", ring setting " << rotor.getRingSetting();
+    }
+    out << ", notches";
+    for (int j = 0; j < rotor.getNumberOfNotches(); j++) {
+      out << " " << rotor.getNotch(j);
+    }
+    if (rotor.getNumberOfNotches() == 0) {
+      out << " none";
+    }
+    out << endl;
+
+    if (i == number_of_rotors - 1) {
+      out << "  steps on every keystroke" << endl;
+    } else if (!is_period_known_) {
+      continue;
+    } else if (steps_per_period_[i].isZero()) {
+      out << "  never steps" << endl;
+    } else {
+      out << "  steps " << steps_per_period_[i].toString();
+      out << " times per period, when rotor " << (i + 1) << " steps onto";
+      BasicRotor<ALPHABET_SIZE> const& neighbour =
+	enigma_.getRotor(i + 1);
+      for (int j = 0; j < neighbour.getNumberOfNotches(); j++) {
+	out << " " << neighbour.getNotch(j);
+      }
+      if (is_simulated && i > 0) {
+	out << " and when it double steps";
+      }
+      out << endl;
+      out << "  first steps on keystroke " << getFirstStep(i).toString();
+      if (is_simulated) {
+	out << endl;
+      } else if (i + 1 == number_of_rotors - 1) {
+	out << ", together with rotor " << (i + 1) << endl;
+      } else {
+	out << ", together with rotors " << (i + 1) << " to ";
+	out << (number_of_rotors - 1) << endl;
+      }
+    }
+  }
+
+  if (!is_period_known_) {
+    return;
+  }
+
+  out << endl << "Full-period lookup table: " << getTableSize().toString();
+  out << " bytes (" << formatBytes(getTableSize()) << ")" << endl;
+
+  for (int i = 0; i < number_of_rotors - 1; i++) {
+    if (steps_per_period_[i].isZero()) {
+      out << "Warning: rotor " << i << " never steps" << endl;
+    }
+  }
+  if (number_of_cycles_.compare(BigNumber(1)) > 0) {
+    out << "Warning: period is " << number_of_cycles_.toString();
+    out << " times shorter than the number of rotor states" << endl;
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicAnalyzer<ALPHABET_SIZE>::simulateStepping()
+{
+  int number_of_rotors = enigma_.getNumberOfRotors();
+  uint64_t number_of_states = 1;
+  for (int i = 0; i < number_of_rotors; i++) {
+    number_of_states *= ALPHABET_SIZE;
+    if (number_of_states > ANALYZER_MAX_SIMULATED_STATES) {
+      is_period_known_ = false;
+      return;
+    }
+  }
+
+  vector<int> start(number_of_rotors);
+  for (int i = 0; i < number_of_rotors; i++) {
+    start[i] = enigma_.getRotor(i).getTopLetter();
+  }
+  vector<bool> is_moved(number_of_rotors);
+
+  // Brent's algorithm finds the cycle length keeping only one earlier
+  // state, which is replaced whenever the distance to it reaches a power
+  // of two.
+  vector<int> saved = start;
+  vector<int> current = start;
+  stepPositions(current, is_moved);
+  uint64_t power = 1;
+  uint64_t cycle_length = 1;
+  while (current != saved) {
+    if (power == cycle_length) {
+      saved = current;
+      power *= 2;
+      cycle_length = 0;
+    }
+    stepPositions(current, is_moved);
+    cycle_length++;
+  }
+
+  // A second machine cycle_length keystrokes ahead meets the first as
+  // soon as the first reaches the cycle.
+  vector<int> behind = start;
+  vector<int> ahead = start;
+  for (uint64_t i = 0; i < cycle_length; i++) {
+    stepPositions(ahead, is_moved);
+  }
+  uint64_t tail_length = 0;
+  while (behind != ahead) {
+    stepPositions(behind, is_moved);
+    stepPositions(ahead, is_moved);
+    tail_length++;
+  }
+
+  vector<uint64_t> steps(number_of_rotors, 0);
+  first_steps_.assign(number_of_rotors, BigNumber(0));
+  current = start;
+  for (uint64_t keystroke = 1; keystroke <= tail_length + cycle_length;
+       keystroke++) {
+    stepPositions(current, is_moved);
+    for (int i = 0; i < number_of_rotors; i++) {
+      if (is_moved[i]) {
+	if (first_steps_[i].isZero()) {
+	  first_steps_[i] = BigNumber(keystroke);
+	}
+	if (keystroke > tail_length) {
+	  steps[i]++;
+	}
+      }
+    }
+  }
+
+  period_ = BigNumber(cycle_length);
+  reachable_states_ = BigNumber(tail_length + cycle_length);
+  for (int i = 0; i < number_of_rotors; i++) {
+    steps_per_period_.push_back(BigNumber(steps[i]));
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicAnalyzer<ALPHABET_SIZE>::stepPositions(vector<int>& positions,
+						 vector<bool>& is_moved) const
+{
+  // The same stepping as Enigma::rotateSlowerRotorsDoubleStepping.
+  int fast_index = enigma_.getNumberOfRotors() - 1;
+  positions[fast_index] = (positions[fast_index] + 1) % ALPHABET_SIZE;
+  is_moved[fast_index] = true;
+  bool is_carrying = enigma_.getRotor(fast_index).isNotch(
+      positions[fast_index]);
+
+  for (int i = fast_index - 1; i >= 0; i--) {
+    BasicRotor<ALPHABET_SIZE> const& rotor = enigma_.getRotor(i);
+    int next_position = (positions[i] + 1) % ALPHABET_SIZE;
+    is_moved[i] = is_carrying || (i > 0 && rotor.isNotch(next_position));
+    if (is_moved[i]) {
+      positions[i] = next_position;
+    }
+    is_carrying = is_moved[i] && rotor.isNotch(positions[i]);
+  }
+}
+
+template <int ALPHABET_SIZE>
+BigNumber BasicAnalyzer<ALPHABET_SIZE>::getStepTime(int rotor_index,
+						  BigNumber step_index) const
+{
+  if (rotor_index == enigma_.getNumberOfRotors() - 1) {
+    step_index.add(1);
+    return step_index;
+  }
+
+  // Rotor rotor_index steps whenever its right neighbour lands on a notch,
+  // which happens hits.size() times per revolution of the neighbour at
+  // fixed offsets within the revolution.
+  vector<int> hits;
+  getNotchHits(rotor_index + 1, hits);
+
+  uint32_t hit = step_index.divide(hits.size());
+  step_index.multiply(ALPHABET_SIZE);
+  step_index.add(hits[hit] - 1);
+
+  return getStepTime(rotor_index + 1, step_index);
+}
+
+template <int ALPHABET_SIZE>
+void BasicAnalyzer<ALPHABET_SIZE>::getNotchHits(int rotor_index,
+						vector<int>& hits) const
+{
+  BasicRotor<ALPHABET_SIZE> const& rotor = enigma_.getRotor(rotor_index);
+  for (int i = 0; i < rotor.getNumberOfNotches(); i++) {
+    int distance = (rotor.getNotch(i) - rotor.getTopLetter()
+		    + ALPHABET_SIZE) % ALPHABET_SIZE;
+    hits.push_back((distance == 0) ? ALPHABET_SIZE : distance);
+  }
+  sort(hits.begin(), hits.end());
+}
+
+template class BasicAnalyzer<ALPHABET_LENGTH>;
+template class BasicAnalyzer<BYTE_ALPHABET_LENGTH>;
@@ -0,0 +1,131 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+/* The Analyzer class template computes the stepping behaviour of a set up
+   Enigma machine from its notch configuration, without running the
+   machine.
+   The rotors step like an odometer: the rightmost rotor steps on every
+   keystroke and each rotor steps its left neighbour whenever it steps onto
+   one of its notches. Because a rotor with k notches steps its neighbour
+   exactly k times per revolution whatever its starting position, the
+   period of every rotor subsystem can be derived in closed form from
+   the notch counts alone.
+   When the machine double steps (see Enigma::setDoubleStepping) a middle
+   rotor's steps also depend on its own position, so there is no such
+   closed form. The rotor states are then followed keystroke by keystroke
+   until they repeat, which is done for machines with up to
+   ANALYZER_MAX_SIMULATED_STATES rotor states; the period of larger ones
+   is not worked out. The positions the machine starts from need not lie
+   on the cycle it ends up in, since a double step skips states.
+   Ring settings move the wiring, not the notches, so they do not change
+   the stepping.
+   enigma_ is the machine being analysed.
+   period_ is the number of keystrokes after which the rotor positions
+   repeat.
+   number_of_cycles_ is the number of disjoint cycles that the rotor state
+   space splits into, all of which have length period_.
+   steps_per_period_ contains, for each rotor, the number of times it steps
+   during one period.
+   is_period_known_ is false if the period was too long to work out.
+   reachable_states_ is the number of distinct rotor states reached from
+   the starting position, which is period_ unless the machine double
+   steps.
+   first_steps_ contains, for each rotor, the keystroke on which it first
+   steps when the stepping was followed keystroke by keystroke, and is
+   empty otherwise.
+   Analyzer analyses an Enigma and ByteAnalyzer a ByteEnigma. */
+
+#include "Enigma.hpp"
+#include "BigNumber.hpp"
+#include "constants.h"
+#include <ostream>
+#include <vector>
+
+/* Largest number of rotor states for which the stepping of a double
+   stepping machine is followed keystroke by keystroke. */
+#define ANALYZER_MAX_SIMULATED_STATES (1 << 20)
+
+template <int ALPHABET_SIZE>
+class BasicAnalyzer
+{
+public:
+  /* Function to analyse the stepping of the given machine, which must
+     already be set up. */
+  BasicAnalyzer(BasicEnigma<ALPHABET_SIZE> const& enigma);
+
+  /* Function to return the number of keystrokes after which the rotor
+     positions repeat. This is also the number of distinct rotor states
+     reachable from the starting position. */
+  BigNumber getPeriod() const;
+
+  /* Function to return false if the period was not worked out, in which
+     case only getNumberOfStates may be used. */
+  bool isPeriodKnown() const;
+
+  /* Function to return the number of distinct rotor states reached from
+     the starting position. */
+  BigNumber getReachableStates() const;
+
+  /* Function to return the total number of rotor states, which is the
+     alphabet length to the power of the number of rotors. */
+  BigNumber getNumberOfStates() const;
+
+  /* Function to return the number of disjoint cycles of length
+     getPeriod() that the rotor state space splits into. */
+  BigNumber getNumberOfCycles() const;
+
+  /* Function to return the number of times the rotor accessed by index
+     steps during one period. Zero means the rotor never moves. */
+  BigNumber getStepsPerPeriod(int rotor_index) const;
+
+  /* Function to return the keystroke (counting from 1) on which the rotor
+     accessed by index first steps. Zero means the rotor never moves. */
+  BigNumber getFirstStep(int rotor_index) const;
+
+  /* Function to return the number of bytes a lookup table holding the
+     complete machine permutation for every keystroke of one period
+     would need, with one byte per letter. */
+  BigNumber getTableSize() const;
+
+  /* Function to write a human readable report to out.
+     rotor_file_names is a pointer to an array of pointers to c-strings
+     containing the names of the rotor configuration files, in the same
+     order as the rotors. */
+  void printReport(std::ostream& out,
+		   char const* const* const rotor_file_names) const;
+
+private:
+  BasicEnigma<ALPHABET_SIZE> const& enigma_;
+  BigNumber period_;
+  BigNumber number_of_cycles_;
+  std::vector<BigNumber> steps_per_period_;
+  bool is_period_known_;
+  BigNumber reachable_states_;
+  std::vector<BigNumber> first_steps_;
+
+  /* Function to work out the period and steps of a double stepping
+     machine by following its rotor states until they repeat. */
+  void simulateStepping();
+
+  /* Function to step positions, which holds the position of every rotor,
+     like the double stepping machine does on one keystroke, setting
+     is_moved to whether each rotor moved. */
+  void stepPositions(std::vector<int>& positions,
+		     std::vector<bool>& is_moved) const;
+
+  /* Function to return the keystroke on which the rotor accessed by index
+     makes its step with the given zero-based step_index.
+     The rotor must step at least once per period. */
+  BigNumber getStepTime(int rotor_index, BigNumber step_index) const;
+
+  /* Function to fill hits with the number of steps (from 1 to
+     ALPHABET_SIZE) the
+     rotor accessed by index must make from its current position to land
+     on each of its notches, in increasing order. */
+  void getNotchHits(int rotor_index, std::vector<int>& hits) const;
+};
+
+typedef BasicAnalyzer<ALPHABET_LENGTH> Analyzer;
+typedef BasicAnalyzer<BYTE_ALPHABET_LENGTH> ByteAnalyzer;
+
+#endif
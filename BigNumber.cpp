@@ -0,0 +1,121 @@
+/* This file contains the member function definitions
+   for the BigNumber class */
+
+#include "BigNumber.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+  const uint32_t LIMB_BASE = 1000000000;
+}
+
+BigNumber::BigNumber(uint64_t value)
+{
+  while (value > 0) {
+    limbs_.push_back(static_cast<uint32_t>(value % LIMB_BASE));
+    value /= LIMB_BASE;
+  }
+}
+
+void BigNumber::add(uint32_t value)
+{
+  uint64_t carry = value;
+  for (size_t i = 0; i < limbs_.size() && carry > 0; i++) {
+    uint64_t sum = static_cast<uint64_t>(limbs_[i]) + carry;
+    limbs_[i] = static_cast<uint32_t>(sum % LIMB_BASE);
+    carry = sum / LIMB_BASE;
+  }
+  while (carry > 0) {
+    limbs_.push_back(static_cast<uint32_t>(carry % LIMB_BASE));
+    carry /= LIMB_BASE;
+  }
+}
+
+void BigNumber::multiply(uint32_t factor)
+{
+  uint64_t carry = 0;
+  for (size_t i = 0; i < limbs_.size(); i++) {
+    uint64_t product = static_cast<uint64_t>(limbs_[i]) * factor + carry;
+    limbs_[i] = static_cast<uint32_t>(product % LIMB_BASE);
+    carry = product / LIMB_BASE;
+  }
+  while (carry > 0) {
+    limbs_.push_back(static_cast<uint32_t>(carry % LIMB_BASE));
+    carry /= LIMB_BASE;
+  }
+  trim();
+}
+
+uint32_t BigNumber::divide(uint32_t divisor)
+{
+  uint64_t rest = 0;
+  for (size_t i = limbs_.size(); i > 0; i--) {
+    uint64_t current = rest * LIMB_BASE + limbs_[i - 1];
+    limbs_[i - 1] = static_cast<uint32_t>(current / divisor);
+    rest = current % divisor;
+  }
+  trim();
+  return static_cast<uint32_t>(rest);
+}
+
+uint32_t BigNumber::remainder(uint32_t divisor) const
+{
+  uint64_t rest = 0;
+  for (size_t i = limbs_.size(); i > 0; i--) {
+    rest = (rest * LIMB_BASE + limbs_[i - 1]) % divisor;
+  }
+  return static_cast<uint32_t>(rest);
+}
+
+bool BigNumber::isZero() const
+{
+  return limbs_.empty();
+}
+
+int BigNumber::compare(BigNumber const& other) const
+{
+  if (limbs_.size() != other.limbs_.size()) {
+    return (limbs_.size() < other.limbs_.size()) ? -1 : 1;
+  }
+  for (size_t i = limbs_.size(); i > 0; i--) {
+    if (limbs_[i - 1] != other.limbs_[i - 1]) {
+      return (limbs_[i - 1] < other.limbs_[i - 1]) ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+double BigNumber::toDouble() const
+{
+  double value = 0.0;
+  for (size_t i = limbs_.size(); i > 0; i--) {
+    value = value * LIMB_BASE + limbs_[i - 1];
+  }
+  return value;
+}
+
+string BigNumber::toString() const
+{
+  if (limbs_.empty()) {
+    return "0";
+  }
+
+  string digits = to_string(limbs_.back());
+  for (size_t i = limbs_.size() - 1; i > 0; i--) {
+    char limb_digits[10];
+    snprintf(limb_digits, sizeof(limb_digits), "%09u", limbs_[i - 1]);
+    digits += limb_digits;
+  }
+  return digits;
+}
+
+void BigNumber::trim()
+{
+  while (!limbs_.empty() && limbs_.back() == 0) {
+    limbs_.pop_back();
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef BIGNUMBER_H
+#define BIGNUMBER_H
+
+/* The BigNumber class contains an arbitrarily large non-negative integer.
+   It is used for quantities such as stepping periods and state counts,
+   which grow as the alphabet length to the power of the number of rotors
+   and quickly overflow the built-in integer types.
+   limbs_ contains the digits of the number in base 10^9, least
+   significant limb first. */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BigNumber
+{
+public:
+  /* Function to initialise BigNumber object to the given value. */
+  BigNumber(std::uint64_t value = 0);
+
+  /* Function to add a small value to the number. */
+  void add(std::uint32_t value);
+
+  /* Function to multiply the number by a small factor. */
+  void multiply(std::uint32_t factor);
+
+  /* Function to divide the number by a small non-zero divisor.
+     The function returns the remainder of the division. */
+  std::uint32_t divide(std::uint32_t divisor);
+
+  /* Function to return the remainder of dividing the number by a
+     small non-zero divisor, without changing the number. */
+  std::uint32_t remainder(std::uint32_t divisor) const;
+
+  /* Function to return true if the number is zero. */
+  bool isZero() const;
+
+  /* Function to compare the number with another BigNumber. Returns a
+     negative value, zero or a positive value if the number is less than,
+     equal to or greater than other. */
+  int compare(BigNumber const& other) const;
+
+  /* Function to return an approximation of the number as a double. */
+  double toDouble() const;
+
+  /* Function to return the number as a decimal string. */
+  std::string toString() const;
+
+private:
+  std::vector<std::uint32_t> limbs_;
+
+  /* Function to remove leading zero limbs. */
+  void trim();
+};
+
+#endif
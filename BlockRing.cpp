@@ -0,0 +1,38 @@
+/* This file contains the member function definitions
+   for the BlockRing class */
+
+#include "BlockRing.hpp"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+BlockRing::BlockRing(int capacity) :
+  slots_(capacity),
+  head_(0),
+  tail_(0) {}
+
+bool BlockRing::push(int block_index)
+{
+  size_t tail = tail_.load(memory_order_relaxed);
+  if (tail - head_.load(memory_order_acquire) == slots_.size()) {
+    return false;
+  }
+
+  slots_[tail % slots_.size()] = block_index;
+  tail_.store(tail + 1, memory_order_release);
+  return true;
+}
+
+bool BlockRing::pop(int& block_index)
+{
+  size_t head = head_.load(memory_order_relaxed);
+  if (head == tail_.load(memory_order_acquire)) {
+    return false;
+  }
+
+  block_index = slots_[head % slots_.size()];
+  head_.store(head + 1, memory_order_release);
+  return true;
+}
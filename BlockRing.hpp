@@ -0,0 +1,42 @@
+#ifndef BLOCKRING_H
+#define BLOCKRING_H
+
+/* The BlockRing class is a bounded lock-free queue of block indices for
+   exactly one producer thread and one consumer thread. It is used to pass
+   reusable blocks between the stages of a Pipeline, so only the small
+   block indices move between threads and nothing is allocated after
+   construction.
+   slots_ contains the queued block indices.
+   head_ counts the indices taken out by the consumer and tail_ counts the
+   indices put in by the producer. They are kept on separate cache lines
+   so the two threads do not contend for the same line. */
+
+#include "constants.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+class BlockRing
+{
+public:
+  /* Function to initialise an empty BlockRing object which can hold up to
+     capacity indices at once. */
+  BlockRing(int capacity);
+
+  /* Function to add a block index to the back of the queue. Must only be
+     called by the producer thread. Returns false, without adding the
+     index, if the queue is full. */
+  bool push(int block_index);
+
+  /* Function to take the block index at the front of the queue. Must only
+     be called by the consumer thread. Returns false, leaving block_index
+     unchanged, if the queue is empty. */
+  bool pop(int& block_index);
+
+private:
+  std::vector<int> slots_;
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head_;
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_;
+};
+
+#endif
@@ -0,0 +1,463 @@
+/* This file contains the component catalog and the definitions
+   of the functions looking it up */
+
+#include "Catalog.hpp"
+#include "Enigma.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+  /* A rotor as it is usually written: the letter each letter is wired
+     to and the letters with notches. */
+  struct RotorSource
+  {
+    char const* name;
+    char const* wiring;
+    char const* notches;
+  };
+
+  /* A reflector written like a rotor, or a plugboard written as pairs
+     of letters separated by spaces. */
+  struct WiringSource
+  {
+    char const* name;
+    char const* letters;
+  };
+
+  constexpr RotorSource ROTOR_SOURCES[] = {
+    {"I", "EKMFLGDQVZNTOWYHXUSPAIBRCJ", "R"},
+    {"II", "AJDKSIRUXBLHWTMCQGZNPYFVOE", "F"},
+    {"III", "BDFHJLCPRTXVZNYEIWGAKMUSQO", "W"},
+    {"IV", "ESOVPZJAYQUIRHXLNFTGKDCMWB", "K"},
+    {"V", "VZBRGITYUPSDNHLXAWMJQOFECK", "A"},
+    {"VI", "JPGVOUMFYQBENHZRDKASXLICTW", "AN"},
+    {"VII", "NZJHGRCXMYSWBOUFAIVLPEKQDT", "AN"},
+    {"VIII", "FKQHTLXOCBJSPDZRAMEWNIUYGV", "AN"},
+    {"shift_up", "BCDEFGHIJKLMNOPQRSTUVWXYZA", "A"}
+  };
+
+  constexpr WiringSource REFLECTOR_SOURCES[] = {
+    {"I", "EJMZALYXVBWFCRQUONTSPIKHGD"},
+    {"II", "YRUHQSLDPXNGOKMIEBFZCWVJAT"},
+    {"III", "FVPJIAOYEDRZXWGCTKUQSBNMHL"},
+    {"IV", "ENKQAUYWJICOPBLMDXZVFTHRGS"},
+    {"V", "RDOBJNTKVEHMLFCWZAXGYIPSUQ"}
+  };
+
+  constexpr WiringSource PLUGBOARD_SOURCES[] = {
+    {"I", "ZI"},
+    {"II", "ZK WJ VE"},
+    {"III", "XI UW SQ YC JM"},
+    {"IV", "XG JF VA SI BL YE OU MD KZ HR"},
+    {"V", "VB YQ KG OD AS UJ ET CZ HM FL PR IN XW"}
+  };
+
+  constexpr BuiltinPositions POSITIONS[] = {
+    {"I", "AAA"},
+    {"II", "DPV"},
+    {"III", "LZM"}
+  };
+
+  /* Function to return true if letter is an upper case letter. */
+  constexpr bool isLetter(char letter)
+  {
+    return letter >= ASCII_A && letter <= ASCII_Z;
+  }
+
+  /* Function to return true if wiring contains every letter exactly
+     once. */
+  constexpr bool isPermutation(char const* wiring)
+  {
+    bool is_used[ALPHABET_LENGTH] = {};
+    int length = 0;
+    for (; wiring[length] != '\0'; length++) {
+      if (length == ALPHABET_LENGTH || !isLetter(wiring[length]) ||
+	  is_used[wiring[length] - ASCII_A]) {
+	return false;
+      }
+      is_used[wiring[length] - ASCII_A] = true;
+    }
+    return length == ALPHABET_LENGTH;
+  }
+
+  /* Function to return true if letters only contains distinct upper case
+     letters. */
+  constexpr bool areDistinctLetters(char const* letters)
+  {
+    bool is_used[ALPHABET_LENGTH] = {};
+    for (int i = 0; letters[i] != '\0'; i++) {
+      if (!isLetter(letters[i]) || is_used[letters[i] - ASCII_A]) {
+	return false;
+      }
+      is_used[letters[i] - ASCII_A] = true;
+    }
+    return true;
+  }
+
+  /* Function to return true if a reflector wiring pairs every letter
+     with a different letter. */
+  constexpr bool isReflector(char const* wiring)
+  {
+    if (!isPermutation(wiring)) {
+      return false;
+    }
+    for (int i = 0; i < ALPHABET_LENGTH; i++) {
+      int partner = wiring[i] - ASCII_A;
+      if (partner == i || wiring[partner] - ASCII_A != i) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  /* Function to return true if a plugboard is written as pairs of
+     distinct letters separated by single spaces, with no letter used
+     twice. */
+  constexpr bool isPlugboard(char const* pairs)
+  {
+    bool is_used[ALPHABET_LENGTH] = {};
+    int i = 0;
+    for (; pairs[i] != '\0'; i += 3) {
+      if (!isLetter(pairs[i]) || !isLetter(pairs[i + 1]) ||
+	  pairs[i] == pairs[i + 1] || is_used[pairs[i] - ASCII_A] ||
+	  is_used[pairs[i + 1] - ASCII_A] ||
+	  (pairs[i + 2] != ' ' && pairs[i + 2] != '\0')) {
+	return false;
+      }
+      is_used[pairs[i] - ASCII_A] = true;
+      is_used[pairs[i + 1] - ASCII_A] = true;
+      if (pairs[i + 2] == '\0') {
+	return true;
+      }
+    }
+    return i == 0;
+  }
+
+  constexpr bool areRotorSourcesValid()
+  {
+    for (RotorSource const& source : ROTOR_SOURCES) {
+      if (!isPermutation(source.wiring) ||
+	  !areDistinctLetters(source.notches)) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  constexpr bool areReflectorSourcesValid()
+  {
+    for (WiringSource const& source : REFLECTOR_SOURCES) {
+      if (!isReflector(source.letters)) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  constexpr bool arePlugboardSourcesValid()
+  {
+    for (WiringSource const& source : PLUGBOARD_SOURCES) {
+      if (!isPlugboard(source.letters)) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  constexpr bool arePositionsValid()
+  {
+    for (BuiltinPositions const& positions : POSITIONS) {
+      for (int i = 0; positions.letters[i] != '\0'; i++) {
+	if (!isLetter(positions.letters[i])) {
+	  return false;
+	}
+      }
+    }
+    return true;
+  }
+
+  static_assert(areRotorSourcesValid(),
+		"every built-in rotor must wire each letter to exactly one"
+		" letter and have distinct notches");
+  static_assert(areReflectorSourcesValid(),
+		"every built-in reflector must pair each letter with a"
+		" different letter");
+  static_assert(arePlugboardSourcesValid(),
+		"every built-in plugboard must be pairs of distinct letters");
+  static_assert(arePositionsValid(),
+		"built-in rotor positions must be upper case letters");
+
+  /* Functions to build the catalog entries from their sources. */
+  constexpr BuiltinRotor makeRotor(RotorSource const& source)
+  {
+    BuiltinRotor rotor = {};
+    rotor.name = source.name;
+    for (int i = 0; i < ALPHABET_LENGTH; i++) {
+      int output_letter = source.wiring[i] - ASCII_A;
+      rotor.forward[i] = output_letter;
+      rotor.backward[output_letter] = i;
+    }
+    for (int i = 0; source.notches[i] != '\0'; i++) {
+      rotor.notch_mask |= static_cast<uint64_t>(1)
+	<< (source.notches[i] - ASCII_A);
+    }
+    return rotor;
+  }
+
+  constexpr BuiltinWiring makeReflector(WiringSource const& source)
+  {
+    BuiltinWiring reflector = {};
+    reflector.name = source.name;
+    for (int i = 0; i < ALPHABET_LENGTH; i++) {
+      reflector.mapping[i] = source.letters[i] - ASCII_A;
+    }
+    return reflector;
+  }
+
+  constexpr BuiltinWiring makePlugboard(WiringSource const& source)
+  {
+    BuiltinWiring plugboard = {};
+    plugboard.name = source.name;
+    for (int i = 0; i < ALPHABET_LENGTH; i++) {
+      plugboard.mapping[i] = i;
+    }
+    for (int i = 0; source.letters[i] != '\0'; i += 3) {
+      int first_letter = source.letters[i] - ASCII_A;
+      int second_letter = source.letters[i + 1] - ASCII_A;
+      plugboard.mapping[first_letter] = second_letter;
+      plugboard.mapping[second_letter] = first_letter;
+      if (source.letters[i + 2] == '\0') {
+	break;
+      }
+    }
+    return plugboard;
+  }
+
+  template <size_t N>
+  constexpr array<BuiltinRotor, N> makeRotors(RotorSource const (&sources)[N])
+  {
+    array<BuiltinRotor, N> rotors = {};
+    for (size_t i = 0; i < N; i++) {
+      rotors[i] = makeRotor(sources[i]);
+    }
+    return rotors;
+  }
+
+  template <size_t N>
+  constexpr array<BuiltinWiring, N> makeWirings(
+      WiringSource const (&sources)[N], bool is_reflector)
+  {
+    array<BuiltinWiring, N> wirings = {};
+    for (size_t i = 0; i < N; i++) {
+      wirings[i] = (is_reflector)
+	? makeReflector(sources[i]) : makePlugboard(sources[i]);
+    }
+    return wirings;
+  }
+
+  constexpr auto ROTORS = makeRotors(ROTOR_SOURCES);
+  constexpr auto REFLECTORS = makeWirings(REFLECTOR_SOURCES, true);
+  constexpr auto PLUGBOARDS = makeWirings(PLUGBOARD_SOURCES, false);
+
+  /* Function to return true if the backward wiring of every built rotor
+     undoes its forward wiring. */
+  constexpr bool areRotorsInverted()
+  {
+    for (BuiltinRotor const& rotor : ROTORS) {
+      for (int i = 0; i < ALPHABET_LENGTH; i++) {
+	if (rotor.backward[rotor.forward[i]] != i) {
+	  return false;
+	}
+      }
+    }
+    return true;
+  }
+
+  static_assert(areRotorsInverted(),
+		"every built-in rotor's backward wiring must invert its"
+		" forward wiring");
+
+  /* Function to return the one of the number_of_entries entries named
+     file_name, or nullptr if there is none. */
+  template <typename Entry>
+  Entry const* findEntry(Entry const* entries, size_t number_of_entries,
+			 char const* file_name)
+  {
+    if (!isBuiltinName(file_name)) {
+      return nullptr;
+    }
+    char const* name = file_name + strlen(BUILTIN_PREFIX);
+    for (size_t i = 0; i < number_of_entries; i++) {
+      if (strcmp(entries[i].name, name) == 0) {
+	return &entries[i];
+      }
+    }
+    return nullptr;
+  }
+}
+
+bool isBuiltinName(char const* file_name)
+{
+  return strncmp(file_name, BUILTIN_PREFIX, strlen(BUILTIN_PREFIX)) == 0;
+}
+
+BuiltinRotor const* findBuiltinRotor(char const* file_name)
+{
+  return findEntry(ROTORS.data(), ROTORS.size(), file_name);
+}
+
+BuiltinWiring const* findBuiltinReflector(char const* file_name)
+{
+  return findEntry(REFLECTORS.data(), REFLECTORS.size(), file_name);
+}
+
+BuiltinWiring const* findBuiltinPlugboard(char const* file_name)
+{
+  return findEntry(PLUGBOARDS.data(), PLUGBOARDS.size(), file_name);
+}
+
+BuiltinPositions const* findBuiltinPositions(char const* file_name)
+{
+  return findEntry(POSITIONS, sizeof(POSITIONS) / sizeof(POSITIONS[0]),
+		   file_name);
+}
+
+bool writeBuiltinSetting(int setting_kind, char const* file_name,
+			 ostream& out)
+{
+  if (setting_kind == SETTING_ROTOR) {
+    BuiltinRotor const* rotor = findBuiltinRotor(file_name);
+    if (rotor == nullptr) {
+      return false;
+    }
+    for (int i = 0; i < ALPHABET_LENGTH; i++) {
+      out << static_cast<int>(rotor->forward[i]) << " ";
+    }
+    for (int i = 0; i < ALPHABET_LENGTH; i++) {
+      if ((rotor->notch_mask >> i) & 1) {
+	out << i << " ";
+      }
+    }
+    return true;
+  }
+
+  if (setting_kind == SETTING_POSITIONS) {
+    BuiltinPositions const* positions = findBuiltinPositions(file_name);
+    if (positions == nullptr) {
+      return false;
+    }
+    for (int i = 0; positions->letters[i] != '\0'; i++) {
+      out << positions->letters[i] - ASCII_A << " ";
+    }
+    return true;
+  }
+
+  // Plugboard and reflector files list each pair of letters once.
+  BuiltinWiring const* wiring = (setting_kind == SETTING_PLUGBOARD)
+    ? findBuiltinPlugboard(file_name) : findBuiltinReflector(file_name);
+  if (wiring == nullptr) {
+    return false;
+  }
+  for (int i = 0; i < ALPHABET_LENGTH; i++) {
+    if (wiring->mapping[i] > i) {
+      out << i << " " << static_cast<int>(wiring->mapping[i]) << " ";
+    }
+  }
+  return true;
+}
+
+int readSettingText(int setting_kind, char const* file_name, string& text)
+{
+  ostringstream out;
+  if (isBuiltinName(file_name)) {
+    if (!writeBuiltinSetting(setting_kind, file_name, out)) {
+      cerr << "There is no built-in component " << file_name << endl;
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  } else {
+    ifstream in(file_name);
+    if (in.fail()) {
+      cerr << "Error opening configuration file " << file_name << endl;
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+    out << in.rdbuf();
+  }
+  text = out.str();
+  return NO_ERROR;
+}
+
+uint64_t countRotorOrders(uint64_t number_of_rotors, int number_of_slots)
+{
+  uint64_t number_of_orders = 1;
+  for (int i = 0; i < number_of_slots; i++) {
+    number_of_orders *= number_of_rotors - i;
+  }
+  return number_of_orders;
+}
+
+void getRotorOrder(uint64_t order, int number_of_rotors, int number_of_slots,
+		   int* rotor_indices)
+{
+  // The order is unranked one slot at a time: each choice for a slot is
+  // followed by every order of the remaining rotors in the later slots.
+  vector<int> unused_rotors(number_of_rotors);
+  for (size_t i = 0; i < unused_rotors.size(); i++) {
+    unused_rotors[i] = i;
+  }
+  for (int i = 0; i < number_of_slots; i++) {
+    uint64_t orders_per_choice = countRotorOrders(unused_rotors.size() - 1,
+						  number_of_slots - i - 1);
+    int choice = order / orders_per_choice;
+    order %= orders_per_choice;
+    rotor_indices[i] = unused_rotors[choice];
+    unused_rotors.erase(unused_rotors.begin() + choice);
+  }
+}
+
+int setUpFromSettingTexts(Enigma& enigma, string const& plugboard,
+			  char const* plugboard_name, string const& reflector,
+			  char const* reflector_name, string const* rotors,
+			  char const* const* rotor_names, int number_of_slots,
+			  int const* rotor_indices)
+{
+  string zero_positions;
+  for (int i = 0; i < number_of_slots; i++) {
+    zero_positions += "0 ";
+  }
+
+  vector<istringstream> settings;
+  settings.reserve(number_of_slots + 3);
+  settings.emplace_back(plugboard);
+  settings.emplace_back(reflector);
+  for (int i = 0; i < number_of_slots; i++) {
+    settings.emplace_back(rotors[rotor_indices[i]]);
+  }
+  settings.emplace_back(zero_positions);
+
+  vector<istream*> setting_pointers;
+  vector<char const*> setting_names;
+  setting_names.push_back(plugboard_name);
+  setting_names.push_back(reflector_name);
+  for (int i = 0; i < number_of_slots; i++) {
+    setting_names.push_back(rotor_names[rotor_indices[i]]);
+  }
+  setting_names.push_back("starting positions");
+  for (istringstream& setting : settings) {
+    setting_pointers.push_back(&setting);
+  }
+
+  return enigma.setUp(settings.size(), setting_pointers.data(),
+		      setting_names.data());
+}
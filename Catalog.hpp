@@ -0,0 +1,110 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+/* The catalog holds the standard components of the 26 letter machine,
+   the same as the files in the plugboards, reflectors and rotors
+   directories, compiled into the program. A file name of the form
+   builtin:NAME, such as builtin:I, names the catalog entry NAME of the
+   kind of component expected in its place, so a machine can be set up
+   without reading any files.
+   The entries are built by constexpr functions and checked with
+   static_assert when the program is compiled (see 'Catalog.cpp'), so a
+   mistake in the catalog stops the build rather than a machine.
+   Each rotor already holds its backward wiring and notch bitmask, so
+   setting one up is a copy. */
+
+#include "constants.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+template <int ALPHABET_SIZE>
+class BasicEnigma;
+typedef BasicEnigma<ALPHABET_LENGTH> Enigma;
+
+/* Prefix of the file names which name catalog entries. */
+#define BUILTIN_PREFIX "builtin:"
+
+/* Kinds of setting, by the position of their file in the arguments. */
+#define SETTING_PLUGBOARD  0
+#define SETTING_REFLECTOR  1
+#define SETTING_ROTOR      2
+#define SETTING_POSITIONS  3
+
+/* A rotor: its forward and backward wirings at position 0 and a bitmask
+   with the bit of each notch set. */
+struct BuiltinRotor
+{
+  char const* name;
+  std::uint8_t forward[ALPHABET_LENGTH];
+  std::uint8_t backward[ALPHABET_LENGTH];
+  std::uint64_t notch_mask;
+};
+
+/* A reflector or plugboard: the letter each letter is wired to. */
+struct BuiltinWiring
+{
+  char const* name;
+  std::uint8_t mapping[ALPHABET_LENGTH];
+};
+
+/* A set of rotor starting positions, as a string with one letter per
+   rotor from the leftmost rotor. */
+struct BuiltinPositions
+{
+  char const* name;
+  char const* letters;
+};
+
+/* Function to return true if file_name names a catalog entry. */
+bool isBuiltinName(char const* file_name);
+
+/* Functions to return the catalog entry named file_name, which must
+   start with BUILTIN_PREFIX, or nullptr if there is none. */
+BuiltinRotor const* findBuiltinRotor(char const* file_name);
+BuiltinWiring const* findBuiltinReflector(char const* file_name);
+BuiltinWiring const* findBuiltinPlugboard(char const* file_name);
+BuiltinPositions const* findBuiltinPositions(char const* file_name);
+
+/* Function to write the catalog entry named file_name for a setting of
+   kind setting_kind to out, laid out like its configuration file, so it
+   can be read wherever the text of a file is needed.
+   Returns false if there is no such entry. */
+bool writeBuiltinSetting(int setting_kind, char const* file_name,
+			 std::ostream& out);
+
+/* Function to set text to the text of the configuration file named
+   file_name, which holds a setting of kind setting_kind, or of the
+   catalog entry it names, so a setting can be read once and set up many
+   times.
+   The function returns an error code corresponding to those in 'errors.h' */
+int readSettingText(int setting_kind, char const* file_name,
+		    std::string& text);
+
+/* Function to return the number of ordered choices of number_of_slots
+   rotors out of number_of_rotors. */
+std::uint64_t countRotorOrders(std::uint64_t number_of_rotors,
+			       int number_of_slots);
+
+/* Function to fill rotor_indices with the rotor in each slot, from the
+   leftmost, of the rotor order accessed by order. The
+   countRotorOrders(number_of_rotors, number_of_slots) orders are
+   numbered in lexicographic order of the rotor indices, which is how key
+   searches and cycle catalogs number their settings. */
+void getRotorOrder(std::uint64_t order, int number_of_rotors,
+		   int number_of_slots, int* rotor_indices);
+
+/* Function to set up enigma at starting positions 0 from the texts of
+   its settings as readSettingText returns them: plugboard, reflector and
+   the number_of_slots rotors accessed by rotor_indices out of rotors.
+   Each text comes with the name used for it in error messages.
+   The function returns an error code corresponding to those in 'errors.h' */
+int setUpFromSettingTexts(Enigma& enigma, std::string const& plugboard,
+			  char const* plugboard_name,
+			  std::string const& reflector,
+			  char const* reflector_name,
+			  std::string const* rotors,
+			  char const* const* rotor_names,
+			  int number_of_slots, int const* rotor_indices);
+
+#endif
@@ -0,0 +1,203 @@
+/* This file contains the member function definitions
+   for the CribFilter class */
+
+#include "CribFilter.hpp"
+#include "Simd.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+CribFilter::CribFilter() :
+  mapping_(nullptr),
+  text_length_(0),
+  cribs_(),
+  crib_rows_(),
+  is_using_avx2_(hasAvx2()) {}
+
+CribFilter::~CribFilter()
+{
+  if (mapping_ != nullptr) {
+    munmap(mapping_, text_length_);
+  }
+}
+
+int CribFilter::setUp(char const* file_name)
+{
+  int fd = open(file_name, O_RDONLY);
+  struct stat status;
+  if (fd < 0 || fstat(fd, &status) != 0) {
+    cerr << "Error opening ciphertext file " << file_name << endl;
+    if (fd >= 0) {
+      close(fd);
+    }
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  // An empty file cannot be mapped, but has no offsets to filter anyway.
+  size_t size = status.st_size;
+  void* mapping = (size > 0)
+    ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    cerr << "Error mapping ciphertext file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  if (mapping != nullptr) {
+    madvise(mapping, size, MADV_SEQUENTIAL);
+  }
+
+  if (mapping_ != nullptr) {
+    munmap(mapping_, text_length_);
+  }
+  mapping_ = mapping;
+  text_length_ = size;
+
+  return NO_ERROR;
+}
+
+int CribFilter::addCrib(char const* crib)
+{
+  if (*crib == '\0') {
+    cerr << "A crib must not be empty" << endl;
+    return INVALID_ARGUMENT;
+  }
+  cribs_.push_back(crib);
+  vector<CribRow> rows(cribs_.back().size());
+  for (size_t j = 0; j < rows.size(); j++) {
+    memset(rows[j].symbols, cribs_.back()[j], SIMD_BLOCK_LENGTH);
+  }
+  crib_rows_.push_back(rows);
+
+  return NO_ERROR;
+}
+
+int CribFilter::getNumberOfCribs() const
+{
+  return cribs_.size();
+}
+
+string const& CribFilter::getCrib(int crib_index) const
+{
+  return cribs_[crib_index];
+}
+
+uint64_t CribFilter::getLength() const
+{
+  return text_length_;
+}
+
+void CribFilter::findOffsets(uint64_t first_offset, uint64_t last_offset,
+			     vector<CribOffset>& offsets) const
+{
+  offsets.clear();
+  int number_of_cribs = cribs_.size();
+  vector<uint32_t> survivors(number_of_cribs);
+  uint64_t vector_end = getVectorEnd(first_offset, last_offset);
+  uint64_t offset = first_offset;
+  for (; offset < vector_end; offset += SIMD_BLOCK_LENGTH) {
+    uint32_t any_survivors = findBlockSurvivors(offset, survivors.data());
+    while (any_survivors != 0) {
+      int bit = __builtin_ctz(any_survivors);
+      any_survivors &= any_survivors - 1;
+      for (int i = 0; i < number_of_cribs; i++) {
+	if ((survivors[i] >> bit) & 1) {
+	  offsets.push_back({offset + bit, i});
+	}
+      }
+    }
+  }
+
+  for (; offset < last_offset; offset++) {
+    for (int i = 0; i < number_of_cribs; i++) {
+      if (isPossible(i, offset)) {
+	offsets.push_back({offset, i});
+      }
+    }
+  }
+}
+
+void CribFilter::countOffsets(uint64_t first_offset, uint64_t last_offset,
+			      uint64_t* counts) const
+{
+  int number_of_cribs = cribs_.size();
+  vector<uint32_t> survivors(number_of_cribs);
+  uint64_t vector_end = getVectorEnd(first_offset, last_offset);
+  uint64_t offset = first_offset;
+  for (; offset < vector_end; offset += SIMD_BLOCK_LENGTH) {
+    findBlockSurvivors(offset, survivors.data());
+    for (int i = 0; i < number_of_cribs; i++) {
+      counts[i] += __builtin_popcount(survivors[i]);
+    }
+  }
+
+  for (; offset < last_offset; offset++) {
+    for (int i = 0; i < number_of_cribs; i++) {
+      counts[i] += isPossible(i, offset);
+    }
+  }
+}
+
+uint64_t CribFilter::getVectorEnd(uint64_t first_offset,
+				  uint64_t last_offset) const
+{
+  // Whole blocks are tested with vectors while every crib can be read at
+  // every offset in them; the offsets after them, where the shorter cribs
+  // may still fit, are tested one at a time.
+  size_t longest_crib = 0;
+  for (string const& crib : cribs_) {
+    longest_crib = max(longest_crib, crib.size());
+  }
+  if (!is_using_avx2_ || cribs_.empty()
+      || text_length_ < SIMD_BLOCK_LENGTH + longest_crib - 1) {
+    return first_offset;
+  }
+
+  uint64_t last_block_start = text_length_ - SIMD_BLOCK_LENGTH
+    - (longest_crib - 1);
+  uint64_t vector_end = min(last_offset, last_block_start + 1);
+  if (vector_end <= first_offset) {
+    return first_offset;
+  }
+  return vector_end - (vector_end - first_offset) % SIMD_BLOCK_LENGTH;
+}
+
+uint32_t CribFilter::findBlockSurvivors(uint64_t offset,
+					uint32_t* survivors) const
+{
+  uint8_t const* text = static_cast<uint8_t const*>(mapping_) + offset;
+  uint32_t any_survivors = 0;
+  for (size_t i = 0; i < cribs_.size(); i++) {
+    survivors[i] = ~findCribClashesAvx2(text, &crib_rows_[i][0].symbols,
+					crib_rows_[i].size());
+    any_survivors |= survivors[i];
+  }
+  return any_survivors;
+}
+
+bool CribFilter::isPossible(int crib_index, uint64_t offset) const
+{
+  string const& crib = cribs_[crib_index];
+  if (offset + crib.size() > text_length_) {
+    return false;
+  }
+
+  char const* text = static_cast<char const*>(mapping_) + offset;
+  for (size_t j = 0; j < crib.size(); j++) {
+    if (text[j] == crib[j]) {
+      return false;
+    }
+  }
+  return true;
+}
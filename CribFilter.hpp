@@ -0,0 +1,110 @@
+#ifndef CRIB_FILTER_H
+#define CRIB_FILTER_H
+
+/* The CribFilter class drags cribs across a ciphertext to find where
+   they could sit. The machine never codes a symbol as itself, so a crib
+   cannot start at an offset where any of its symbols is the same as the
+   ciphertext symbol under it; the offsets left are the ones worth
+   handing to key recovery.
+   The ciphertext file is mapped into memory and read as it is, one
+   symbol per byte, so it should hold the ciphertext without whitespace,
+   as enigma writes it, and offsets count bytes from its start. The
+   offsets are tested SIMD_BLOCK_LENGTH at a time with vector byte
+   compares on processors which support AVX2, every crib over the same
+   stretch of ciphertext while it is still in the cache, so very long
+   intercepts are filtered at about the speed they can be read.
+   mapping_ and text_length_ describe the mapped ciphertext.
+   cribs_ contains the cribs, and crib_rows_ the rows of each crib as
+   the vector compares take them (see findCribClashesAvx2).
+   is_using_avx2_ is true if the vector compares are used. */
+
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* A crib position which is not ruled out: the crib accessed by
+   crib_index may start offset bytes into the ciphertext. */
+struct CribOffset
+{
+  std::uint64_t offset;
+  int crib_index;
+};
+
+class CribFilter
+{
+public:
+  /* Function to initialise a CribFilter with no ciphertext or cribs. */
+  CribFilter();
+
+  /* Destructor, which unmaps the ciphertext. */
+  ~CribFilter();
+
+  CribFilter(CribFilter const&) = delete;
+  CribFilter& operator=(CribFilter const&) = delete;
+
+  /* Function to map the ciphertext file named file_name into memory.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int setUp(char const* file_name);
+
+  /* Function to add a crib, which must not be empty.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int addCrib(char const* crib);
+
+  /* Function to return the number of cribs. */
+  int getNumberOfCribs() const;
+
+  /* Function to return the crib accessed by index. */
+  std::string const& getCrib(int crib_index) const;
+
+  /* Function to return the length of the ciphertext. */
+  std::uint64_t getLength() const;
+
+  /* Function to fill offsets with the crib positions starting from
+     first_offset up to but not including last_offset which are not ruled
+     out, in ascending order of offset and then of crib. A crib must fit
+     in the ciphertext. */
+  void findOffsets(std::uint64_t first_offset, std::uint64_t last_offset,
+		   std::vector<CribOffset>& offsets) const;
+
+  /* Function to add the number of crib positions starting from
+     first_offset up to but not including last_offset which are not ruled
+     out to counts[i] for each crib i, without listing them. */
+  void countOffsets(std::uint64_t first_offset, std::uint64_t last_offset,
+		    std::uint64_t* counts) const;
+
+private:
+  /* One symbol of a crib repeated across a vector register. */
+  struct alignas(SIMD_BLOCK_LENGTH) CribRow
+  {
+    std::uint8_t symbols[SIMD_BLOCK_LENGTH];
+  };
+
+  void* mapping_;
+  std::uint64_t text_length_;
+  std::vector<std::string> cribs_;
+  std::vector<std::vector<CribRow>> crib_rows_;
+  bool is_using_avx2_;
+
+  /* Function to return the end of the whole blocks of SIMD_BLOCK_LENGTH
+     offsets from first_offset, before last_offset, at which every crib
+     can be read, so they can be tested with vectors. */
+  std::uint64_t getVectorEnd(std::uint64_t first_offset,
+			     std::uint64_t last_offset) const;
+
+  /* Function to test the SIMD_BLOCK_LENGTH offsets from offset with
+     vectors, setting survivors[i] to a mask with a bit set for each
+     offset at which crib i is not ruled out. Returns the union of the
+     masks. */
+  std::uint32_t findBlockSurvivors(std::uint64_t offset,
+				   std::uint32_t* survivors) const;
+
+  /* Function to return true if the crib accessed by index can start
+     offset bytes into the ciphertext, testing the offset on its own. */
+  bool isPossible(int crib_index, std::uint64_t offset) const;
+};
+
+#endif
@@ -0,0 +1,270 @@
+/* This file contains the member function definitions
+   for the CribIndex class */
+
+#include "CribIndex.hpp"
+#include "Enigma.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+  /* Header at the start of an index file. */
+  struct IndexHeader
+  {
+    char magic[8];
+    uint32_t alphabet_size;
+    uint32_t number_of_rotors;
+    uint32_t number_of_keystrokes;
+    uint32_t reserved;
+    uint64_t number_of_positions;
+  };
+
+  const char INDEX_MAGIC[8] = {'E', 'N', 'I', 'G', 'C', 'I', 'X', '1'};
+}
+
+CribIndex::CribIndex() :
+  mapping_(nullptr),
+  mapping_size_(0),
+  offsets_(nullptr),
+  entries_(nullptr),
+  number_of_rotors_(0),
+  number_of_keystrokes_(0) {}
+
+CribIndex::~CribIndex()
+{
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+int CribIndex::write(Enigma& enigma, int number_of_keystrokes,
+		     char const* file_name)
+{
+  int number_of_rotors = enigma.getNumberOfRotors();
+  uint64_t number_of_positions = 1;
+  for (int i = 0; i < number_of_rotors; i++) {
+    number_of_positions *= ALPHABET_LENGTH;
+    if (number_of_positions > UINT32_MAX) {
+      cerr << "Too many starting positions to index " << number_of_rotors;
+      cerr << " rotors" << endl;
+      return INVALID_ARGUMENT;
+    }
+  }
+
+  // Starting positions are visited in increasing order, so every list
+  // comes out sorted.
+  vector<vector<uint32_t>> lists(getListIndex(number_of_keystrokes, 0, 0));
+  vector<int> rotor_positions(number_of_rotors);
+  for (uint32_t position = 0; position < number_of_positions; position++) {
+    uint32_t remaining = position;
+    for (int i = number_of_rotors - 1; i >= 0; i--) {
+      rotor_positions[i] = remaining % ALPHABET_LENGTH;
+      remaining /= ALPHABET_LENGTH;
+    }
+    enigma.setPositions(rotor_positions.data());
+
+    for (int keystroke = 0; keystroke < number_of_keystrokes; keystroke++) {
+      enigma.advance(1);
+      for (int letter = 0; letter < ALPHABET_LENGTH; letter++) {
+	int coded_letter = enigma.codeSignalPath(letter);
+	if (letter < coded_letter) {
+	  lists[getListIndex(keystroke, letter, coded_letter)]
+	    .push_back(position);
+	}
+      }
+    }
+  }
+
+  ofstream out(file_name, ios::binary);
+  if (out.fail()) {
+    cerr << "Error opening crib index file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  IndexHeader header = {};
+  memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header.alphabet_size = ALPHABET_LENGTH;
+  header.number_of_rotors = number_of_rotors;
+  header.number_of_keystrokes = number_of_keystrokes;
+  header.number_of_positions = number_of_positions;
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+  uint64_t offset = 0;
+  for (size_t i = 0; i <= lists.size(); i++) {
+    out.write(reinterpret_cast<char const*>(&offset), sizeof(offset));
+    if (i < lists.size()) {
+      offset += lists[i].size();
+    }
+  }
+  for (size_t i = 0; i < lists.size(); i++) {
+    out.write(reinterpret_cast<char const*>(lists[i].data()),
+	      lists[i].size() * sizeof(uint32_t));
+  }
+
+  if (!out) {
+    cerr << "Error writing crib index file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  return NO_ERROR;
+}
+
+int CribIndex::setUp(char const* file_name)
+{
+  int fd = open(file_name, O_RDONLY);
+  struct stat status;
+  if (fd < 0 || fstat(fd, &status) != 0) {
+    cerr << "Error opening crib index file " << file_name << endl;
+    if (fd >= 0) {
+      close(fd);
+    }
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  size_t size = status.st_size;
+  void* mapping = (size >= sizeof(IndexHeader))
+    ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+
+  IndexHeader const* header = static_cast<IndexHeader const*>(mapping);
+  if (mapping == MAP_FAILED ||
+      memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+      header->alphabet_size != ALPHABET_LENGTH) {
+    cerr << file_name << " is not a crib index file" << endl;
+    if (mapping != MAP_FAILED) {
+      munmap(mapping, size);
+    }
+    return INVALID_ARGUMENT;
+  }
+
+  // The whole offset table must lie inside the file, and its offsets must
+  // never decrease and stay inside the lists, so every list found by a
+  // lookup lies inside the file.
+  uint64_t number_of_offsets =
+    static_cast<uint64_t>(header->number_of_keystrokes)
+    * ALPHABET_LENGTH * ALPHABET_LENGTH + 1;
+  uint64_t const* offsets = reinterpret_cast<uint64_t const*>(header + 1);
+  bool is_complete = (number_of_offsets <=
+		      (size - sizeof(IndexHeader)) / sizeof(uint64_t));
+  size_t entries_start = is_complete
+    ? sizeof(IndexHeader) + number_of_offsets * sizeof(uint64_t) : size;
+  uint64_t number_of_entries = (size - entries_start) / sizeof(uint32_t);
+  bool is_valid = is_complete;
+  for (uint64_t i = 0; is_valid && i < number_of_offsets; i++) {
+    is_valid = (offsets[i] <= number_of_entries &&
+		(i == 0 || offsets[i - 1] <= offsets[i]));
+  }
+  if (!is_valid) {
+    cerr << "Crib index file " << file_name;
+    cerr << (is_complete ? " is corrupt" : " is truncated") << endl;
+    munmap(mapping, size);
+    return INVALID_ARGUMENT;
+  }
+
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = mapping;
+  mapping_size_ = size;
+  offsets_ = offsets;
+  entries_ = reinterpret_cast<uint32_t const*>(
+      static_cast<char const*>(mapping) + entries_start);
+  number_of_rotors_ = header->number_of_rotors;
+  number_of_keystrokes_ = header->number_of_keystrokes;
+
+  return NO_ERROR;
+}
+
+int CribIndex::getNumberOfRotors() const
+{
+  return number_of_rotors_;
+}
+
+int CribIndex::getNumberOfKeystrokes() const
+{
+  return number_of_keystrokes_;
+}
+
+int CribIndex::findPositions(char const* plaintext, char const* ciphertext,
+			     vector<uint32_t>& positions) const
+{
+  positions.clear();
+
+  // Each crib letter selects one list; they are intersected starting
+  // from the shortest, so the work depends on the number of candidates
+  // rather than on the size of the index.
+  vector<pair<uint32_t const*, uint32_t const*>> lists;
+  for (int keystroke = 0; keystroke < number_of_keystrokes_ &&
+	 plaintext[keystroke] && ciphertext[keystroke]; keystroke++) {
+    int plain_letter = plaintext[keystroke] - ASCII_A;
+    int cipher_letter = ciphertext[keystroke] - ASCII_A;
+    if (plain_letter < A_INDEX || plain_letter > Z_INDEX ||
+	cipher_letter < A_INDEX || cipher_letter > Z_INDEX) {
+      cerr << "Crib letters must be upper case letters A-Z" << endl;
+      return INVALID_INPUT_CHARACTER;
+    }
+    if (plain_letter == cipher_letter) {
+      // The machine never codes a letter as itself.
+      return NO_ERROR;
+    }
+
+    size_t list_index = getListIndex(keystroke,
+				     min(plain_letter, cipher_letter),
+				     max(plain_letter, cipher_letter));
+    lists.push_back(make_pair(entries_ + offsets_[list_index],
+			      entries_ + offsets_[list_index + 1]));
+  }
+
+  if (lists.empty()) {
+    cerr << "The crib must contain at least one letter" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  sort(lists.begin(), lists.end(),
+       [](pair<uint32_t const*, uint32_t const*> const& first,
+	  pair<uint32_t const*, uint32_t const*> const& second) {
+	 return first.second - first.first < second.second - second.first;
+       });
+
+  positions.assign(lists[0].first, lists[0].second);
+  for (size_t i = 1; i < lists.size() && !positions.empty(); i++) {
+    size_t kept = 0;
+    uint32_t const* search_start = lists[i].first;
+    for (size_t j = 0; j < positions.size(); j++) {
+      search_start = lower_bound(search_start, lists[i].second, positions[j]);
+      if (search_start != lists[i].second && *search_start == positions[j]) {
+	positions[kept++] = positions[j];
+      }
+    }
+    positions.resize(kept);
+  }
+
+  return NO_ERROR;
+}
+
+void CribIndex::getRotorPositions(uint32_t position,
+				  int* rotor_positions) const
+{
+  for (int i = number_of_rotors_ - 1; i >= 0; i--) {
+    rotor_positions[i] = position % ALPHABET_LENGTH;
+    position /= ALPHABET_LENGTH;
+  }
+}
+
+size_t CribIndex::getListIndex(int keystroke, int first_letter,
+			       int second_letter)
+{
+  return (static_cast<size_t>(keystroke) * ALPHABET_LENGTH + first_letter)
+    * ALPHABET_LENGTH + second_letter;
+}
@@ -0,0 +1,94 @@
+#ifndef CRIB_INDEX_H
+#define CRIB_INDEX_H
+
+/* The CribIndex class looks up the rotor starting positions which are
+   consistent with a crib: a stretch of known plaintext at the start of a
+   message together with its ciphertext.
+   The index is built once for a plugboard, reflector and rotor order by
+   running the machine from every starting position and recording, for
+   each of the first number_of_keystrokes keystrokes, which pair of
+   letters the machine swaps. A crib letter p coded as c on keystroke j
+   then rules out every starting position missing from the list for
+   keystroke j and the pair {p, c}, so the candidates are the
+   intersection of one sorted list per crib letter.
+   The index file is laid out so it can be mapped straight into memory:
+     a header (see IndexHeader in 'CribIndex.cpp'),
+     an offset table of number_of_keystrokes * 26 * 26 + 1 64 bit entry
+     numbers, where the list for keystroke j and letters a < b runs from
+     entry offset[(j * 26 + a) * 26 + b] to the next offset, and
+     the lists themselves, as ascending 32 bit starting position numbers.
+   A starting position number is the rotor positions read as a base 26
+   number with the leftmost rotor as the most significant digit.
+   mapping_ and mapping_size_ describe the mapped index file.
+   offsets_ and entries_ point to the offset table and the lists inside
+   it.
+   number_of_rotors_ and number_of_keystrokes_ are taken from the file
+   header. Only the 26 letter alphabet is supported, because the index
+   grows with the number of starting positions. */
+
+#include "Enigma.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CribIndex
+{
+public:
+  /* Function to initialise an empty CribIndex object. */
+  CribIndex();
+
+  /* Destructor, which unmaps the index file. */
+  ~CribIndex();
+
+  CribIndex(CribIndex const&) = delete;
+  CribIndex& operator=(CribIndex const&) = delete;
+
+  /* Function to build the index for enigma, which must be set up, from
+     its first number_of_keystrokes keystrokes, and write it to the file
+     named file_name. The rotor positions of enigma are changed.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  static int write(Enigma& enigma, int number_of_keystrokes,
+		   char const* file_name);
+
+  /* Function to map the index file named file_name into memory.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int setUp(char const* file_name);
+
+  /* Function to return the number of rotors of the indexed machine. */
+  int getNumberOfRotors() const;
+
+  /* Function to return the number of keystrokes covered by the index,
+     which is the longest crib that can be used. */
+  int getNumberOfKeystrokes() const;
+
+  /* Function to fill positions with the numbers of the starting
+     positions which code plaintext as ciphertext. Both are strings of
+     upper case letters; only the first getNumberOfKeystrokes() letters
+     of the shorter one are used.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int findPositions(char const* plaintext, char const* ciphertext,
+		    std::vector<std::uint32_t>& positions) const;
+
+  /* Function to fill rotor_positions with the position of each rotor,
+     from the leftmost to the rightmost, for a starting position
+     number. */
+  void getRotorPositions(std::uint32_t position, int* rotor_positions) const;
+
+private:
+  void* mapping_;
+  std::size_t mapping_size_;
+  std::uint64_t const* offsets_;
+  std::uint32_t const* entries_;
+  int number_of_rotors_;
+  int number_of_keystrokes_;
+
+  /* Function to return the position in the offset table of the list for
+     the pair of letter indices on the keystroke accessed by index. */
+  static std::size_t getListIndex(int keystroke, int first_letter,
+				  int second_letter);
+};
+
+#endif
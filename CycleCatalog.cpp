@@ -0,0 +1,636 @@
+/* This file contains the member function definitions
+   for the CycleCatalog class */
+
+#include "CycleCatalog.hpp"
+#include "Enigma.hpp"
+#include "Wiring.hpp"
+#include "Catalog.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+  /* Header at the start of a catalog file. */
+  struct CatalogHeader
+  {
+    char magic[8];
+    uint32_t alphabet_size;
+    uint32_t number_of_rotors;
+    uint32_t number_of_slots;
+    uint32_t is_double_stepping;
+    uint64_t names_size;
+    uint64_t number_of_settings;
+    uint64_t number_of_signatures;
+  };
+
+  const char CATALOG_MAGIC[8] = {'E', 'N', 'I', 'G', 'C', 'Y', 'C', '1'};
+
+  /* Number of bits of a signature taken by the cycle lengths of one
+     product: one for each place a pair of cycles could end (see
+     encodeCycleLengths). */
+  const int PRODUCT_BITS = ALPHABET_LENGTH / 2 - 1;
+
+  /* The settings of the machines built from one reflector and set of
+     rotors, shared by every thread of a build. */
+  struct CatalogMachines
+  {
+    string reflector;
+    char const* reflector_name;
+    vector<string> rotors;
+    char const* const* rotor_names;
+    int number_of_slots;
+    bool is_double_stepping;
+  };
+
+  /* Function to set up enigma with the reflector of machines and the
+     rotors accessed by rotor_indices, without a plugboard, which only
+     relabels the letters of the cycles.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int setUpMachine(Enigma& enigma, CatalogMachines const& machines,
+		   int const* rotor_indices)
+  {
+    enigma.setDoubleStepping(machines.is_double_stepping);
+    return setUpFromSettingTexts(enigma, "", "empty plugboard",
+				 machines.reflector, machines.reflector_name,
+				 machines.rotors.data(), machines.rotor_names,
+				 machines.number_of_slots, rotor_indices);
+  }
+
+  /* Function to set signatures[s] to the signature of each setting s
+     from first_setting up to but not including last_setting, run by
+     each thread of a build. error_code is set to an error code
+     corresponding to those in 'errors.h' */
+  void catalogueSettings(CatalogMachines const& machines,
+			 uint32_t first_setting, uint32_t last_setting,
+			 uint64_t* signatures, int& error_code)
+  {
+    int number_of_slots = machines.number_of_slots;
+    uint32_t number_of_positions = 1;
+    for (int i = 0; i < number_of_slots; i++) {
+      number_of_positions *= ALPHABET_LENGTH;
+    }
+
+    auto enigma = Enigma();
+    vector<int> rotor_indices(number_of_slots);
+    vector<int> positions(number_of_slots);
+    Wiring permutations[INDICATOR_LENGTH];
+    Wiring products[INDICATOR_LENGTH / 2];
+    uint32_t order = UINT32_MAX;
+    error_code = NO_ERROR;
+    for (uint32_t setting = first_setting; setting < last_setting;
+	 setting++) {
+      // Consecutive settings share a machine until the positions wrap.
+      if (setting / number_of_positions != order) {
+	order = setting / number_of_positions;
+	getRotorOrder(order, machines.rotors.size(), number_of_slots,
+		      rotor_indices.data());
+	error_code = setUpMachine(enigma, machines, rotor_indices.data());
+	if (error_code != NO_ERROR) {
+	  return;
+	}
+      }
+
+      uint32_t remaining = setting % number_of_positions;
+      for (int i = number_of_slots - 1; i >= 0; i--) {
+	positions[i] = remaining % ALPHABET_LENGTH;
+	remaining /= ALPHABET_LENGTH;
+      }
+      enigma.setPositions(positions.data());
+
+      for (int keystroke = 0; keystroke < INDICATOR_LENGTH; keystroke++) {
+	enigma.advance(1);
+	for (int letter = 0; letter < ALPHABET_LENGTH; letter++) {
+	  permutations[keystroke].setOutputLetter(
+	      letter, enigma.codeSignalPath(letter));
+	}
+      }
+      for (int i = 0; i < INDICATOR_LENGTH / 2; i++) {
+	products[i].setComposition(permutations[i],
+				   permutations[i + INDICATOR_LENGTH / 2]);
+      }
+      // Every keystroke pairs the letters through the reflector, and the
+      // cycles of a product of two such pairings always pair up, so this
+      // only fails for a reflector which does not pair every letter.
+      if (!CycleCatalog::getSignature(products, signatures[setting])) {
+	cerr << "The reflector " << machines.reflector_name << " does not";
+	cerr << " pair every letter" << endl;
+	error_code = INVALID_ARGUMENT;
+	return;
+      }
+    }
+  }
+
+  /* Function to set code to the bits of a signature for the cycle
+     lengths in cycle_lengths. The lengths must come in equal pairs, so
+     only one of each pair is kept; in descending order they split the
+     ALPHABET_LENGTH / 2 letters they cover, and a bit is set for every
+     place a length ends before the last.
+     Returns false if the lengths do not pair up or do not add up to
+     ALPHABET_LENGTH. */
+  bool encodeCycleLengths(vector<int> cycle_lengths, uint64_t& code)
+  {
+    sort(cycle_lengths.begin(), cycle_lengths.end(), greater<int>());
+    if (cycle_lengths.size() % 2 != 0) {
+      return false;
+    }
+
+    code = 0;
+    int covered = 0;
+    for (size_t i = 0; i < cycle_lengths.size(); i += 2) {
+      if (cycle_lengths[i] <= 0 || cycle_lengths[i] != cycle_lengths[i + 1]) {
+	return false;
+      }
+      covered += cycle_lengths[i];
+      if (covered < ALPHABET_LENGTH / 2) {
+	code |= uint64_t(1) << (covered - 1);
+      }
+    }
+    return covered == ALPHABET_LENGTH / 2;
+  }
+  /* Function to check that the catalog file of size bytes starting with
+     header is whole and consistent, so that lookups stay inside it, and
+     to fill names with its reflector and rotor names.
+     Returns false if it is not. */
+  bool checkCatalog(CatalogHeader const* header, size_t size,
+		    vector<char const*>& names)
+  {
+    // The number of settings must be the one the rotors and slots give,
+    // which also keeps it within the 32 bit setting numbers.
+    if (header->number_of_slots < 1
+	|| header->number_of_slots > header->number_of_rotors) {
+      return false;
+    }
+    uint64_t number_of_settings = 1;
+    for (uint32_t i = 0; i < header->number_of_slots; i++) {
+      number_of_settings *= header->number_of_rotors - i;
+      if (number_of_settings > UINT32_MAX) {
+	return false;
+      }
+      number_of_settings *= ALPHABET_LENGTH;
+      if (number_of_settings > UINT32_MAX) {
+	return false;
+      }
+    }
+    if (header->number_of_settings != number_of_settings) {
+      return false;
+    }
+
+    // The file must hold exactly the names, the table and the settings.
+    size_t names_size = header->names_size;
+    size_t table_entries = header->number_of_signatures + 1;
+    if (names_size > size - sizeof(CatalogHeader) || names_size % 8 != 0
+	|| table_entries > (size - sizeof(CatalogHeader) - names_size)
+	  / (2 * sizeof(uint64_t))
+	|| size - sizeof(CatalogHeader) - names_size
+	  - table_entries * 2 * sizeof(uint64_t)
+	  != number_of_settings * sizeof(uint32_t)) {
+      return false;
+    }
+
+    char const* first_name = reinterpret_cast<char const*>(header + 1);
+    char const* names_end = first_name + names_size;
+    names.clear();
+    for (uint32_t i = 0; i <= header->number_of_rotors; i++) {
+      char const* name = (i == 0) ? first_name
+	: names.back() + strlen(names.back()) + 1;
+      if (name >= names_end
+	  || memchr(name, '\0', names_end - name) == nullptr) {
+	return false;
+      }
+      names.push_back(name);
+    }
+
+    // Lookups search the signatures and index the settings through the
+    // first setting numbers, so the signatures must ascend and the
+    // numbers run from 0 to the number of settings without going back.
+    uint64_t const* table = reinterpret_cast<uint64_t const*>(names_end);
+    for (size_t i = 0; i < table_entries; i++) {
+      uint64_t signature = table[2 * i];
+      uint64_t first_setting = table[2 * i + 1];
+      if ((i == 0) ? first_setting != 0
+	  : (signature <= table[2 * i - 2] || first_setting < table[2 * i - 1]
+	     || first_setting > number_of_settings)) {
+	return false;
+      }
+    }
+    return table[2 * table_entries - 1] == number_of_settings;
+  }
+}
+
+CycleCatalog::CycleCatalog() :
+  mapping_(nullptr),
+  mapping_size_(0),
+  names_(),
+  signatures_(nullptr),
+  settings_(nullptr),
+  number_of_rotors_(0),
+  number_of_slots_(0),
+  number_of_signatures_(0),
+  number_of_settings_(0) {}
+
+CycleCatalog::~CycleCatalog()
+{
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+int CycleCatalog::write(char const* reflector_file_name,
+			int number_of_rotors,
+			char const* const* rotor_file_names,
+			int number_of_slots, bool is_double_stepping,
+			int number_of_threads, char const* file_name)
+{
+  if (number_of_slots < 1 || number_of_slots > number_of_rotors) {
+    cerr << "A catalog needs between 1 and " << number_of_rotors;
+    cerr << " rotors in the machine" << endl;
+    return INVALID_ARGUMENT;
+  }
+  if (number_of_threads < 1) {
+    cerr << "A catalog must be built with at least one thread" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  uint64_t number_of_orders = countRotorOrders(number_of_rotors,
+					       number_of_slots);
+  uint64_t number_of_settings = number_of_orders;
+  for (int i = 0; i < number_of_slots; i++) {
+    number_of_settings *= ALPHABET_LENGTH;
+    if (number_of_settings > UINT32_MAX) {
+      cerr << "Too many settings to catalogue " << number_of_slots;
+      cerr << " out of " << number_of_rotors << " rotors" << endl;
+      return INVALID_ARGUMENT;
+    }
+  }
+
+  // Every file is read once and every rotor order set up once here, so
+  // a mistake in a file is reported once rather than by every thread.
+  CatalogMachines machines;
+  machines.reflector_name = reflector_file_name;
+  machines.rotors.resize(number_of_rotors);
+  machines.rotor_names = rotor_file_names;
+  machines.number_of_slots = number_of_slots;
+  machines.is_double_stepping = is_double_stepping;
+  int error_code = readSettingText(SETTING_REFLECTOR, reflector_file_name,
+				   machines.reflector);
+  for (int i = 0; i < number_of_rotors && error_code == NO_ERROR; i++) {
+    error_code = readSettingText(SETTING_ROTOR, rotor_file_names[i],
+				 machines.rotors[i]);
+  }
+  vector<int> rotor_indices(number_of_slots);
+  for (uint64_t order = 0; order < number_of_orders &&
+	 error_code == NO_ERROR; order++) {
+    auto enigma = Enigma();
+    getRotorOrder(order, number_of_rotors, number_of_slots,
+		  rotor_indices.data());
+    error_code = setUpMachine(enigma, machines, rotor_indices.data());
+  }
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  // The settings are split into one contiguous range per thread, and
+  // each thread writes only the signatures of its own range.
+  number_of_threads = min<uint64_t>(number_of_threads, number_of_settings);
+  vector<uint64_t> signatures(number_of_settings);
+  vector<int> thread_errors(number_of_threads);
+  vector<thread> threads;
+  for (int i = 0; i < number_of_threads; i++) {
+    uint32_t first_setting = number_of_settings * i / number_of_threads;
+    uint32_t last_setting = number_of_settings * (i + 1) / number_of_threads;
+    threads.emplace_back(catalogueSettings, cref(machines), first_setting,
+			 last_setting, signatures.data(),
+			 ref(thread_errors[i]));
+  }
+  for (int i = 0; i < number_of_threads; i++) {
+    threads[i].join();
+    if (error_code == NO_ERROR) {
+      error_code = thread_errors[i];
+    }
+  }
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  // A stable sort keeps the settings of each signature in ascending
+  // order.
+  vector<uint32_t> settings(number_of_settings);
+  iota(settings.begin(), settings.end(), 0);
+  stable_sort(settings.begin(), settings.end(),
+	      [&signatures](uint32_t first, uint32_t second) {
+		return signatures[first] < signatures[second];
+	      });
+
+  string names(reflector_file_name);
+  names += '\0';
+  for (int i = 0; i < number_of_rotors; i++) {
+    names += rotor_file_names[i];
+    names += '\0';
+  }
+  names.resize((names.size() + 7) / 8 * 8, '\0');
+
+  vector<uint64_t> table;
+  for (uint64_t i = 0; i < number_of_settings; i++) {
+    uint64_t signature = signatures[settings[i]];
+    if (i == 0 || signature != table[table.size() - 2]) {
+      table.push_back(signature);
+      table.push_back(i);
+    }
+  }
+  uint64_t number_of_signatures = table.size() / 2;
+  table.push_back(UINT64_MAX);
+  table.push_back(number_of_settings);
+
+  ofstream out(file_name, ios::binary);
+  if (out.fail()) {
+    cerr << "Error opening cycle catalog file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  CatalogHeader header = {};
+  memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+  header.alphabet_size = ALPHABET_LENGTH;
+  header.number_of_rotors = number_of_rotors;
+  header.number_of_slots = number_of_slots;
+  header.is_double_stepping = is_double_stepping;
+  header.names_size = names.size();
+  header.number_of_settings = number_of_settings;
+  header.number_of_signatures = number_of_signatures;
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  out.write(names.data(), names.size());
+  out.write(reinterpret_cast<char const*>(table.data()),
+	    table.size() * sizeof(uint64_t));
+  out.write(reinterpret_cast<char const*>(settings.data()),
+	    settings.size() * sizeof(uint32_t));
+
+  if (!out) {
+    cerr << "Error writing cycle catalog file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  return NO_ERROR;
+}
+
+int CycleCatalog::setUp(char const* file_name)
+{
+  int fd = open(file_name, O_RDONLY);
+  struct stat status;
+  if (fd < 0 || fstat(fd, &status) != 0) {
+    cerr << "Error opening cycle catalog file " << file_name << endl;
+    if (fd >= 0) {
+      close(fd);
+    }
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  size_t size = status.st_size;
+  void* mapping = (size >= sizeof(CatalogHeader))
+    ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+
+  CatalogHeader const* header = static_cast<CatalogHeader const*>(mapping);
+  if (mapping == MAP_FAILED ||
+      memcmp(header->magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0 ||
+      header->alphabet_size != ALPHABET_LENGTH) {
+    cerr << file_name << " is not a cycle catalog file" << endl;
+    if (mapping != MAP_FAILED) {
+      munmap(mapping, size);
+    }
+    return INVALID_ARGUMENT;
+  }
+
+  vector<char const*> name_pointers;
+  bool is_complete = checkCatalog(header, size, name_pointers);
+  if (!is_complete) {
+    cerr << "Cycle catalog file " << file_name << " is truncated or corrupt";
+    cerr << endl;
+    munmap(mapping, size);
+    return INVALID_ARGUMENT;
+  }
+
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = mapping;
+  mapping_size_ = size;
+  names_ = name_pointers;
+  signatures_ = reinterpret_cast<uint64_t const*>(
+      name_pointers[0] + header->names_size);
+  settings_ = reinterpret_cast<uint32_t const*>(
+      signatures_ + 2 * (header->number_of_signatures + 1));
+  number_of_rotors_ = header->number_of_rotors;
+  number_of_slots_ = header->number_of_slots;
+  number_of_signatures_ = header->number_of_signatures;
+  number_of_settings_ = header->number_of_settings;
+
+  return NO_ERROR;
+}
+
+int CycleCatalog::getNumberOfSlots() const
+{
+  return number_of_slots_;
+}
+
+char const* CycleCatalog::getReflectorName() const
+{
+  return names_[0];
+}
+
+char const* CycleCatalog::getRotorName(int rotor_index) const
+{
+  return names_[rotor_index + 1];
+}
+
+void CycleCatalog::findSettings(uint64_t signature,
+				vector<uint32_t>& settings) const
+{
+  settings.clear();
+
+  uint64_t low = 0;
+  uint64_t high = number_of_signatures_;
+  while (low < high) {
+    uint64_t middle = low + (high - low) / 2;
+    if (signatures_[2 * middle] < signature) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low < number_of_signatures_ && signatures_[2 * low] == signature) {
+    settings.assign(settings_ + signatures_[2 * low + 1],
+		    settings_ + signatures_[2 * low + 3]);
+  }
+}
+
+bool CycleCatalog::getSetting(uint32_t setting, int* rotor_indices,
+			      int* positions) const
+{
+  if (setting >= number_of_settings_) {
+    return false;
+  }
+
+  uint32_t number_of_positions = getNumberOfPositions();
+  getRotorOrder(setting / number_of_positions, number_of_rotors_,
+		number_of_slots_, rotor_indices);
+  setting %= number_of_positions;
+  for (int i = number_of_slots_ - 1; i >= 0; i--) {
+    positions[i] = setting % ALPHABET_LENGTH;
+    setting /= ALPHABET_LENGTH;
+  }
+  return true;
+}
+
+bool CycleCatalog::getSignature(Wiring const products[INDICATOR_LENGTH / 2],
+				uint64_t& signature)
+{
+  signature = 0;
+  for (int i = 0; i < INDICATOR_LENGTH / 2; i++) {
+    uint8_t letters[ALPHABET_LENGTH];
+    int cycle_lengths[ALPHABET_LENGTH];
+    int number_of_cycles = products[i].getCycles(letters, cycle_lengths);
+    uint64_t code;
+    if (!encodeCycleLengths(vector<int>(cycle_lengths,
+					cycle_lengths + number_of_cycles),
+			    code)) {
+      return false;
+    }
+    signature = (signature << PRODUCT_BITS) | code;
+  }
+  return true;
+}
+
+int CycleCatalog::parseSignature(char const* const* cycle_lengths,
+				 uint64_t& signature)
+{
+  signature = 0;
+  for (int i = 0; i < INDICATOR_LENGTH / 2; i++) {
+    vector<int> lengths;
+    char const* next = cycle_lengths[i];
+    bool is_valid = true;
+    do {
+      char* end;
+      long length = strtol(next, &end, 10);
+      is_valid = (end != next && length > 0 && length <= ALPHABET_LENGTH
+		  && (*end == ',' || *end == '\0'));
+      lengths.push_back(length);
+      next = end + 1;
+    } while (is_valid && next[-1] == ',');
+
+    uint64_t code;
+    if (!is_valid || !encodeCycleLengths(lengths, code)) {
+      cerr << cycle_lengths[i] << " is not a list of cycle lengths in pairs";
+      cerr << " adding up to " << ALPHABET_LENGTH << endl;
+      return INVALID_ARGUMENT;
+    }
+    signature = (signature << PRODUCT_BITS) | code;
+  }
+  return NO_ERROR;
+}
+
+int CycleCatalog::readIndicators(char const* file_name, uint64_t& signature)
+{
+  ifstream in(file_name);
+  if (in.fail()) {
+    cerr << "Error opening indicator file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  // Indicator letters i and i + INDICATOR_LENGTH / 2 encipher the same
+  // key letter, so product i takes the first of them to the second.
+  int outputs[INDICATOR_LENGTH / 2][ALPHABET_LENGTH];
+  int inputs[INDICATOR_LENGTH / 2][ALPHABET_LENGTH];
+  for (int i = 0; i < INDICATOR_LENGTH / 2; i++) {
+    fill(outputs[i], outputs[i] + ALPHABET_LENGTH, -1);
+    fill(inputs[i], inputs[i] + ALPHABET_LENGTH, -1);
+  }
+
+  string indicator;
+  while (in >> indicator) {
+    bool is_valid = (indicator.size() == INDICATOR_LENGTH);
+    for (size_t i = 0; is_valid && i < indicator.size(); i++) {
+      is_valid = (indicator[i] >= ASCII_A && indicator[i] <= ASCII_Z);
+    }
+    if (!is_valid) {
+      cerr << indicator << " in indicator file " << file_name;
+      cerr << " is not " << INDICATOR_LENGTH << " upper case letters A-Z";
+      cerr << endl;
+      return INVALID_INPUT_CHARACTER;
+    }
+
+    for (int i = 0; i < INDICATOR_LENGTH / 2; i++) {
+      int input = indicator[i] - ASCII_A;
+      int output = indicator[i + INDICATOR_LENGTH / 2] - ASCII_A;
+      if ((outputs[i][input] != -1 && outputs[i][input] != output) ||
+	  (inputs[i][output] != -1 && inputs[i][output] != input)) {
+	cerr << "Indicator " << indicator << " in indicator file ";
+	cerr << file_name << " does not agree with the indicators before it";
+	cerr << endl;
+	return INVALID_ARGUMENT;
+      }
+      outputs[i][input] = output;
+      inputs[i][output] = input;
+    }
+  }
+
+  Wiring products[INDICATOR_LENGTH / 2];
+  for (int i = 0; i < INDICATOR_LENGTH / 2; i++) {
+    for (int letter = 0; letter < ALPHABET_LENGTH; letter++) {
+      if (outputs[i][letter] == -1) {
+	cerr << "The indicators in indicator file " << file_name;
+	cerr << " have no " << static_cast<char>(letter + ASCII_A);
+	cerr << " as letter " << i + 1 << endl;
+	return INVALID_ARGUMENT;
+      }
+      products[i].setOutputLetter(letter, outputs[i][letter]);
+    }
+  }
+
+  if (!getSignature(products, signature)) {
+    cerr << "The indicators in indicator file " << file_name;
+    cerr << " cannot come from a machine with a reflector" << endl;
+    return INVALID_ARGUMENT;
+  }
+  return NO_ERROR;
+}
+
+void CycleCatalog::writeSignature(uint64_t signature, ostream& out)
+{
+  for (int i = INDICATOR_LENGTH / 2 - 1; i >= 0; i--) {
+    uint64_t code = (signature >> (i * PRODUCT_BITS))
+      & ((uint64_t(1) << PRODUCT_BITS) - 1);
+    int covered = 0;
+    for (int letter = 1; letter <= ALPHABET_LENGTH / 2; letter++) {
+      if (letter == ALPHABET_LENGTH / 2 || ((code >> (letter - 1)) & 1)) {
+	int length = letter - covered;
+	out << ((covered == 0) ? "" : ",") << length << "," << length;
+	covered = letter;
+      }
+    }
+    out << ((i == 0) ? "" : " ");
+  }
+}
+
+uint32_t CycleCatalog::getNumberOfPositions() const
+{
+  uint32_t number_of_positions = 1;
+  for (int i = 0; i < number_of_slots_; i++) {
+    number_of_positions *= ALPHABET_LENGTH;
+  }
+  return number_of_positions;
+}
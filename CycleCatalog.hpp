@@ -0,0 +1,147 @@
+#ifndef CYCLE_CATALOG_H
+#define CYCLE_CATALOG_H
+
+/* The CycleCatalog class looks up the rotor orders and starting
+   positions which could have produced a day's doubled indicators, by
+   the method of Rejewski's card catalog. Each message starts with its
+   key enciphered twice, so if the permutations of the first
+   INDICATOR_LENGTH keystrokes are A to F, the indicators of enough
+   messages give the products AD, BE and CF. The lengths of the cycles
+   of those products do not depend on the plugboard, and they come in
+   pairs, so the three lists of cycle lengths - the signature - pick out
+   a handful of the machine's settings.
+   The catalog is built once for a reflector and a set of rotors by
+   running the machine from every starting position of every ordered
+   choice of number_of_slots of the rotors, in parallel, and is written
+   to a file which is mapped straight into memory, so a lookup is a
+   binary search:
+     a header (see CatalogHeader in 'CycleCatalog.cpp'),
+     the names of the reflector and rotor files, each ending in a NUL
+     character, padded to a multiple of 8 bytes,
+     a table of number_of_signatures + 1 entries in ascending order of
+     signature, each a 64 bit signature and the 64 bit number of the
+     first of its settings, the last being a sentinel holding the
+     number of settings, and
+     the settings of each signature in turn, as ascending 32 bit setting
+     numbers.
+   Setting s has rotor order s / positions and positions s % positions,
+   numbered as by KeySearch: the rotor orders as by getRotorOrder (see
+   'Catalog.hpp') and the positions as base 26 numbers with the leftmost
+   rotor most significant.
+   The machine is built with every ring setting at 0, so positions are
+   those of the wiring cores. A machine with other ring settings has the
+   signature of its positions less its ring settings, as long as the
+   middle rotor turns at the same keystroke.
+   mapping_ and mapping_size_ describe the mapped catalog file.
+   names_ points to the name of the reflector file followed by those of
+   the rotor files, signatures_ to the table of signatures, two 64 bit
+   numbers per entry, and settings_ to the settings, all inside it.
+   number_of_rotors_, number_of_slots_, number_of_signatures_ and
+   number_of_settings_ are taken from the file header, which setUp checks
+   against the file and the table before any lookup. Only the 26 letter
+   alphabet is supported. */
+
+#include "Wiring.hpp"
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+class CycleCatalog
+{
+public:
+  /* Function to initialise an empty CycleCatalog object. */
+  CycleCatalog();
+
+  /* Destructor, which unmaps the catalog file. */
+  ~CycleCatalog();
+
+  CycleCatalog(CycleCatalog const&) = delete;
+  CycleCatalog& operator=(CycleCatalog const&) = delete;
+
+  /* Function to build the catalog for the reflector named by
+     reflector_file_name, the number_of_rotors rotors named in
+     rotor_file_names and number_of_slots rotors in the machine, with
+     number_of_threads threads, and write it to the file named file_name.
+     Any of the files may be named as built-in catalog entries.
+     If is_double_stepping is true the machine steps like the historical
+     machines (see Enigma).
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  static int write(char const* reflector_file_name, int number_of_rotors,
+		   char const* const* rotor_file_names, int number_of_slots,
+		   bool is_double_stepping, int number_of_threads,
+		   char const* file_name);
+
+  /* Function to map the catalog file named file_name into memory.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int setUp(char const* file_name);
+
+  /* Function to return the number of rotors in each setting. */
+  int getNumberOfSlots() const;
+
+  /* Function to return the name of the reflector file. */
+  char const* getReflectorName() const;
+
+  /* Function to return the name of the rotor file accessed by index. */
+  char const* getRotorName(int rotor_index) const;
+
+  /* Function to fill settings with the numbers of the settings which
+     have signature, in ascending order. */
+  void findSettings(std::uint64_t signature,
+		    std::vector<std::uint32_t>& settings) const;
+
+  /* Function to fill rotor_indices with the index of the rotor in each
+     slot and positions with the position of each rotor, both from the
+     leftmost rotor to the rightmost, for setting. Returns false if there
+     is no such setting in the catalog. */
+  bool getSetting(std::uint32_t setting, int* rotor_indices,
+		  int* positions) const;
+
+  /* Function to set signature to the signature of the products of the
+     permutations of the first INDICATOR_LENGTH keystrokes, where
+     products[i] applies the permutation of keystroke i and then that of
+     keystroke i + INDICATOR_LENGTH / 2. Returns false if the cycles of
+     a product do not pair up, which no machine can produce. */
+  static bool getSignature(Wiring const products[INDICATOR_LENGTH / 2],
+			   std::uint64_t& signature);
+
+  /* Function to set signature from cycle_lengths, which holds
+     INDICATOR_LENGTH / 2 strings of cycle lengths separated by commas,
+     such as "10,10,3,3", one for each product in turn.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  static int parseSignature(char const* const* cycle_lengths,
+			    std::uint64_t& signature);
+
+  /* Function to set signature from the doubled indicators in the file
+     named file_name, each INDICATOR_LENGTH upper case letters separated
+     by whitespace. Together they must contain every letter at every
+     position, so that the products are known in full.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  static int readIndicators(char const* file_name, std::uint64_t& signature);
+
+  /* Function to write signature to out as its cycle lengths, laid out as
+     parseSignature reads them. */
+  static void writeSignature(std::uint64_t signature, std::ostream& out);
+
+private:
+  void* mapping_;
+  std::size_t mapping_size_;
+  std::vector<char const*> names_;
+  std::uint64_t const* signatures_;
+  std::uint32_t const* settings_;
+  int number_of_rotors_;
+  int number_of_slots_;
+  std::uint64_t number_of_signatures_;
+  std::uint64_t number_of_settings_;
+
+  /* Function to return the number of starting positions of a rotor
+     order. */
+  std::uint32_t getNumberOfPositions() const;
+};
+
+#endif
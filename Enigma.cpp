@@ -1,94 +1,875 @@
 /* This file contains the member function definitions 
-   for the Enigma class */
+   for the Enigma class template */
 
 #include "Enigma.hpp"
 #include "Plugboard.hpp"
 #include "Reflector.hpp"
 #include "Rotor.hpp"
+#include "Profiler.hpp"
+#include "Simd.hpp"
+#include "Catalog.hpp"
 #include "errors.h"
 #include "constants.h"
 #include <iostream>
+#include <algorithm>
 #include <cstdlib>
 #include <cstdio>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <istream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
-Enigma::Enigma() :
-  plugboard_(Plugboard()),
-  reflector_(Reflector()),
+namespace {
+  /* Functions to start and stop a phase if there is a profiler. */
+  void beginPhase(Profiler* profiler, int phase)
+  {
+    if (profiler != nullptr) {
+      profiler->begin(phase);
+    }
+  }
+
+  void endPhase(Profiler* profiler, int phase)
+  {
+    if (profiler != nullptr) {
+      profiler->end(phase);
+    }
+  }
+}
+
+template <int ALPHABET_SIZE>
+BasicEnigma<ALPHABET_SIZE>::BasicEnigma() :
+  plugboard_(BasicPlugboard<ALPHABET_SIZE>()),
+  reflector_(BasicReflector<ALPHABET_SIZE>()),
   rotor_array_(nullptr),
-  number_of_rotors_(0) {}
+  number_of_rotors_(0),
+  inner_wiring_(BasicWiring<ALPHABET_SIZE>()),
+  composition_tree_(),
+  tree_leaves_(0),
+  is_double_stepping_(false),
+  is_double_step_due_(false),
+  table_memory_(),
+  table_states_(0),
+  table_rows_(0),
+  table_loop_row_(0),
+  table_start_state_(0),
+#ifdef ENIGMA_TRACE
+  engine_(ENGINE_CACHED),
+  tracer_(nullptr) {}
+#else
+  engine_(ENGINE_CACHED) {}
+#endif
 
-Enigma::~Enigma()
+template <int ALPHABET_SIZE>
+BasicEnigma<ALPHABET_SIZE>::~BasicEnigma()
 {
   delete [] rotor_array_;
 }
 
-int Enigma::setUp(int number_of_files,
-		  char const* const* const configuration_files)
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::setUp(
+    int number_of_files,
+    char const* const* const configuration_files,
+    Profiler* profiler)
 {
-  number_of_rotors_ = number_of_files - 3;
+  createRotors(number_of_files - 3);
 
-  int plugboard_error = plugboard_.setUp(configuration_files[0]);
-  if (plugboard_error != NO_ERROR) {
-    return plugboard_error;
+  for (int i = 0; i < number_of_files; i++) {
+    int error_code = NO_ERROR;
+    if (isBuiltinName(configuration_files[i])) {
+      error_code = setUpBuiltinComponent(number_of_files, i,
+					 configuration_files[i], profiler);
+    } else {
+      ifstream in(configuration_files[i]);
+      error_code = setUpComponent(number_of_files, i, in,
+				  configuration_files[i], profiler);
+    }
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
   }
 
-  int reflector_error = reflector_.setUp(configuration_files[1]);
-  if (reflector_error != NO_ERROR) {
-    return reflector_error;
+  updateDoubleStep();
+  return setEngine(ENGINE_AUTO);
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::setUp(
+    int number_of_settings,
+    istream* const* const settings,
+    char const* const* const setting_names,
+    Profiler* profiler)
+{
+  createRotors(number_of_settings - 3);
+
+  for (int i = 0; i < number_of_settings; i++) {
+    int error_code = setUpComponent(number_of_settings, i, *settings[i],
+				    setting_names[i], profiler);
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
   }
 
-  if (number_of_rotors_ == 0) {
-    return NO_ERROR;
+  updateDoubleStep();
+  return setEngine(ENGINE_AUTO);
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::setUp(
+    uint8_t const* plugboard, uint8_t const* reflector,
+    int number_of_rotors, uint8_t const* const* forward_wirings,
+    uint8_t const* const* backward_wirings,
+    uint64_t const* const* notch_masks, int const* positions,
+    Profiler* profiler)
+{
+  createRotors(number_of_rotors);
+
+  beginPhase(profiler, PROFILE_PLUGBOARD_PARSING);
+  plugboard_.setUp(plugboard);
+  endPhase(profiler, PROFILE_PLUGBOARD_PARSING);
+
+  beginPhase(profiler, PROFILE_REFLECTOR_PARSING);
+  reflector_.setUp(reflector);
+  endPhase(profiler, PROFILE_REFLECTOR_PARSING);
+
+  beginPhase(profiler, PROFILE_ROTOR_PARSING);
+  for (int i = 0; i < number_of_rotors_; i++) {
+    rotor_array_[i].setUp(forward_wirings[i], backward_wirings[i],
+			  notch_masks[i]);
+  }
+  endPhase(profiler, PROFILE_ROTOR_PARSING);
+
+  beginPhase(profiler, PROFILE_ROTOR_POSITIONING);
+  for (int i = 0; i < number_of_rotors_; i++) {
+    rotor_array_[i].rotate(positions[i]);
+  }
+  endPhase(profiler, PROFILE_ROTOR_POSITIONING);
+
+  updateDoubleStep();
+  return setEngine(ENGINE_AUTO);
+}
+
+template <int ALPHABET_SIZE>
+char BasicEnigma<ALPHABET_SIZE>::code(char letter)
+{
+  int letter_index = static_cast<unsigned char>(letter) - FIRST_SYMBOL;
+
+  return static_cast<char>(codeIndex(letter_index) + FIRST_SYMBOL);
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::codeBlock(char* symbols, size_t length)
+{
+  size_t coded_length = 0;
+#ifdef ENIGMA_TRACE
+  bool is_traced = (tracer_ != nullptr);
+#else
+  bool is_traced = false;
+#endif
+  if (engine_ == ENGINE_AVX2 && !is_traced) {
+    coded_length = codeVectorBlocks(symbols, length);
+  } else if (engine_ == ENGINE_TABLE && !is_traced) {
+    coded_length = codeTableBlock(symbols, length);
+  }
+
+  for (size_t i = coded_length; i < length; i++) {
+    symbols[i] = code(symbols[i]);
+  }
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::codeIndex(int letter_index)
+{
+  rotateRotors();
+
+#ifdef ENIGMA_TRACE
+  if (tracer_ != nullptr) {
+    traceKeystroke(letter_index);
+  }
+#endif
+
+  return codeSignalPath(letter_index);
+}
+
+template <int ALPHABET_SIZE>
+char BasicEnigma<ALPHABET_SIZE>::codeProfiled(char letter, Profiler& profiler)
+{
+  int letter_index = static_cast<unsigned char>(letter) - FIRST_SYMBOL;
+
+  profiler.begin(PROFILE_STEPPING);
+  rotateRotors();
+  profiler.end(PROFILE_STEPPING);
+
+#ifdef ENIGMA_TRACE
+  if (tracer_ != nullptr) {
+    traceKeystroke(letter_index);
+  }
+#endif
+
+  profiler.begin(PROFILE_SIGNAL_PATH);
+  letter_index = codeSignalPath(letter_index);
+  profiler.end(PROFILE_SIGNAL_PATH);
+
+  return static_cast<char>(letter_index + FIRST_SYMBOL);
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::codeSignalPath(int letter_index) const
+{
+  if (engine_ == ENGINE_DIRECT) {
+    return codeDirectPath(letter_index);
+  }
+
+  letter_index = plugboard_.getPlugboardLetter(letter_index);
+
+  if (number_of_rotors_ > 0) {
+    BasicRotor<ALPHABET_SIZE> const& fast_rotor =
+      rotor_array_[number_of_rotors_ - 1];
+    letter_index = fast_rotor.getForwardRotorLetter(letter_index);
+    letter_index = inner_wiring_.getOutputLetter(letter_index);
+    letter_index = fast_rotor.getBackwardRotorLetter(letter_index);
   } else {
-    rotor_array_ = new Rotor[number_of_rotors_];
+    letter_index = inner_wiring_.getOutputLetter(letter_index);
+  }
+  
+  letter_index = plugboard_.getPlugboardLetter(letter_index);    
 
-    for (int i = 0; i < number_of_rotors_; i++) {
-      int rotor_error = rotor_array_[i].setUp(configuration_files[i + 2]);
-      if (rotor_error != NO_ERROR) {
-	return rotor_error;
-      }
+  return letter_index;
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::setEngine(int engine,
+					  std::uint64_t expected_length)
+{
+  bool is_vector_possible = (ALPHABET_SIZE == ALPHABET_LENGTH
+			     && number_of_rotors_ > 0 && hasAvx2());
+  bool is_deep = (number_of_rotors_ - 1 >= COMPOSITION_TREE_MIN_ROTORS);
+
+  if (engine == ENGINE_AUTO) {
+    if (expected_length > 0 && expected_length < ALPHABET_SIZE / 2) {
+      engine = ENGINE_DIRECT;
+    } else if (is_vector_possible) {
+      engine = ENGINE_AVX2;
+    } else {
+      engine = (is_deep) ? ENGINE_TREE : ENGINE_CACHED;
     }
+  }
 
-    int position_error =
-      positionRotors(configuration_files[number_of_files - 1]);
-    if (position_error != NO_ERROR) {
-      return position_error;
+  if (engine < 0 || engine >= NUMBER_OF_ENGINES
+      || (engine == ENGINE_AVX2 && !is_vector_possible)
+      || (engine == ENGINE_TREE && number_of_rotors_ < 2)
+      || (engine == ENGINE_TABLE && number_of_rotors_ < 1)) {
+    cerr << "The " << ((engine >= 0 && engine < NUMBER_OF_ENGINES)
+		       ? getEngineName(engine) : "requested");
+    cerr << " engine cannot code this machine on this processor" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  if (engine == ENGINE_TABLE) {
+    int error_code = buildTable();
+    if (error_code != NO_ERROR) {
+      return error_code;
     }
+  } else {
+    dropTable();
   }
-  
+
+  engine_ = engine;
+  resizeCompositionTree(engine_ == ENGINE_TREE
+			|| (engine_ == ENGINE_AVX2 && is_deep));
+  updateInnerWiring();
+
   return NO_ERROR;
 }
 
-char Enigma::code(char letter)
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::getEngine() const
 {
-  int letter_index = static_cast<int>(letter) - ASCII_A;
-  
-  rotateRotors();
+  return engine_;
+}
+
+template <int ALPHABET_SIZE>
+char const* BasicEnigma<ALPHABET_SIZE>::getEngineName(int engine)
+{
+  char const* const names[NUMBER_OF_ENGINES] = {
+    "direct",
+    "cached",
+    "tree",
+    "avx2",
+    "table"
+  };
+  return names[engine];
+}
+
+#ifdef ENIGMA_TRACE
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::setTracer(Tracer* tracer)
+{
+  tracer_ = tracer;
+}
 
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::traceKeystroke(int letter_index) const
+{
+  // The path is traced rotor by rotor rather than through inner_wiring_,
+  // so the trace shows every component the signal passes.
+  std::uint8_t* record = tracer_->nextRecord();
+  int n = number_of_rotors_;
+
+  record[0] = letter_index;
   letter_index = plugboard_.getPlugboardLetter(letter_index);
-  
-  for (int i = number_of_rotors_; i > 0; i--) {
-    letter_index = rotor_array_[i - 1].getForwardRotorLetter(letter_index);
+  record[1] = letter_index;
+  for (int i = n - 1; i >= 0; i--) {
+    letter_index = rotor_array_[i].getForwardRotorLetter(letter_index);
+    record[2 + (n - 1 - i)] = letter_index;
+  }
+  letter_index = reflector_.getReflectorLetter(letter_index);
+  record[2 + n] = letter_index;
+  for (int i = 0; i < n; i++) {
+    letter_index = rotor_array_[i].getBackwardRotorLetter(letter_index);
+    record[3 + n + i] = letter_index;
+  }
+  record[3 + 2 * n] = plugboard_.getPlugboardLetter(letter_index);
+  for (int i = 0; i < n; i++) {
+    record[4 + 2 * n + i] = rotor_array_[i].getTopLetter();
+  }
+}
+#endif
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::getNumberOfRotors() const
+{
+  return number_of_rotors_;
+}
+
+template <int ALPHABET_SIZE>
+BasicPlugboard<ALPHABET_SIZE> const&
+BasicEnigma<ALPHABET_SIZE>::getPlugboard() const
+{
+  return plugboard_;
+}
+
+template <int ALPHABET_SIZE>
+BasicReflector<ALPHABET_SIZE> const&
+BasicEnigma<ALPHABET_SIZE>::getReflector() const
+{
+  return reflector_;
+}
+
+template <int ALPHABET_SIZE>
+BasicRotor<ALPHABET_SIZE> const&
+BasicEnigma<ALPHABET_SIZE>::getRotor(int rotor_index) const
+{
+  return rotor_array_[rotor_index];
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::setPositions(int const* const positions)
+{
+  for (int i = 0; i < number_of_rotors_; i++) {
+    BasicRotor<ALPHABET_SIZE>& rotor = rotor_array_[i];
+    rotor.rotate(positions[i] - rotor.getTopLetter() + ALPHABET_SIZE);
+  }
+
+  updateDoubleStep();
+  updateInnerWiring();
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::setRingSettings(
+    int const* const ring_settings)
+{
+  for (int i = 0; i < number_of_rotors_; i++) {
+    rotor_array_[i].setRingSetting(ring_settings[i]);
+  }
+
+  dropTable();
+  updateInnerWiring();
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::setUpRingSettings(
+    char const* const input_file_name)
+{
+  vector<int> ring_settings(number_of_rotors_);
+
+  if (isBuiltinName(input_file_name)) {
+    BuiltinPositions const* positions =
+      findBuiltinPositions(input_file_name);
+    if (ALPHABET_SIZE != ALPHABET_LENGTH || positions == nullptr) {
+      cerr << "There are no built-in ring settings " << input_file_name;
+      cerr << endl;
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+    if (static_cast<int>(strlen(positions->letters)) != number_of_rotors_) {
+      cerr << "Built-in ring settings " << input_file_name << " are for ";
+      cerr << strlen(positions->letters) << " rotors, not ";
+      cerr << number_of_rotors_ << endl;
+      return NO_ROTOR_STARTING_POSITION;
+    }
+    for (int i = 0; i < number_of_rotors_; i++) {
+      ring_settings[i] = positions->letters[i] - ASCII_A;
+    }
+  } else if (number_of_rotors_ > 0) {
+    ifstream in(input_file_name);
+    if (in.fail()) {
+      cerr << "Error opening ring setting file " << input_file_name << endl;
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+    int error_code = readRotorPositions(ring_settings.data(), in,
+					input_file_name);
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
+  }
+
+  setRingSettings(ring_settings.data());
+  return NO_ERROR;
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::setDoubleStepping(bool is_double_stepping)
+{
+  is_double_stepping_ = is_double_stepping;
+  dropTable();
+  updateDoubleStep();
+}
+
+template <int ALPHABET_SIZE>
+bool BasicEnigma<ALPHABET_SIZE>::isDoubleStepping() const
+{
+  return is_double_stepping_;
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::swapPlugPair(int first_letter,
+					      int second_letter)
+{
+  // The plugboard is outside the inner wiring, so nothing else changes.
+  plugboard_.swapPlugPair(first_letter, second_letter);
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::setRotorOrder(int const* const rotor_order)
+{
+  // The permutation is applied one cycle at a time, starting each cycle
+  // from its lowest index so it is only moved once. Only one rotor is
+  // held aside at a time, so no memory is allocated.
+  for (int i = 0; i < number_of_rotors_; i++) {
+    int j = rotor_order[i];
+    while (j > i) {
+      j = rotor_order[j];
+    }
+    if (j < i) {
+      continue;
+    }
+
+    BasicRotor<ALPHABET_SIZE> first_rotor = rotor_array_[i];
+    j = i;
+    while (rotor_order[j] != i) {
+      rotor_array_[j] = rotor_array_[rotor_order[j]];
+      j = rotor_order[j];
+    }
+    rotor_array_[j] = first_rotor;
+  }
+
+  dropTable();
+  updateDoubleStep();
+  updateInnerWiring();
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::replaceReflector(
+    BasicReflector<ALPHABET_SIZE> const& reflector)
+{
+  reflector_ = reflector;
+  dropTable();
+  updateInnerWiring();
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::advance(std::uint64_t number_of_keystrokes)
+{
+  for (std::uint64_t i = 0; i < number_of_keystrokes; i++) {
+    rotateRotors();
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::createRotors(int number_of_rotors)
+{
+  delete [] rotor_array_;
+  number_of_rotors_ = number_of_rotors;
+  rotor_array_ = (number_of_rotors_ > 0)
+    ? new BasicRotor<ALPHABET_SIZE>[number_of_rotors_] : nullptr;
+  resizeCompositionTree(false);
+  dropTable();
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::resizeCompositionTree(bool is_used)
+{
+  // The tree is sized once here so that later changes never allocate.
+  tree_leaves_ = 0;
+  composition_tree_.clear();
+  if (is_used) {
+    tree_leaves_ = 1;
+    while (tree_leaves_ < number_of_rotors_ - 1) {
+      tree_leaves_ *= 2;
+    }
+    composition_tree_.resize(2 * tree_leaves_);
+  }
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::codeDirectPath(int letter_index) const
+{
+  letter_index = plugboard_.getPlugboardLetter(letter_index);
+  for (int i = number_of_rotors_ - 1; i >= 0; i--) {
+    letter_index = rotor_array_[i].getForwardRotorLetter(letter_index);
   }
-  
   letter_index = reflector_.getReflectorLetter(letter_index);
-  
   for (int i = 0; i < number_of_rotors_; i++) {
     letter_index = rotor_array_[i].getBackwardRotorLetter(letter_index);
   }
-  
-  letter_index = plugboard_.getPlugboardLetter(letter_index);    
+  return plugboard_.getPlugboardLetter(letter_index);
+}
+
+template <int ALPHABET_SIZE>
+size_t BasicEnigma<ALPHABET_SIZE>::codeVectorBlocks(char* symbols,
+						    size_t length)
+{
+  BasicRotor<ALPHABET_SIZE>& fast_rotor = rotor_array_[number_of_rotors_ - 1];
+  SimdLetterWirings wirings = {};
+  for (int letter = 0; letter < ALPHABET_LENGTH; letter++) {
+    wirings.plugboard[letter] = plugboard_.getPlugboardLetter(letter);
+    wirings.forward[letter] = fast_rotor.getForwardRotorLetter(letter, 0);
+    wirings.backward[letter] = fast_rotor.getBackwardRotorLetter(letter, 0);
+  }
 
-  return static_cast<char>(letter_index + ASCII_A);  
+  // Only a keystroke which leaves the rightmost rotor at a notch, or on
+  // which a double step is due, moves any other rotor, so between those
+  // the stepping is just counted.
+  bool is_carry[ALPHABET_LENGTH];
+  for (int letter = 0; letter < ALPHABET_LENGTH; letter++) {
+    is_carry[letter] = (number_of_rotors_ > 1 && fast_rotor.isNotch(letter));
+  }
+
+  // Every carry within a block adds an inner wiring, so there can be one
+  // more than there are letters. The last one carries over to the next
+  // block.
+  alignas(SIMD_BLOCK_LENGTH)
+    std::uint8_t inner_wirings[SIMD_BLOCK_LENGTH + 1][SIMD_BLOCK_LENGTH] = {};
+  std::uint8_t inner_wiring_indices[SIMD_BLOCK_LENGTH];
+  std::uint8_t positions[SIMD_BLOCK_LENGTH];
+  std::uint8_t letters[SIMD_BLOCK_LENGTH];
+  copyInnerWiring(inner_wirings[0]);
+
+  size_t coded_length = 0;
+  for (; coded_length + SIMD_BLOCK_LENGTH <= length;
+       coded_length += SIMD_BLOCK_LENGTH) {
+    char* block = symbols + coded_length;
+    int number_of_inner_wirings = 1;
+    int position = fast_rotor.getTopLetter();
+    int uncounted_steps = 0;
+    for (int i = 0; i < SIMD_BLOCK_LENGTH; i++) {
+      position = (position == Z_INDEX) ? A_INDEX : position + 1;
+      if (is_carry[position] || is_double_step_due_) {
+	fast_rotor.rotate(uncounted_steps);
+	uncounted_steps = 0;
+	rotateRotors();
+	copyInnerWiring(inner_wirings[number_of_inner_wirings]);
+	number_of_inner_wirings++;
+      } else {
+	uncounted_steps++;
+      }
+      inner_wiring_indices[i] = number_of_inner_wirings - 1;
+      positions[i] = position;
+      letters[i] = block[i] - FIRST_SYMBOL;
+    }
+    fast_rotor.rotate(uncounted_steps);
+
+    codeLetterBlockAvx2(wirings, inner_wirings, inner_wiring_indices,
+			number_of_inner_wirings, positions, letters);
+
+    for (int i = 0; i < SIMD_BLOCK_LENGTH; i++) {
+      block[i] = static_cast<char>(letters[i] + FIRST_SYMBOL);
+    }
+    if (number_of_inner_wirings > 1) {
+      memcpy(inner_wirings[0], inner_wirings[number_of_inner_wirings - 1],
+	     SIMD_BLOCK_LENGTH);
+    }
+  }
+
+  return coded_length;
 }
 
-int Enigma::positionRotors(char const* const input_file_name)
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::buildTable()
+{
+  dropTable();
+
+  std::uint64_t number_of_states = 1;
+  for (int i = 0; i < number_of_rotors_ && number_of_states <= TABLE_MAX_STATES;
+       i++) {
+    number_of_states *= ALPHABET_SIZE;
+  }
+  if (number_of_states > TABLE_MAX_STATES) {
+    cerr << "The rotors have too many states for a lookup table" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  // Every state can have a row, since the sequence of states has at most
+  // one row per state before it repeats.
+  size_t size = number_of_states
+    * (sizeof(std::uint32_t) + ALPHABET_SIZE + number_of_rotors_);
+  std::uint8_t* table = table_memory_.allocate(size);
+  if (table == nullptr) {
+    cerr << "The lookup table needs " << size << " bytes, which do not fit";
+    cerr << " in the table memory budget of " << TableMemory::getBudget();
+    cerr << " bytes" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  std::uint32_t* rows_of_states = reinterpret_cast<std::uint32_t*>(table);
+  std::uint8_t* keystrokes = table + number_of_states * sizeof(std::uint32_t);
+  std::uint8_t* row_positions = keystrokes + number_of_states * ALPHABET_SIZE;
+  fill(rows_of_states, rows_of_states + number_of_states, TABLE_NO_ROW);
+
+  // The machine is stepped through the sequence itself, with the direct
+  // engine so the inner wiring is not refreshed on every carry.
+  vector<int> start_positions(number_of_rotors_);
+  for (int i = 0; i < number_of_rotors_; i++) {
+    start_positions[i] = rotor_array_[i].getTopLetter();
+  }
+  int engine = engine_;
+  engine_ = ENGINE_DIRECT;
+  table_start_state_ = getStateIndex();
+
+  std::uint32_t row = 0;
+  for (;;) {
+    rotateRotors();
+    std::uint64_t state = getStateIndex();
+    if (rows_of_states[state] != TABLE_NO_ROW) {
+      table_loop_row_ = rows_of_states[state];
+      break;
+    }
+    rows_of_states[state] = row;
+
+    // The plugboard is its own inverse, so undoing it on both sides of the
+    // direct path leaves the rotors and reflector alone.
+    std::uint8_t* keystroke = keystrokes + std::uint64_t(row) * ALPHABET_SIZE;
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+      int coded_letter =
+	codeDirectPath(plugboard_.getPlugboardLetter(letter));
+      keystroke[letter] = plugboard_.getPlugboardLetter(coded_letter);
+    }
+    std::uint8_t* positions =
+      row_positions + std::uint64_t(row) * number_of_rotors_;
+    for (int i = 0; i < number_of_rotors_; i++) {
+      positions[i] = rotor_array_[i].getTopLetter();
+    }
+    row++;
+  }
+
+  table_rows_ = row;
+  table_states_ = number_of_states;
+  engine_ = engine;
+  setPositions(start_positions.data());
+  table_memory_.unpin();
+  return NO_ERROR;
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::dropTable()
+{
+  if (engine_ == ENGINE_TABLE) {
+    engine_ = ENGINE_CACHED;
+  }
+  table_memory_.release();
+  table_states_ = 0;
+}
+
+template <int ALPHABET_SIZE>
+std::uint64_t BasicEnigma<ALPHABET_SIZE>::getStateIndex() const
+{
+  std::uint64_t state = 0;
+  for (int i = 0; i < number_of_rotors_; i++) {
+    state = state * ALPHABET_SIZE + rotor_array_[i].getTopLetter();
+  }
+  return state;
+}
+
+template <int ALPHABET_SIZE>
+size_t BasicEnigma<ALPHABET_SIZE>::codeTableBlock(char* symbols,
+						  size_t length)
+{
+  std::uint8_t* table = table_memory_.pin();
+  if (table == nullptr) {
+    dropTable();
+    return 0;
+  }
+
+  std::uint32_t const* rows_of_states =
+    reinterpret_cast<std::uint32_t const*>(table);
+  std::uint8_t const* keystrokes =
+    table + table_states_ * sizeof(std::uint32_t);
+  std::uint8_t const* row_positions =
+    keystrokes + table_states_ * ALPHABET_SIZE;
+
+  // Outside the sequence the table was built from there is no row to
+  // start from, except in the state it was built in, which comes just
+  // before row 0: TABLE_NO_ROW + 1 wraps round to 0.
+  std::uint64_t state = getStateIndex();
+  std::uint32_t row = rows_of_states[state];
+  if (row == TABLE_NO_ROW && state != table_start_state_) {
+    table_memory_.unpin();
+    return 0;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    row = (row + 1 == table_rows_) ? table_loop_row_ : row + 1;
+    int letter_index = static_cast<unsigned char>(symbols[i]) - FIRST_SYMBOL;
+    letter_index = plugboard_.getPlugboardLetter(letter_index);
+    letter_index = keystrokes[std::uint64_t(row) * ALPHABET_SIZE
+			      + letter_index];
+    letter_index = plugboard_.getPlugboardLetter(letter_index);
+    symbols[i] = static_cast<char>(letter_index + FIRST_SYMBOL);
+  }
+
+  // The rotors are only turned to where the block left them once it is
+  // coded, so single letters can carry on from there.
+  if (length > 0) {
+    std::uint8_t const* positions =
+      row_positions + std::uint64_t(row) * number_of_rotors_;
+    for (int i = 0; i < number_of_rotors_; i++) {
+      BasicRotor<ALPHABET_SIZE>& rotor = rotor_array_[i];
+      rotor.rotate(positions[i] - rotor.getTopLetter() + ALPHABET_SIZE);
+    }
+    updateDoubleStep();
+    updateInnerWiring();
+  }
+  table_memory_.unpin();
+
+  return length;
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::copyInnerWiring(std::uint8_t* wiring) const
+{
+  for (int letter = 0; letter < ALPHABET_LENGTH; letter++) {
+    wiring[letter] = inner_wiring_.getOutputLetter(letter);
+  }
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::setUpBuiltinComponent(
+    int number_of_settings, int setting_index,
+    char const* const setting_name, Profiler* profiler)
+{
+  if (ALPHABET_SIZE != ALPHABET_LENGTH) {
+    cerr << "Built-in component " << setting_name;
+    cerr << " can only be used with the " << ALPHABET_LENGTH;
+    cerr << " letter alphabet" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  int error_code = NO_ERROR;
+
+  if (setting_index == 0) {
+    beginPhase(profiler, PROFILE_PLUGBOARD_PARSING);
+    BuiltinWiring const* plugboard = findBuiltinPlugboard(setting_name);
+    if (plugboard != nullptr) {
+      plugboard_.setUp(plugboard->mapping);
+    }
+    endPhase(profiler, PROFILE_PLUGBOARD_PARSING);
+    if (plugboard == nullptr) {
+      cerr << "There is no built-in plugboard " << setting_name << endl;
+      error_code = ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  } else if (setting_index == 1) {
+    beginPhase(profiler, PROFILE_REFLECTOR_PARSING);
+    BuiltinWiring const* reflector = findBuiltinReflector(setting_name);
+    if (reflector != nullptr) {
+      reflector_.setUp(reflector->mapping);
+    }
+    endPhase(profiler, PROFILE_REFLECTOR_PARSING);
+    if (reflector == nullptr) {
+      cerr << "There is no built-in reflector " << setting_name << endl;
+      error_code = ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  } else if (setting_index < number_of_settings - 1) {
+    beginPhase(profiler, PROFILE_ROTOR_PARSING);
+    BuiltinRotor const* rotor = findBuiltinRotor(setting_name);
+    if (rotor != nullptr) {
+      rotor_array_[setting_index - 2].setUp(rotor->forward, rotor->backward,
+					    &rotor->notch_mask);
+    }
+    endPhase(profiler, PROFILE_ROTOR_PARSING);
+    if (rotor == nullptr) {
+      cerr << "There is no built-in rotor " << setting_name << endl;
+      error_code = ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  } else if (number_of_rotors_ > 0) {
+    BuiltinPositions const* positions = findBuiltinPositions(setting_name);
+    if (positions == nullptr) {
+      cerr << "There are no built-in rotor positions " << setting_name;
+      cerr << endl;
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+    if (static_cast<int>(strlen(positions->letters)) != number_of_rotors_) {
+      cerr << "Built-in rotor positions " << setting_name << " are for ";
+      cerr << strlen(positions->letters) << " rotors, not ";
+      cerr << number_of_rotors_ << endl;
+      return NO_ROTOR_STARTING_POSITION;
+    }
+    beginPhase(profiler, PROFILE_ROTOR_POSITIONING);
+    for (int j = 0; j < number_of_rotors_; j++) {
+      rotor_array_[j].rotate(positions->letters[j] - ASCII_A);
+    }
+    endPhase(profiler, PROFILE_ROTOR_POSITIONING);
+  }
+
+  return error_code;
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::setUpComponent(
+    int number_of_settings, int setting_index,
+    istream& in, char const* const setting_name,
+    Profiler* profiler)
+{
+  int error_code = NO_ERROR;
+
+  if (setting_index == 0) {
+    beginPhase(profiler, PROFILE_PLUGBOARD_PARSING);
+    error_code = plugboard_.setUp(in, setting_name);
+    endPhase(profiler, PROFILE_PLUGBOARD_PARSING);
+  } else if (setting_index == 1) {
+    beginPhase(profiler, PROFILE_REFLECTOR_PARSING);
+    error_code = reflector_.setUp(in, setting_name);
+    endPhase(profiler, PROFILE_REFLECTOR_PARSING);
+  } else if (setting_index < number_of_settings - 1) {
+    beginPhase(profiler, PROFILE_ROTOR_PARSING);
+    error_code = rotor_array_[setting_index - 2].setUp(in, setting_name);
+    endPhase(profiler, PROFILE_ROTOR_PARSING);
+  } else if (number_of_rotors_ > 0) {
+    // Without rotors the position file is not read at all.
+    beginPhase(profiler, PROFILE_ROTOR_POSITIONING);
+    error_code = positionRotors(in, setting_name);
+    endPhase(profiler, PROFILE_ROTOR_POSITIONING);
+  }
+
+  return error_code;
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::positionRotors(
+    istream& in, char const* const input_file_name)
 {
-  ifstream in(input_file_name);
   if (in.fail()) {
     cerr << "Error opening rotor position file " << input_file_name << endl;
     return ERROR_OPENING_CONFIGURATION_FILE;
@@ -98,14 +879,11 @@ int Enigma::positionRotors(char const* const input_file_name)
   if (in.peek() == EOF) {
     cerr << "No starting position for rotor 0 in rotor position file ";
     cerr << input_file_name << endl;
-    in.close();
     return NO_ROTOR_STARTING_POSITION;
   } else {
     auto positions = new int[number_of_rotors_];
     int position_error = readRotorPositions(positions, in, input_file_name);
 
-    in.close();
-    
     if (position_error != NO_ERROR) {
       delete positions;
       return position_error;
@@ -121,8 +899,10 @@ int Enigma::positionRotors(char const* const input_file_name)
   return NO_ERROR;
 }
 
-int Enigma::readRotorPositions(int* const positions, ifstream& in,
-			       char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::readRotorPositions(
+    int* const positions, istream& in,
+    char const* const file_name) const
 {
   string number_string;
   in >> number_string;
@@ -158,8 +938,9 @@ int Enigma::readRotorPositions(int* const positions, ifstream& in,
   return NO_ERROR;
 }
 
-int Enigma::checkNumeric(string number_string,
-			 char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::checkNumeric(string number_string,
+					     char const* const file_name) const
 {
   for (int i = 0; number_string[i]; i++) {
     if (number_string[i] < ASCII_ZERO || number_string[i] > ASCII_NINE) {
@@ -171,36 +952,206 @@ int Enigma::checkNumeric(string number_string,
   return NO_ERROR;
 }
 
-int Enigma::checkIndex(int letter_index, char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::checkIndex(int letter_index,
+					   char const* const file_name) const
 {
-  if (letter_index < A_INDEX || letter_index > Z_INDEX) {
+  if (letter_index < A_INDEX || letter_index > ALPHABET_SIZE - 1) {
     cerr << "Invalid index in rotor position file " << file_name << endl;
     return INVALID_INDEX;
   }
   return NO_ERROR;
 }
 
-void Enigma::rotateRotors()
+template <int ALPHABET_SIZE>
+bool BasicEnigma<ALPHABET_SIZE>::rotateRotors()
 {
   if (rotor_array_ != nullptr) {
-    rotor_array_[number_of_rotors_ - 1].rotateUp();
+    BasicRotor<ALPHABET_SIZE>& fast_rotor =
+      rotor_array_[number_of_rotors_ - 1];
+    fast_rotor.rotateUp();
 
-    bool is_still_rotating = true;
-    
-    for (int i = number_of_rotors_ - 1; i > 0 && is_still_rotating; i--) {
-      is_still_rotating = rotateSingleRotor(i);
+    // Most keystrokes only move the rightmost rotor, which leaves the
+    // inner wiring unchanged.
+    if (number_of_rotors_ > 1
+	&& (fast_rotor.isAtNotch() || is_double_step_due_)) {
+      int first_moved_rotor = (is_double_stepping_)
+	? rotateSlowerRotorsDoubleStepping() : rotateSlowerRotors();
+
+      // The direct engine never reads the inner wiring.
+      if (engine_ != ENGINE_DIRECT) {
+	updateInnerWiring(first_moved_rotor);
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::rotateSlowerRotors()
+{
+  rotateSingleRotor(number_of_rotors_ - 1);
+  bool is_still_rotating = true;
+  int first_moved_rotor = number_of_rotors_ - 2;
+
+  for (int i = number_of_rotors_ - 2; i > 0 && is_still_rotating; i--) {
+    is_still_rotating = rotateSingleRotor(i);
+    if (is_still_rotating) {
+      first_moved_rotor = i - 1;
+    }
+  }
+
+  return first_moved_rotor;
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigma<ALPHABET_SIZE>::rotateSlowerRotorsDoubleStepping()
+{
+  // Every pawl acts on the positions before the keystroke: a rotor steps
+  // when its right neighbour was one step before a notch, and a middle
+  // rotor one step before a notch also pushes itself. Visiting the rotors
+  // from right to left checks each one before it moves.
+  bool is_carrying = rotor_array_[number_of_rotors_ - 1].isAtNotch();
+  int first_moved_rotor = number_of_rotors_ - 1;
+  is_double_step_due_ = false;
+
+  for (int i = number_of_rotors_ - 2; i >= 0; i--) {
+    BasicRotor<ALPHABET_SIZE>& rotor = rotor_array_[i];
+    if (is_carrying || (i > 0 && rotor.isBeforeNotch())) {
+      rotor.rotateUp();
+      first_moved_rotor = i;
+      is_carrying = rotor.isAtNotch();
+    } else {
+      is_carrying = false;
+    }
+    if (i > 0 && rotor.isBeforeNotch()) {
+      is_double_step_due_ = true;
     }
   }
+
+  return first_moved_rotor;
 }
 
-bool Enigma::rotateSingleRotor(int rotor_index)
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::updateDoubleStep()
 {
-  for (int i = 0; i < rotor_array_[rotor_index].getNumberOfNotches(); i++) {
-    if (rotor_array_[rotor_index].getNotch(i) ==
-	rotor_array_[rotor_index].getTopLetter()) {
-      rotor_array_[rotor_index - 1].rotateUp();
-      return true;
+  is_double_step_due_ = false;
+  if (is_double_stepping_) {
+    for (int i = 1; i < number_of_rotors_ - 1; i++) {
+      if (rotor_array_[i].isBeforeNotch()) {
+	is_double_step_due_ = true;
+      }
     }
   }
+}
+
+template <int ALPHABET_SIZE>
+bool BasicEnigma<ALPHABET_SIZE>::rotateSingleRotor(int rotor_index)
+{
+  if (rotor_array_[rotor_index].isAtNotch()) {
+    rotor_array_[rotor_index - 1].rotateUp();
+    return true;
+  }
   return false;
 }
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::updateInnerWiring()
+{
+  if (tree_leaves_ > 0) {
+    for (int i = 0; i < number_of_rotors_ - 1; i++) {
+      setTreeLeaf(i);
+    }
+    for (int node = tree_leaves_ - 1; node > 0; node--) {
+      composeTreeNode(node);
+    }
+    updateInnerWiringFromTree();
+    return;
+  }
+
+  bool is_mapped[ALPHABET_SIZE] = {};
+
+  // The inner path is the reflector conjugated by the slower rotors, so it
+  // pairs letters up and each pair only needs to be traced once.
+  for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+    if (is_mapped[letter]) {
+      continue;
+    }
+
+    int letter_index = letter;
+    for (int i = number_of_rotors_ - 1; i > 0; i--) {
+      letter_index = rotor_array_[i - 1].getForwardRotorLetter(letter_index);
+    }
+
+    letter_index = reflector_.getReflectorLetter(letter_index);
+
+    for (int i = 0; i < number_of_rotors_ - 1; i++) {
+      letter_index = rotor_array_[i].getBackwardRotorLetter(letter_index);
+    }
+
+    inner_wiring_.setOutputLetter(letter, letter_index);
+    inner_wiring_.setOutputLetter(letter_index, letter);
+    is_mapped[letter] = true;
+    is_mapped[letter_index] = true;
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::updateInnerWiring(int first_moved_rotor)
+{
+  if (tree_leaves_ == 0) {
+    updateInnerWiring();
+    return;
+  }
+
+  int last_moved_rotor = number_of_rotors_ - 2;
+  for (int i = first_moved_rotor; i <= last_moved_rotor; i++) {
+    setTreeLeaf(i);
+  }
+
+  // Only the ancestors of the moved rotors change, which for the usual
+  // carry of a single rotor is one node on each level.
+  int first_node = (tree_leaves_ + first_moved_rotor) / 2;
+  int last_node = (tree_leaves_ + last_moved_rotor) / 2;
+  for (; first_node > 0; first_node /= 2, last_node /= 2) {
+    for (int node = first_node; node <= last_node; node++) {
+      composeTreeNode(node);
+    }
+  }
+
+  updateInnerWiringFromTree();
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::setTreeLeaf(int rotor_index)
+{
+  rotor_array_[rotor_index].getForwardWiring(
+      composition_tree_[tree_leaves_ + rotor_index]);
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::composeTreeNode(int node)
+{
+  // The signal reaches the higher rotor indices first, which are on the
+  // right hand side of the tree.
+  composition_tree_[node].setComposition(composition_tree_[2 * node + 1],
+					 composition_tree_[2 * node]);
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigma<ALPHABET_SIZE>::updateInnerWiringFromTree()
+{
+  BasicWiring<ALPHABET_SIZE> const& stack = composition_tree_[1];
+
+  // The backward path through the stack is the inverse of the forward
+  // path, so the inner wiring pairs each letter with the letter whose
+  // forward path meets its own at the reflector.
+  BasicWiring<ALPHABET_SIZE> backward;
+  backward.setInverse(stack);
+  inner_wiring_.setComposition(stack, reflector_.getWiring());
+  inner_wiring_.setComposition(inner_wiring_, backward);
+}
+
+template class BasicEnigma<ALPHABET_LENGTH>;
+template class BasicEnigma<BYTE_ALPHABET_LENGTH>;
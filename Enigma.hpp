@@ -1,32 +1,123 @@
 #ifndef ENIGMA_H
 #define ENIGMA_H
 
-/* The Enigma class contains a Plugboard object, a Reflector 
+/* The Enigma class template contains a Plugboard object, a Reflector 
    object, a pointer to a Rotor object and and integer.
    plugboard_ contains the plugboard mappings.
    reflector_ contains the reflector mappings.
    rotor_array_ is a pointer that can point to an array
    of Rotor objects, depending on how many rotors are input.
+   The array is a single cache line aligned block holding all the
+   rotor data, so the whole machine state of a 3 rotor Enigma spans
+   only a handful of cache lines.
    number_of_rotors_ is the number_of_rotors in the Enigma 
-   object. */
+   object.
+   inner_wiring_ contains the combined mapping from the rightmost rotor
+   through every slower rotor, the reflector and back, for the current
+   rotor positions. It only changes when a carry moves a slower rotor,
+   so most letters are coded with the rightmost rotor and this single
+   lookup.
+   composition_tree_ is only used by ENGINE_TREE, and by ENGINE_AVX2 when
+   there are at least COMPOSITION_TREE_MIN_ROTORS rotors besides the
+   rightmost one. It is a
+   segment tree over those rotors: leaf i holds the forward mapping of
+   rotor i at its current position and every other node holds the
+   composition of its two children, so the root maps a letter through
+   the whole stack. A carry then only recomposes the nodes above the
+   rotors it moved rather than tracing every letter through every
+   rotor. Node 1 is the root, the children of node k are nodes 2k and
+   2k + 1 and the leaves start at node tree_leaves_.
+   is_double_stepping_ is true if the rotors step like the historical
+   machines, in which a middle rotor one step before a notch steps again
+   on the next keystroke, taking its left neighbour with it (see
+   setDoubleStepping). Otherwise they step like an odometer.
+   is_double_step_due_ is true if a middle rotor is one step before a
+   notch while double stepping, so the next keystroke moves it. It can
+   only become true on a keystroke which moves a slower rotor, so most
+   keystrokes just test it.
+   table_memory_ holds the keystroke table of ENGINE_TABLE, which is laid
+   out as three arrays with one entry per rotor state: the row of the
+   table reached in each state (TABLE_NO_ROW for states the machine never
+   reaches from the state the table was built in), then for each row the
+   permutation of one keystroke through the rotors and reflector, and
+   then for each row the rotor positions, leftmost rotor first. Row r
+   holds the keystroke r + 1 keystrokes after the table was built, so the
+   rows follow the rotor states in the order the machine steps through
+   them.
+   table_states_ is the number of rotor states, or 0 if there is no
+   table.
+   table_rows_ is the number of rows filled in, and table_loop_row_ is the
+   row which follows the last one, since the stepping sequence returns to
+   a state it has already been in.
+   table_start_state_ is the state the table was built in, which only has
+   a row if the stepping sequence returns to it.
+   engine_ is the strategy used to code, one of the ENGINE_ values
+   below (see setEngine).
+   When built with ENIGMA_TRACE defined, tracer_ points to the Tracer
+   which records every keystroke, or is nullptr if none is.
+   Enigma codes the upper case letters A-Z. ByteEnigma codes all 256
+   byte values, so binary data can be coded without first converting
+   it to letters. */
 
 #include "Plugboard.hpp"
 #include "Reflector.hpp"
 #include "Rotor.hpp"
-#include <fstream>
+#include "Profiler.hpp"
+#include "Tracer.hpp"
+#include "TableMemory.hpp"
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
 #include <string>
+#include <vector>
 
-class Enigma
+/* Strategies for coding, in the order they are named by getEngineName.
+   ENGINE_DIRECT traces every letter through every rotor.
+   ENGINE_CACHED codes through inner_wiring_, tracing the slower rotors
+   again only after a carry.
+   ENGINE_TREE keeps inner_wiring_ up to date with composition_tree_.
+   ENGINE_AVX2 codes blocks of letters with vector instructions, keeping
+   inner_wiring_ up to date as ENGINE_TREE does for deep stacks and as
+   ENGINE_CACHED does otherwise. It is only available for the 26 letter
+   alphabet on processors with AVX2.
+   ENGINE_TABLE looks each keystroke up in a table of every keystroke the
+   machine makes before its stepping repeats, built when it is chosen. It
+   codes each letter of a block with one lookup and no stepping, and
+   keeps inner_wiring_ up to date as ENGINE_CACHED does for single
+   letters. The table is held in TableMemory, so it counts against the
+   process-wide table budget; if it is evicted, or a setting it depends on
+   changes, the machine goes back to ENGINE_CACHED. */
+#define ENGINE_AUTO       -1
+#define ENGINE_DIRECT      0
+#define ENGINE_CACHED      1
+#define ENGINE_TREE        2
+#define ENGINE_AVX2        3
+#define ENGINE_TABLE       4
+#define NUMBER_OF_ENGINES  5
+
+/* The most rotor states a keystroke table may cover, and the row of the
+   states it does not reach. */
+#define TABLE_MAX_STATES   (1 << 26)
+#define TABLE_NO_ROW       0xFFFFFFFFu
+
+template <int ALPHABET_SIZE>
+class BasicEnigma
 {
 public:
+  /* The character coded as letter index 0: 'A' for the 26 letter alphabet
+     and the zero byte for the 256 symbol alphabet. */
+  static const int FIRST_SYMBOL =
+    (ALPHABET_SIZE == ALPHABET_LENGTH) ? ASCII_A : 0;
+
   /* Function to initialise blank enigma machine where
      all the plugboard letters map to themselves,
      all the reflector letters map to themselves
      and there are no rotors. */
-  Enigma();
+  BasicEnigma();
   
   /* Destructor. */
-  ~Enigma();
+  ~BasicEnigma();
 
   /* Function to set up enigma machine with each component being
      set up have the mappings given in the configurations files.
@@ -36,23 +127,247 @@ public:
      which point to c-strings. Each c-string is the name of a configuration 
      file. The order of the names must be 'plugboard file' 'reflector file'
      ['rotor file']* 'position file'.
+     A name starting with BUILTIN_PREFIX ("builtin:") names an entry of
+     the built-in catalog (see 'Catalog.hpp') instead of a file; the
+     catalog only holds components for the 26 letter alphabet.
+     If profiler is not nullptr the parsing of each kind of component is
+     recorded as a separate phase.
+     The engine is chosen as by setEngine(ENGINE_AUTO).
      The function returns an error code corresponding to those in 'errors.h' */
-  int setUp(int number_of_files, char const* const* const configuration_files);
-  
+  int setUp(int number_of_files, char const* const* const configuration_files,
+	    Profiler* profiler = nullptr);
+
+  /* Function to set up enigma machine like setUp above, reading each
+     component's configuration from an input stream instead of a named
+     file, so the settings can be held in memory.
+     settings is a pointer to an array of number_of_settings pointers to
+     input streams, in the same order as the configuration files.
+     setting_names contains the name used for each setting in error
+     messages. */
+  int setUp(int number_of_settings, std::istream* const* const settings,
+	    char const* const* const setting_names,
+	    Profiler* profiler = nullptr);
+
+  /* Function to set up enigma machine from components which have already
+     been checked, such as those of a compiled key sheet, without reading
+     any settings.
+     plugboard and reflector hold the output letter index of every letter.
+     forward_wirings, backward_wirings and notch_masks each point to an
+     array with an entry for each of the number_of_rotors rotors, from
+     the leftmost, which is passed on to Rotor::setUp, and positions holds
+     the starting position of each rotor.
+     If profiler is not nullptr each kind of component is recorded as in
+     setUp above. */
+  int setUp(std::uint8_t const* plugboard, std::uint8_t const* reflector,
+	    int number_of_rotors, std::uint8_t const* const* forward_wirings,
+	    std::uint8_t const* const* backward_wirings,
+	    std::uint64_t const* const* notch_masks, int const* positions,
+	    Profiler* profiler = nullptr);
+
   /* Function to encode or decode a letter. */
   char code(char letter); 
+
+  /* Function to encode or decode length symbols in place, which must all
+     be valid symbols of the alphabet. This is the same as calling code
+     on each of them, but lets the vector engine code whole blocks. */
+  void codeBlock(char* symbols, std::size_t length);
+
+  /* Function to encode or decode a letter given as a zero-based index
+     into the alphabet. Returns the index of the coded letter. */
+  int codeIndex(int letter_index);
+
+  /* Function to encode or decode a letter like code, recording the
+     stepping and the signal path as separate phases in profiler. */
+  char codeProfiled(char letter, Profiler& profiler);
+
+  /* Function to pass a letter index through the plugboard, rotors and
+     reflector at the current rotor positions, without stepping, so the
+     whole permutation of one keystroke can be read off. */
+  int codeSignalPath(int letter_index) const;
+
+  /* Function to turn every rotor to the position given in positions,
+     which must contain one letter index per rotor, from the leftmost
+     rotor to the rightmost. */
+  void setPositions(int const* const positions);
+
+  /* Function to set the ring setting of every rotor to the one given in
+     ring_settings, which must contain one letter index per rotor, from
+     the leftmost rotor to the rightmost (see Rotor::setRingSetting). The
+     positions shown on the rings are unchanged. */
+  void setRingSettings(int const* const ring_settings);
+
+  /* Function to set the ring settings like setRingSettings, reading them
+     from the file named input_file_name, which has the layout of a rotor
+     position file. As in setUp, the name may also name an entry of the
+     built-in catalog.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int setUpRingSettings(char const* const input_file_name);
+
+  /* Function to choose between historical stepping, in which each middle
+     rotor one step before a notch steps itself and its left neighbour on
+     the next keystroke (the double step of the Enigma I), and the default
+     odometer stepping, in which a rotor only steps when its right
+     neighbour steps onto a notch. The leftmost and rightmost rotors step
+     the same way in both. */
+  void setDoubleStepping(bool is_double_stepping);
+
+  /* Function to return true if the rotors double step. */
+  bool isDoubleStepping() const;
+
+  /* The following functions change one setting of a machine which has
+     already been set up, updating only the state that setting affects.
+     They neither allocate memory nor check the components again, so
+     they are cheap enough to call between every few letters. */
+
+  /* Function to plug a cable between the letters with indices
+     first_letter and second_letter, unplugging any cables already
+     plugged into either of them (see Plugboard::swapPlugPair). */
+  void swapPlugPair(int first_letter, int second_letter);
+
+  /* Function to rearrange the rotors. rotor_order must contain a
+     permutation of the rotor indices: the rotor currently at index
+     rotor_order[i] is moved to index i. Each rotor keeps its position. */
+  void setRotorOrder(int const* const rotor_order);
+
+  /* Function to replace the reflector with a copy of reflector, which
+     must already be set up. */
+  void replaceReflector(BasicReflector<ALPHABET_SIZE> const& reflector);
+
+  /* Function to step the rotors as if number_of_keystrokes letters had
+     been coded, without coding anything. */
+  void advance(std::uint64_t number_of_keystrokes);
+
+  /* Function to choose the strategy used to code. ENGINE_AUTO picks one
+     from the number of rotors, expected_length and the features of the
+     processor: ENGINE_DIRECT for messages shorter than half the alphabet,
+     where refreshing inner_wiring_ after a carry costs more than tracing
+     each letter, ENGINE_AVX2 where it is available and otherwise
+     ENGINE_TREE for deep stacks or ENGINE_CACHED. expected_length is the
+     number of symbols which will be coded, or 0 if it is not known.
+     ENGINE_TABLE is never picked, since its table may take a lot of
+     memory.
+     Any other engine is used as given, so they can be compared; choosing
+     ENGINE_TABLE builds its table from the current settings and fails if
+     the table does not fit in the table budget.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int setEngine(int engine, std::uint64_t expected_length = 0);
+
+  /* Function to return the engine in use. */
+  int getEngine() const;
+
+  /* Function to return the name of engine, as accepted by the --engine
+     option. */
+  static char const* getEngineName(int engine);
+
+#ifdef ENIGMA_TRACE
+  /* Function to start recording every keystroke into tracer, or to stop
+     recording if tracer is nullptr. tracer must have been created for
+     this machine's alphabet and number of rotors. */
+  void setTracer(Tracer* tracer);
+#endif
+
+  /* Function to return the number of rotors in the machine. */
+  int getNumberOfRotors() const;
+
+  /* Function to return the plugboard. */
+  BasicPlugboard<ALPHABET_SIZE> const& getPlugboard() const;
+
+  /* Function to return the reflector. */
+  BasicReflector<ALPHABET_SIZE> const& getReflector() const;
+
+  /* Function to return the rotor in rotor_array_ accessed by index.
+     Index 0 is the leftmost (slowest) rotor and index
+     number_of_rotors_ - 1 is the rightmost (fastest) rotor. */
+  BasicRotor<ALPHABET_SIZE> const& getRotor(int rotor_index) const;
   
 private:
-  Plugboard plugboard_;
-  Reflector reflector_;
-  Rotor* rotor_array_;
+  BasicPlugboard<ALPHABET_SIZE> plugboard_;
+  BasicReflector<ALPHABET_SIZE> reflector_;
+  BasicRotor<ALPHABET_SIZE>* rotor_array_;
   int number_of_rotors_;
+  BasicWiring<ALPHABET_SIZE> inner_wiring_;
+  std::vector<BasicWiring<ALPHABET_SIZE>> composition_tree_;
+  int tree_leaves_;
+  bool is_double_stepping_;
+  bool is_double_step_due_;
+  TableMemory table_memory_;
+  std::uint64_t table_states_;
+  std::uint32_t table_rows_;
+  std::uint32_t table_loop_row_;
+  std::uint64_t table_start_state_;
+  int engine_;
+#ifdef ENIGMA_TRACE
+  Tracer* tracer_;
+
+  /* Function to record the signal path of a keystroke, after the rotors
+     have stepped, in tracer_. */
+  void traceKeystroke(int letter_index) const;
+#endif
+
+  /* Function to replace rotor_array_ with number_of_rotors blank
+     rotors. */
+  void createRotors(int number_of_rotors);
+
+  /* Function to size composition_tree_ for the current rotors if
+     is_used is true, or to empty it otherwise. */
+  void resizeCompositionTree(bool is_used);
+
+  /* Function to pass a letter index through every component like
+     codeSignalPath, without using inner_wiring_. */
+  int codeDirectPath(int letter_index) const;
+
+  /* Function to code symbols in blocks of SIMD_BLOCK_LENGTH letters with
+     codeLetterBlockAvx2, returning the number of symbols coded. */
+  std::size_t codeVectorBlocks(char* symbols, std::size_t length);
+
+  /* Function to build the keystroke table for the current settings by
+     stepping through every state the machine reaches from the current
+     one, which it returns to afterwards.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int buildTable();
+
+  /* Function to release the keystroke table, going back to ENGINE_CACHED
+     if ENGINE_TABLE was in use, because the table has been evicted or
+     no longer matches the settings. */
+  void dropTable();
+
+  /* Function to return the index of the current rotor state in the
+     keystroke table, counting the positions as the digits of a number
+     with the leftmost rotor most significant. */
+  std::uint64_t getStateIndex() const;
+
+  /* Function to code symbols with the keystroke table, returning the
+     number of symbols coded: either all of them or, if the table has been
+     evicted or does not cover the current state, none. */
+  std::size_t codeTableBlock(char* symbols, std::size_t length);
+
+  /* Function to copy inner_wiring_ into a vector wiring. */
+  void copyInnerWiring(std::uint8_t* wiring) const;
+
+  /* Function to set up the component configured by the setting accessed
+     by setting_index, out of number_of_settings settings ordered as in
+     setUp, by copying the built-in catalog entry named setting_name.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int setUpBuiltinComponent(int number_of_settings, int setting_index,
+			    char const* const setting_name,
+			    Profiler* profiler);
+
+  /* Function to set up the component configured by the setting accessed
+     by setting_index, out of number_of_settings settings ordered as in
+     setUp, by reading it from in.
+     setting_name is the name of the setting used in error messages.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int setUpComponent(int number_of_settings, int setting_index,
+		     std::istream& in, char const* const setting_name,
+		     Profiler* profiler);
 
   /* Function to position rotors in their starting positions.
+     in is the input stream connected to the configuration file.
      input_file_name is a pointer to a c-string containing the 
      name of the configuration file. 
      The function returns an error code corresponding to those in 'errors.h' */
-  int positionRotors(char const* const input_file_name);
+  int positionRotors(std::istream& in, char const* const input_file_name);
 
   /* Function to check and extract rotor positions from configuration file.
      positions is a pointer to an empty integer array which will be filled up
@@ -61,7 +376,7 @@ private:
      file_name is a pointer to a c-string containing the name of the 
      configuration file.
      The function returns an error code corresponding to those in 'errors.h' */
-  int readRotorPositions(int* const positions, std::ifstream& in,
+  int readRotorPositions(int* const positions, std::istream& in,
 			 char const* const file_name) const;
 
   /* Function to check if rotor position is a numeric character.
@@ -73,15 +388,26 @@ private:
 		   char const* const file_name) const;
 
   /* Function to check if rotor position is a valid index between 
-     0 and 25.
+     0 and ALPHABET_SIZE - 1.
      letter_index is the number to be checked.
      file_name is a pointer to a c-string containing the name of the
      configuration file.  
      The function returns an error code corresponding to those in 'errors.h' */
   int checkIndex(int letter_index, char const* const file_name) const;
 
-  /* Function to rotate rotors in rotor_array_. */
-  void rotateRotors();
+  /* Function to rotate rotors in rotor_array_. Returns true if a carry
+     changed inner_wiring_, false otherwise. */
+  bool rotateRotors();
+
+  /* Functions to step the rotors to the left of the rightmost one, which
+     has just stepped, when it has stepped onto a notch or a double step
+     is due, without and with double stepping. They return the index of
+     the leftmost rotor moved. */
+  int rotateSlowerRotors();
+  int rotateSlowerRotorsDoubleStepping();
+
+  /* Function to set is_double_step_due_ from the current positions. */
+  void updateDoubleStep();
 
   /* Function to check if any notch on the current rotor matches the letter at
      the top of the rotor. If it does, the next rotor is rotated and true is 
@@ -89,6 +415,29 @@ private:
      rotor_index is the index into the rotor_array_ which contains the rotor 
      to be checked, not the rotor to be rotated. */
   bool rotateSingleRotor(int rotor_index);
+
+  /* Function to recalculate inner_wiring_ from the current positions of
+     every rotor except the rightmost one. */
+  void updateInnerWiring();
+
+  /* Function to recalculate inner_wiring_ after a carry which moved the
+     rotors from first_moved_rotor to number_of_rotors_ - 2. */
+  void updateInnerWiring(int first_moved_rotor);
+
+  /* Function to set the leaf of composition_tree_ for the rotor accessed
+     by index to the forward mapping of the rotor at its position. */
+  void setTreeLeaf(int rotor_index);
+
+  /* Function to set a node of composition_tree_ to the composition of
+     its two children. */
+  void composeTreeNode(int node);
+
+  /* Function to calculate inner_wiring_ from the root of
+     composition_tree_ and the reflector. */
+  void updateInnerWiringFromTree();
 };
 
+typedef BasicEnigma<ALPHABET_LENGTH> Enigma;
+typedef BasicEnigma<BYTE_ALPHABET_LENGTH> ByteEnigma;
+
 #endif
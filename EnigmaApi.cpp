@@ -0,0 +1,291 @@
+/* This file contains the definitions of the functions of the
+   C interface declared in 'enigma.h' */
+
+#include "enigma.h"
+#include "Enigma.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* A machine created through the C interface. Exactly one of letters and
+   bytes points to the Enigma object, depending on the alphabet.
+   starting_positions contains the rotor positions the machine was
+   created with, from the leftmost rotor to the rightmost.
+   keystroke is the number of symbols coded since the starting
+   positions. */
+struct enigma_machine
+{
+  Enigma* letters;
+  ByteEnigma* bytes;
+  vector<int> starting_positions;
+  uint64_t keystroke;
+};
+
+namespace {
+  /* Function to set up enigma from the settings passed to enigma_create
+     and record its starting positions in machine.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  template <int ALPHABET_SIZE>
+  int setUpMachine(BasicEnigma<ALPHABET_SIZE>& enigma,
+		   enigma_machine& machine,
+		   char const* plugboard, char const* reflector,
+		   char const* const* rotors, int number_of_rotors,
+		   char const* positions)
+  {
+    int number_of_settings = number_of_rotors + 3;
+    vector<istringstream> settings(number_of_settings);
+    vector<string> names(number_of_settings);
+
+    settings[0].str(plugboard);
+    names[0] = "plugboard settings";
+    settings[1].str(reflector);
+    names[1] = "reflector settings";
+    for (int i = 0; i < number_of_rotors; i++) {
+      settings[i + 2].str(rotors[i]);
+      names[i + 2] = "rotor " + to_string(i) + " settings";
+    }
+    settings[number_of_settings - 1].str(positions);
+    names[number_of_settings - 1] = "rotor position settings";
+
+    vector<istream*> setting_pointers(number_of_settings);
+    vector<char const*> setting_names(number_of_settings);
+    for (int i = 0; i < number_of_settings; i++) {
+      setting_pointers[i] = &settings[i];
+      setting_names[i] = names[i].c_str();
+    }
+
+    int error_code = enigma.setUp(number_of_settings,
+				  setting_pointers.data(),
+				  setting_names.data());
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
+
+    machine.starting_positions.resize(number_of_rotors);
+    for (int i = 0; i < number_of_rotors; i++) {
+      machine.starting_positions[i] = enigma.getRotor(i).getTopLetter();
+    }
+    return NO_ERROR;
+  }
+
+  /* Function to code length symbols from input into output with enigma,
+     counting them in machine.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  template <int ALPHABET_SIZE>
+  int codeSymbols(BasicEnigma<ALPHABET_SIZE>& enigma,
+		  enigma_machine& machine,
+		  char const* input, char* output, size_t length)
+  {
+    int error_code = NO_ERROR;
+    size_t i = 0;
+    for (; i < length; i++) {
+      char next = input[i];
+      if (ALPHABET_SIZE == ALPHABET_LENGTH &&
+	  (next < ASCII_A || next > ASCII_Z)) {
+	error_code = INVALID_INPUT_CHARACTER;
+	break;
+      }
+      output[i] = next;
+    }
+    enigma.codeBlock(output, i);
+    machine.keystroke += i;
+    return error_code;
+  }
+
+  /* Function to move enigma to the state reached after keystroke symbols
+     from the starting positions recorded in machine. */
+  template <int ALPHABET_SIZE>
+  void seekMachine(BasicEnigma<ALPHABET_SIZE>& enigma,
+		   enigma_machine& machine, uint64_t keystroke)
+  {
+    if (keystroke < machine.keystroke) {
+      enigma.setPositions(machine.starting_positions.data());
+      machine.keystroke = 0;
+    }
+    enigma.advance(keystroke - machine.keystroke);
+    machine.keystroke = keystroke;
+  }
+
+  /* Function to copy the rotor positions of enigma into positions. */
+  template <int ALPHABET_SIZE>
+  void savePositions(BasicEnigma<ALPHABET_SIZE> const& enigma,
+		     uint8_t* positions)
+  {
+    for (int i = 0; i < enigma.getNumberOfRotors(); i++) {
+      positions[i] = enigma.getRotor(i).getTopLetter();
+    }
+  }
+
+  /* Function to turn the rotors of enigma to positions, checking each
+     position is a letter of the alphabet.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  template <int ALPHABET_SIZE>
+  int restorePositions(BasicEnigma<ALPHABET_SIZE>& enigma,
+		       uint8_t const* positions)
+  {
+    vector<int> letter_indices(enigma.getNumberOfRotors());
+    for (size_t i = 0; i < letter_indices.size(); i++) {
+      if (positions[i] >= ALPHABET_SIZE) {
+	return INVALID_ARGUMENT;
+      }
+      letter_indices[i] = positions[i];
+    }
+    enigma.setPositions(letter_indices.data());
+    return NO_ERROR;
+  }
+}
+
+int enigma_create(int alphabet_size, char const* plugboard,
+		  char const* reflector, char const* const* rotors,
+		  int number_of_rotors, char const* positions,
+		  enigma_machine** machine)
+{
+  if (machine == nullptr) {
+    return INVALID_ARGUMENT;
+  }
+  *machine = nullptr;
+
+  if ((alphabet_size != ENIGMA_LETTERS && alphabet_size != ENIGMA_BYTES) ||
+      plugboard == nullptr || reflector == nullptr || positions == nullptr ||
+      number_of_rotors < 0 || (number_of_rotors > 0 && rotors == nullptr)) {
+    return INVALID_ARGUMENT;
+  }
+  for (int i = 0; i < number_of_rotors; i++) {
+    if (rotors[i] == nullptr) {
+      return INVALID_ARGUMENT;
+    }
+  }
+
+  auto created = new (nothrow) enigma_machine();
+  if (created == nullptr) {
+    return OUT_OF_MEMORY;
+  }
+
+  // No exception may leave a C function, so running out of memory while
+  // setting the machine up is reported as an error code.
+  int error_code;
+  try {
+    if (alphabet_size == ENIGMA_LETTERS) {
+      created->letters = new Enigma();
+      error_code = setUpMachine(*created->letters, *created, plugboard,
+				reflector, rotors, number_of_rotors,
+				positions);
+    } else {
+      created->bytes = new ByteEnigma();
+      error_code = setUpMachine(*created->bytes, *created, plugboard,
+				reflector, rotors, number_of_rotors,
+				positions);
+    }
+  } catch (bad_alloc const&) {
+    error_code = OUT_OF_MEMORY;
+  }
+
+  if (error_code != NO_ERROR) {
+    enigma_destroy(created);
+    return error_code;
+  }
+
+  *machine = created;
+  return NO_ERROR;
+}
+
+int enigma_code(enigma_machine* machine, char const* input, char* output,
+		size_t length)
+{
+  if (machine == nullptr || input == nullptr || output == nullptr) {
+    return INVALID_ARGUMENT;
+  }
+
+  if (machine->letters != nullptr) {
+    return codeSymbols(*machine->letters, *machine, input, output, length);
+  }
+  return codeSymbols(*machine->bytes, *machine, input, output, length);
+}
+
+int enigma_seek(enigma_machine* machine, uint64_t keystroke)
+{
+  if (machine == nullptr) {
+    return INVALID_ARGUMENT;
+  }
+
+  if (machine->letters != nullptr) {
+    seekMachine(*machine->letters, *machine, keystroke);
+  } else {
+    seekMachine(*machine->bytes, *machine, keystroke);
+  }
+  return NO_ERROR;
+}
+
+uint64_t enigma_tell(enigma_machine const* machine)
+{
+  return (machine != nullptr) ? machine->keystroke : 0;
+}
+
+size_t enigma_state_size(enigma_machine const* machine)
+{
+  if (machine == nullptr) {
+    return 0;
+  }
+  return sizeof(uint64_t) + machine->starting_positions.size();
+}
+
+int enigma_save_state(enigma_machine const* machine, void* state)
+{
+  if (machine == nullptr || state == nullptr) {
+    return INVALID_ARGUMENT;
+  }
+
+  // The state is the keystroke count followed by one byte per rotor.
+  auto bytes = static_cast<uint8_t*>(state);
+  memcpy(bytes, &machine->keystroke, sizeof(uint64_t));
+  if (machine->letters != nullptr) {
+    savePositions(*machine->letters, bytes + sizeof(uint64_t));
+  } else {
+    savePositions(*machine->bytes, bytes + sizeof(uint64_t));
+  }
+  return NO_ERROR;
+}
+
+int enigma_restore_state(enigma_machine* machine, void const* state)
+{
+  if (machine == nullptr || state == nullptr) {
+    return INVALID_ARGUMENT;
+  }
+
+  auto bytes = static_cast<uint8_t const*>(state);
+  int error_code;
+  try {
+    error_code = (machine->letters != nullptr)
+      ? restorePositions(*machine->letters, bytes + sizeof(uint64_t))
+      : restorePositions(*machine->bytes, bytes + sizeof(uint64_t));
+  } catch (bad_alloc const&) {
+    error_code = OUT_OF_MEMORY;
+  }
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  memcpy(&machine->keystroke, bytes, sizeof(uint64_t));
+  return NO_ERROR;
+}
+
+void enigma_destroy(enigma_machine* machine)
+{
+  if (machine != nullptr) {
+    delete machine->letters;
+    delete machine->bytes;
+    delete machine;
+  }
+}
@@ -0,0 +1,304 @@
+/* This file contains the member function definitions
+   for the EnigmaCursor class template */
+
+#include "EnigmaCursor.hpp"
+#include "EnigmaSpec.hpp"
+#include "Enigma.hpp"
+#include "Plugboard.hpp"
+#include "Rotor.hpp"
+#include "Wiring.hpp"
+#include "constants.h"
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+template <int ALPHABET_SIZE>
+BasicEnigmaCursor<ALPHABET_SIZE>::BasicEnigmaCursor(
+    BasicEnigmaSpec<ALPHABET_SIZE> const& spec) :
+  spec_(&spec),
+  positions_(nullptr),
+  inline_positions_(),
+  inner_wiring_(spec.getStartingInnerWiring()),
+  is_double_step_due_(false)
+{
+  allocatePositions();
+  for (int i = 0; i < spec_->getNumberOfRotors(); i++) {
+    positions_[i] = spec_->getStartingPosition(i);
+  }
+  updateDoubleStep();
+}
+
+template <int ALPHABET_SIZE>
+BasicEnigmaCursor<ALPHABET_SIZE>::BasicEnigmaCursor(
+    BasicEnigmaCursor const& other) :
+  spec_(other.spec_),
+  positions_(nullptr),
+  inline_positions_(),
+  inner_wiring_(other.inner_wiring_),
+  is_double_step_due_(other.is_double_step_due_)
+{
+  allocatePositions();
+  for (int i = 0; i < spec_->getNumberOfRotors(); i++) {
+    positions_[i] = other.positions_[i];
+  }
+}
+
+template <int ALPHABET_SIZE>
+BasicEnigmaCursor<ALPHABET_SIZE>&
+BasicEnigmaCursor<ALPHABET_SIZE>::operator=(BasicEnigmaCursor const& other)
+{
+  if (this != &other) {
+    if (positions_ != inline_positions_) {
+      delete [] positions_;
+    }
+    spec_ = other.spec_;
+    allocatePositions();
+    for (int i = 0; i < spec_->getNumberOfRotors(); i++) {
+      positions_[i] = other.positions_[i];
+    }
+    inner_wiring_ = other.inner_wiring_;
+    is_double_step_due_ = other.is_double_step_due_;
+  }
+  return *this;
+}
+
+template <int ALPHABET_SIZE>
+BasicEnigmaCursor<ALPHABET_SIZE>::~BasicEnigmaCursor()
+{
+  if (positions_ != inline_positions_) {
+    delete [] positions_;
+  }
+}
+
+template <int ALPHABET_SIZE>
+char BasicEnigmaCursor<ALPHABET_SIZE>::code(char letter)
+{
+  int first_symbol = BasicEnigma<ALPHABET_SIZE>::FIRST_SYMBOL;
+  int letter_index = static_cast<unsigned char>(letter) - first_symbol;
+
+  return static_cast<char>(codeIndex(letter_index) + first_symbol);
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigmaCursor<ALPHABET_SIZE>::codeIndex(int letter_index)
+{
+  rotateRotors();
+
+  letter_index = spec_->getPlugboard().getPlugboardLetter(letter_index);
+
+  int number_of_rotors = spec_->getNumberOfRotors();
+  if (number_of_rotors > 0) {
+    BasicRotor<ALPHABET_SIZE> const& fast_rotor =
+      spec_->getRotor(number_of_rotors - 1);
+    int position = positions_[number_of_rotors - 1];
+    letter_index = fast_rotor.getForwardRotorLetter(letter_index, position);
+    letter_index = inner_wiring_.getOutputLetter(letter_index);
+    letter_index = fast_rotor.getBackwardRotorLetter(letter_index, position);
+  } else {
+    letter_index = inner_wiring_.getOutputLetter(letter_index);
+  }
+
+  return spec_->getPlugboard().getPlugboardLetter(letter_index);
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigmaCursor<ALPHABET_SIZE>::getPosition(int rotor_index) const
+{
+  return positions_[rotor_index];
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaCursor<ALPHABET_SIZE>::setPositions(
+    int const* const positions)
+{
+  for (int i = 0; i < spec_->getNumberOfRotors(); i++) {
+    positions_[i] = positions[i];
+  }
+  updateDoubleStep();
+  spec_->getInnerWiring(positions_, inner_wiring_);
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaCursor<ALPHABET_SIZE>::advance(uint64_t number_of_keystrokes)
+{
+  int number_of_rotors = spec_->getNumberOfRotors();
+  if (number_of_rotors == 0 || number_of_keystrokes == 0) {
+    return;
+  }
+
+  int fast_index = number_of_rotors - 1;
+  if (!spec_->isDoubleStepping()) {
+    // Without double stepping the rotors are an odometer: each rotor
+    // moves once for every time its right neighbour lands on a notch, so
+    // the moves of each rotor are counted from those of the one before.
+    uint64_t moves = number_of_keystrokes;
+    for (int i = fast_index; i >= 0 && moves > 0; i--) {
+      uint64_t carries = (i > 0) ? countNotchLandings(i, moves) : 0;
+      positions_[i] = (positions_[i] + moves % ALPHABET_SIZE) % ALPHABET_SIZE;
+      moves = carries;
+    }
+    spec_->getInnerWiring(positions_, inner_wiring_);
+    return;
+  }
+
+  while (number_of_keystrokes > 0) {
+    // Between carries only the fastest rotor moves, so it is turned
+    // straight to one step before the next notch it will land on.
+    if (number_of_rotors > 1 && !is_double_step_due_) {
+      uint64_t free_steps =
+	min(getNotchDistance(fast_index) - 1, number_of_keystrokes);
+      positions_[fast_index] =
+	(positions_[fast_index] + free_steps) % ALPHABET_SIZE;
+      number_of_keystrokes -= free_steps;
+      if (number_of_keystrokes == 0) {
+	break;
+      }
+    }
+    rotatePositions();
+    number_of_keystrokes--;
+  }
+
+  spec_->getInnerWiring(positions_, inner_wiring_);
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaCursor<ALPHABET_SIZE>::getPermutation(
+    uint8_t* permutation) const
+{
+  BasicPlugboard<ALPHABET_SIZE> const& plugboard = spec_->getPlugboard();
+  int number_of_rotors = spec_->getNumberOfRotors();
+  for (int letter_index = 0; letter_index < ALPHABET_SIZE; letter_index++) {
+    int output_index = plugboard.getPlugboardLetter(letter_index);
+    if (number_of_rotors > 0) {
+      BasicRotor<ALPHABET_SIZE> const& fast_rotor =
+	spec_->getRotor(number_of_rotors - 1);
+      int position = positions_[number_of_rotors - 1];
+      output_index = fast_rotor.getForwardRotorLetter(output_index, position);
+      output_index = inner_wiring_.getOutputLetter(output_index);
+      output_index = fast_rotor.getBackwardRotorLetter(output_index,
+						       position);
+    } else {
+      output_index = inner_wiring_.getOutputLetter(output_index);
+    }
+    permutation[letter_index] = plugboard.getPlugboardLetter(output_index);
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaCursor<ALPHABET_SIZE>::rotateRotors()
+{
+  if (rotatePositions()) {
+    spec_->getInnerWiring(positions_, inner_wiring_);
+  }
+}
+
+template <int ALPHABET_SIZE>
+bool BasicEnigmaCursor<ALPHABET_SIZE>::rotatePositions()
+{
+  int number_of_rotors = spec_->getNumberOfRotors();
+  if (number_of_rotors == 0) {
+    return false;
+  }
+
+  int fast_index = number_of_rotors - 1;
+  positions_[fast_index] = (positions_[fast_index] + 1) % ALPHABET_SIZE;
+
+  // The same carries as Enigma::rotateRotors: each rotor which steps onto
+  // a notch steps its left neighbour.
+  if (number_of_rotors > 1 &&
+      (spec_->getRotor(fast_index).isNotch(positions_[fast_index])
+       || is_double_step_due_)) {
+    if (spec_->isDoubleStepping()) {
+      rotateSlowerRotorsDoubleStepping();
+      return true;
+    }
+
+    int i = fast_index - 1;
+    positions_[i] = (positions_[i] + 1) % ALPHABET_SIZE;
+    for (; i > 0 && spec_->getRotor(i).isNotch(positions_[i]); i--) {
+      positions_[i - 1] = (positions_[i - 1] + 1) % ALPHABET_SIZE;
+    }
+    return true;
+  }
+  return false;
+}
+
+template <int ALPHABET_SIZE>
+uint64_t BasicEnigmaCursor<ALPHABET_SIZE>::getNotchDistance(
+    int rotor_index) const
+{
+  BasicRotor<ALPHABET_SIZE> const& rotor = spec_->getRotor(rotor_index);
+  uint64_t distance = ALPHABET_SIZE;
+  for (int i = 0; i < rotor.getNumberOfNotches(); i++) {
+    uint64_t notch_distance = (rotor.getNotch(i) - positions_[rotor_index]
+			       + ALPHABET_SIZE - 1) % ALPHABET_SIZE + 1;
+    distance = min(distance, notch_distance);
+  }
+  return distance;
+}
+
+template <int ALPHABET_SIZE>
+uint64_t BasicEnigmaCursor<ALPHABET_SIZE>::countNotchLandings(
+    int rotor_index,
+    uint64_t moves) const
+{
+  BasicRotor<ALPHABET_SIZE> const& rotor = spec_->getRotor(rotor_index);
+  uint64_t landings = 0;
+  for (int i = 0; i < rotor.getNumberOfNotches(); i++) {
+    uint64_t first_landing = (rotor.getNotch(i) - positions_[rotor_index]
+			      + ALPHABET_SIZE - 1) % ALPHABET_SIZE + 1;
+    if (moves >= first_landing) {
+      landings += 1 + (moves - first_landing) / ALPHABET_SIZE;
+    }
+  }
+  return landings;
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaCursor<ALPHABET_SIZE>::rotateSlowerRotorsDoubleStepping()
+{
+  int fast_index = spec_->getNumberOfRotors() - 1;
+  bool is_carrying =
+    spec_->getRotor(fast_index).isNotch(positions_[fast_index]);
+  is_double_step_due_ = false;
+
+  for (int i = fast_index - 1; i >= 0; i--) {
+    BasicRotor<ALPHABET_SIZE> const& rotor = spec_->getRotor(i);
+    int next_position = (positions_[i] + 1) % ALPHABET_SIZE;
+    if (is_carrying || (i > 0 && rotor.isNotch(next_position))) {
+      positions_[i] = next_position;
+      next_position = (positions_[i] + 1) % ALPHABET_SIZE;
+      is_carrying = rotor.isNotch(positions_[i]);
+    } else {
+      is_carrying = false;
+    }
+    if (i > 0 && rotor.isNotch(next_position)) {
+      is_double_step_due_ = true;
+    }
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaCursor<ALPHABET_SIZE>::updateDoubleStep()
+{
+  is_double_step_due_ = false;
+  if (spec_->isDoubleStepping()) {
+    for (int i = 1; i < spec_->getNumberOfRotors() - 1; i++) {
+      if (spec_->getRotor(i).isNotch((positions_[i] + 1) % ALPHABET_SIZE)) {
+	is_double_step_due_ = true;
+      }
+    }
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaCursor<ALPHABET_SIZE>::allocatePositions()
+{
+  int number_of_rotors = spec_->getNumberOfRotors();
+  positions_ = (number_of_rotors <= CURSOR_INLINE_ROTORS)
+    ? inline_positions_ : new uint8_t[number_of_rotors];
+}
+
+template class BasicEnigmaCursor<ALPHABET_LENGTH>;
+template class BasicEnigmaCursor<BYTE_ALPHABET_LENGTH>;
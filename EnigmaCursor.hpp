@@ -0,0 +1,108 @@
+#ifndef ENIGMA_CURSOR_H
+#define ENIGMA_CURSOR_H
+
+/* The EnigmaCursor class template codes a stream with the configuration
+   held in an EnigmaSpec. It only holds the state which changes while
+   coding: the rotor positions and the inner wiring for them. Creating a
+   cursor copies the starting positions and the starting inner wiring
+   from the spec and, for up to CURSOR_INLINE_ROTORS rotors, allocates no
+   memory, so a cursor can be made for every message.
+   Cursors never change their spec, so any number of them can share one
+   spec across threads; each cursor must only be used by one thread at a
+   time.
+   spec_ points to the configuration being used, which must outlive the
+   cursor.
+   positions_ points to the position of each rotor, from the leftmost
+   rotor to the rightmost. It points into inline_positions_ when the
+   rotors fit there and to an array on the heap otherwise.
+   inner_wiring_ contains the inner wiring for positions_.
+   is_double_step_due_ is true if a double step is due on the next
+   keystroke (see Enigma).
+   EnigmaCursor codes with an EnigmaSpec and ByteEnigmaCursor with a
+   ByteEnigmaSpec. */
+
+#include "EnigmaSpec.hpp"
+#include "Wiring.hpp"
+#include "constants.h"
+#include <cstdint>
+
+template <int ALPHABET_SIZE>
+class BasicEnigmaCursor
+{
+public:
+  /* Function to initialise cursor at the starting positions of spec. */
+  explicit BasicEnigmaCursor(BasicEnigmaSpec<ALPHABET_SIZE> const& spec);
+
+  /* Copy constructor and assignment, which copy the positions. */
+  BasicEnigmaCursor(BasicEnigmaCursor const& other);
+  BasicEnigmaCursor& operator=(BasicEnigmaCursor const& other);
+
+  /* Destructor. */
+  ~BasicEnigmaCursor();
+
+  /* Function to encode or decode a letter. */
+  char code(char letter);
+
+  /* Function to encode or decode a letter given as a zero-based index
+     into the alphabet. Returns the index of the coded letter. */
+  int codeIndex(int letter_index);
+
+  /* Function to return the position of the rotor accessed by index. */
+  int getPosition(int rotor_index) const;
+
+  /* Function to turn every rotor to the position given in positions,
+     from the leftmost rotor to the rightmost. */
+  void setPositions(int const* const positions);
+
+  /* Function to step the rotors as if number_of_keystrokes letters had
+     been coded, without coding them. Without double stepping the moves
+     of each rotor are counted from the notches, so any distance costs
+     the same; with it, the fastest rotor is turned straight to its next
+     notch, so skipping costs about one step for each carry. The inner
+     wiring is only worked out once at the end. */
+  void advance(std::uint64_t number_of_keystrokes);
+
+  /* Function to set permutation, which holds ALPHABET_SIZE entries, to
+     the letter indices every letter would be coded to at the current
+     positions, including the plugboard, without stepping. */
+  void getPermutation(std::uint8_t* permutation) const;
+
+private:
+  BasicEnigmaSpec<ALPHABET_SIZE> const* spec_;
+  std::uint8_t* positions_;
+  std::uint8_t inline_positions_[CURSOR_INLINE_ROTORS];
+  BasicWiring<ALPHABET_SIZE> inner_wiring_;
+  bool is_double_step_due_;
+
+  /* Function to step the rotors like Enigma does. */
+  void rotateRotors();
+
+  /* Function to step the rotor positions like rotateRotors without
+     updating the inner wiring. Returns true if any rotor other than the
+     rightmost one moved. */
+  bool rotatePositions();
+
+  /* Function to return how many steps the rotor accessed by index will
+     take to land on its next notch, or ALPHABET_SIZE if it has none. */
+  std::uint64_t getNotchDistance(int rotor_index) const;
+
+  /* Function to return how many times the rotor accessed by index lands
+     on a notch when it moves moves steps from its position. */
+  std::uint64_t countNotchLandings(int rotor_index,
+				   std::uint64_t moves) const;
+
+  /* Function to step the rotors to the left of the rightmost one like
+     Enigma does when double stepping. */
+  void rotateSlowerRotorsDoubleStepping();
+
+  /* Function to set is_double_step_due_ from positions_. */
+  void updateDoubleStep();
+
+  /* Function to point positions_ at storage for the rotors of spec_. */
+  void allocatePositions();
+};
+
+typedef BasicEnigmaCursor<ALPHABET_LENGTH> EnigmaCursor;
+typedef BasicEnigmaCursor<BYTE_ALPHABET_LENGTH> ByteEnigmaCursor;
+
+#endif
@@ -0,0 +1,108 @@
+/* This file contains the member function definitions
+   for the EnigmaSpec class template */
+
+#include "EnigmaSpec.hpp"
+#include "Enigma.hpp"
+#include "Plugboard.hpp"
+#include "Reflector.hpp"
+#include "Rotor.hpp"
+#include "Wiring.hpp"
+#include "constants.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+template <int ALPHABET_SIZE>
+BasicEnigmaSpec<ALPHABET_SIZE>::BasicEnigmaSpec(
+    BasicEnigma<ALPHABET_SIZE> const& enigma) :
+  plugboard_(enigma.getPlugboard()),
+  reflector_(enigma.getReflector()),
+  rotors_(),
+  starting_positions_(),
+  starting_inner_wiring_(BasicWiring<ALPHABET_SIZE>()),
+  is_double_stepping_(enigma.isDoubleStepping())
+{
+  for (int i = 0; i < enigma.getNumberOfRotors(); i++) {
+    rotors_.push_back(enigma.getRotor(i));
+    starting_positions_.push_back(enigma.getRotor(i).getTopLetter());
+  }
+  getInnerWiring(starting_positions_.data(), starting_inner_wiring_);
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigmaSpec<ALPHABET_SIZE>::getNumberOfRotors() const
+{
+  return rotors_.size();
+}
+
+template <int ALPHABET_SIZE>
+int BasicEnigmaSpec<ALPHABET_SIZE>::getStartingPosition(int rotor_index) const
+{
+  return starting_positions_[rotor_index];
+}
+
+template <int ALPHABET_SIZE>
+bool BasicEnigmaSpec<ALPHABET_SIZE>::isDoubleStepping() const
+{
+  return is_double_stepping_;
+}
+
+template <int ALPHABET_SIZE>
+BasicWiring<ALPHABET_SIZE> const&
+BasicEnigmaSpec<ALPHABET_SIZE>::getStartingInnerWiring() const
+{
+  return starting_inner_wiring_;
+}
+
+template <int ALPHABET_SIZE>
+BasicPlugboard<ALPHABET_SIZE> const&
+BasicEnigmaSpec<ALPHABET_SIZE>::getPlugboard() const
+{
+  return plugboard_;
+}
+
+template <int ALPHABET_SIZE>
+BasicRotor<ALPHABET_SIZE> const&
+BasicEnigmaSpec<ALPHABET_SIZE>::getRotor(int rotor_index) const
+{
+  return rotors_[rotor_index];
+}
+
+template <int ALPHABET_SIZE>
+void BasicEnigmaSpec<ALPHABET_SIZE>::getInnerWiring(
+    uint8_t const* positions,
+    BasicWiring<ALPHABET_SIZE>& inner_wiring) const
+{
+  int number_of_rotors = rotors_.size();
+  bool is_mapped[ALPHABET_SIZE] = {};
+
+  // As in Enigma, the inner path pairs letters up, so each pair is only
+  // traced once.
+  for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+    if (is_mapped[letter]) {
+      continue;
+    }
+
+    int letter_index = letter;
+    for (int i = number_of_rotors - 2; i >= 0; i--) {
+      letter_index = rotors_[i].getForwardRotorLetter(letter_index,
+						      positions[i]);
+    }
+
+    letter_index = reflector_.getReflectorLetter(letter_index);
+
+    for (int i = 0; i < number_of_rotors - 1; i++) {
+      letter_index = rotors_[i].getBackwardRotorLetter(letter_index,
+						       positions[i]);
+    }
+
+    inner_wiring.setOutputLetter(letter, letter_index);
+    inner_wiring.setOutputLetter(letter_index, letter);
+    is_mapped[letter] = true;
+    is_mapped[letter_index] = true;
+  }
+}
+
+template class BasicEnigmaSpec<ALPHABET_LENGTH>;
+template class BasicEnigmaSpec<BYTE_ALPHABET_LENGTH>;
@@ -0,0 +1,76 @@
+#ifndef ENIGMA_SPEC_H
+#define ENIGMA_SPEC_H
+
+/* The EnigmaSpec class template is an immutable copy of the
+   configuration of an Enigma machine: its plugboard, reflector, rotor
+   wirings and notches, and the starting positions of the rotors. It holds
+   no state which changes while coding, so one EnigmaSpec can be shared
+   by any number of EnigmaCursor objects, each coding its own stream on
+   its own thread, without locking and without copying the wirings.
+   plugboard_, reflector_ and rotors_ are copies of the components of the
+   machine the spec was taken from. The positions of the rotor copies are
+   ignored; cursors look them up at their own positions.
+   starting_positions_ contains the rotor positions the machine was at.
+   starting_inner_wiring_ is the inner wiring (see Enigma) for the
+   starting positions, so new cursors need not work it out.
+   is_double_stepping_ is true if the rotors double step (see
+   Enigma::setDoubleStepping).
+   EnigmaSpec is taken from an Enigma and ByteEnigmaSpec from a
+   ByteEnigma. */
+
+#include "Enigma.hpp"
+#include "Plugboard.hpp"
+#include "Reflector.hpp"
+#include "Rotor.hpp"
+#include "Wiring.hpp"
+#include "constants.h"
+#include <cstdint>
+#include <vector>
+
+template <int ALPHABET_SIZE>
+class BasicEnigmaSpec
+{
+public:
+  /* Function to copy the configuration of enigma, which must be set up.
+     Its current rotor positions become the starting positions. */
+  explicit BasicEnigmaSpec(BasicEnigma<ALPHABET_SIZE> const& enigma);
+
+  /* Function to return the number of rotors. */
+  int getNumberOfRotors() const;
+
+  /* Function to return the starting position of the rotor accessed by
+     index. */
+  int getStartingPosition(int rotor_index) const;
+
+  /* Function to return true if the rotors double step. */
+  bool isDoubleStepping() const;
+
+  /* Function to return the inner wiring for the starting positions. */
+  BasicWiring<ALPHABET_SIZE> const& getStartingInnerWiring() const;
+
+  /* Function to return the plugboard. */
+  BasicPlugboard<ALPHABET_SIZE> const& getPlugboard() const;
+
+  /* Function to return the rotor accessed by index, with index 0 the
+     leftmost (slowest) rotor. */
+  BasicRotor<ALPHABET_SIZE> const& getRotor(int rotor_index) const;
+
+  /* Function to set inner_wiring to the combined mapping from the
+     rightmost rotor through every slower rotor, the reflector and back
+     when the rotors are at positions. */
+  void getInnerWiring(std::uint8_t const* positions,
+		      BasicWiring<ALPHABET_SIZE>& inner_wiring) const;
+
+private:
+  BasicPlugboard<ALPHABET_SIZE> plugboard_;
+  BasicReflector<ALPHABET_SIZE> reflector_;
+  std::vector<BasicRotor<ALPHABET_SIZE>> rotors_;
+  std::vector<std::uint8_t> starting_positions_;
+  BasicWiring<ALPHABET_SIZE> starting_inner_wiring_;
+  bool is_double_stepping_;
+};
+
+typedef BasicEnigmaSpec<ALPHABET_LENGTH> EnigmaSpec;
+typedef BasicEnigmaSpec<BYTE_ALPHABET_LENGTH> ByteEnigmaSpec;
+
+#endif
@@ -0,0 +1,253 @@
+/* This file contains the member function definitions
+   for the FileCoder class template */
+
+#include "FileCoder.hpp"
+#include "Enigma.hpp"
+#include "IoRing.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+template <int ALPHABET_SIZE>
+BasicFileCoder<ALPHABET_SIZE>::BasicFileCoder(
+    BasicEnigma<ALPHABET_SIZE>& enigma) :
+  enigma_(enigma),
+  starting_positions_(enigma.getNumberOfRotors()),
+  memory_(),
+  blocks_(PIPELINE_DEPTH),
+  ring_()
+{
+  for (size_t i = 0; i < starting_positions_.size(); i++) {
+    starting_positions_[i] = enigma.getRotor(i).getTopLetter();
+  }
+  setUpBlocks();
+}
+
+template <int ALPHABET_SIZE>
+int BasicFileCoder<ALPHABET_SIZE>::codeFile(char const* input_file_name,
+					    char const* output_file_name)
+{
+  int input_fd = open(input_file_name, O_RDONLY | O_CLOEXEC);
+  struct stat input_status;
+  if (input_fd < 0 || fstat(input_fd, &input_status) != 0
+      || !S_ISREG(input_status.st_mode)) {
+    cerr << "Error opening input file " << input_file_name << endl;
+    if (input_fd >= 0) {
+      close(input_fd);
+    }
+    return ERROR_READING_OR_WRITING_FILE;
+  }
+
+  int output_fd = open(output_file_name,
+		       O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (output_fd < 0) {
+    cerr << "Error opening output file " << output_file_name << endl;
+    close(input_fd);
+    return ERROR_READING_OR_WRITING_FILE;
+  }
+
+  enigma_.setPositions(starting_positions_.data());
+  int error_code = codeOpenFile(input_fd, input_status.st_size, output_fd,
+				input_file_name, output_file_name);
+
+  close(input_fd);
+  if (close(output_fd) != 0 && error_code == NO_ERROR) {
+    cerr << "Error writing output file " << output_file_name << endl;
+    error_code = ERROR_READING_OR_WRITING_FILE;
+  }
+  return error_code;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicFileCoder<ALPHABET_SIZE>::isUsingUring() const
+{
+  return ring_.isUsingUring();
+}
+
+template <int ALPHABET_SIZE>
+int BasicFileCoder<ALPHABET_SIZE>::codeOpenFile(int input_fd,
+						uint64_t input_size,
+						int output_fd,
+						char const* input_file_name,
+						char const* output_file_name)
+{
+  uint64_t number_of_blocks = (input_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  vector<BlockTransfer> transfers(PIPELINE_DEPTH);
+  for (BlockTransfer& transfer : transfers) {
+    transfer.state = BLOCK_FREE;
+  }
+
+  // Blocks are read ahead of next_to_code while their buffers are free,
+  // coded strictly in order, and written at the running output offset.
+  uint64_t next_to_read = 0;
+  uint64_t next_to_code = 0;
+  uint64_t output_offset = 0;
+  int error_code = NO_ERROR;
+  while (true) {
+    while (error_code == NO_ERROR && next_to_read < number_of_blocks
+	   && transfers[next_to_read % PIPELINE_DEPTH].state == BLOCK_FREE) {
+      int block_index = next_to_read % PIPELINE_DEPTH;
+      BlockTransfer& transfer = transfers[block_index];
+      transfer.state = BLOCK_READING;
+      transfer.file_offset = next_to_read * BLOCK_SIZE;
+      transfer.length = (next_to_read + 1 == number_of_blocks)
+	? input_size - transfer.file_offset : BLOCK_SIZE;
+      transfer.transferred = 0;
+      ring_.read(input_fd, block_index, 0, transfer.length,
+		 transfer.file_offset, block_index);
+      next_to_read++;
+    }
+
+    while (error_code == NO_ERROR && next_to_code < next_to_read
+	   && transfers[next_to_code % PIPELINE_DEPTH].state == BLOCK_READY) {
+      int block_index = next_to_code % PIPELINE_DEPTH;
+      BlockTransfer& transfer = transfers[block_index];
+      size_t length = transfer.length;
+      char invalid_character;
+      error_code = codeBlock(blocks_[block_index], length, invalid_character);
+      if (error_code == INVALID_INPUT_CHARACTER) {
+	cerr << invalid_character << " in input file " << input_file_name;
+	cerr << " is not a valid input character (input characters must be";
+	cerr << " upper case letters A-Z)!" << endl;
+      }
+      if (length == 0) {
+	transfer.state = BLOCK_FREE;
+      } else {
+	transfer.state = BLOCK_WRITING;
+	transfer.file_offset = output_offset;
+	transfer.length = length;
+	transfer.transferred = 0;
+	ring_.write(output_fd, block_index, 0, length, output_offset,
+		    block_index);
+	output_offset += length;
+      }
+      next_to_code++;
+    }
+
+    // Requests already queued use the blocks, so they are always waited
+    // for, even after an error, or given up if the ring fails.
+    uint64_t tag;
+    long result;
+    if (!ring_.waitCompletion(tag, result)) {
+      if (result < 0) {
+	if (error_code == NO_ERROR) {
+	  cerr << "Error waiting for input and output: ";
+	  cerr << strerror(-result) << endl;
+	  error_code = ERROR_READING_OR_WRITING_FILE;
+	}
+	abandonTransfers();
+      }
+      break;
+    }
+
+    int block_index = tag;
+    BlockTransfer& transfer = transfers[block_index];
+    bool is_reading = (transfer.state == BLOCK_READING);
+    if (result == -EINTR || result == -EAGAIN) {
+      result = 0;
+    } else if (result < 0 || (result == 0 && is_reading)) {
+      if (error_code == NO_ERROR) {
+	if (is_reading) {
+	  cerr << "Error reading input file " << input_file_name;
+	} else {
+	  cerr << "Error writing output file " << output_file_name;
+	}
+	cerr << ": " << ((result < 0) ? strerror(-result) : "it has shrunk");
+	cerr << endl;
+	error_code = ERROR_READING_OR_WRITING_FILE;
+      }
+      transfer.state = BLOCK_FREE;
+      continue;
+    }
+
+    // A short transfer is carried on from where it stopped.
+    transfer.transferred += result;
+    if (transfer.transferred < transfer.length) {
+      if (error_code != NO_ERROR) {
+	transfer.state = BLOCK_FREE;
+      } else if (is_reading) {
+	ring_.read(input_fd, block_index, transfer.transferred,
+		   transfer.length - transfer.transferred,
+		   transfer.file_offset + transfer.transferred, block_index);
+      } else {
+	ring_.write(output_fd, block_index, transfer.transferred,
+		    transfer.length - transfer.transferred,
+		    transfer.file_offset + transfer.transferred, block_index);
+      }
+      continue;
+    }
+    transfer.state = is_reading ? BLOCK_READY : BLOCK_FREE;
+  }
+
+  return error_code;
+}
+
+template <int ALPHABET_SIZE>
+int BasicFileCoder<ALPHABET_SIZE>::codeBlock(uint8_t* block, size_t& length,
+					     char& invalid_character)
+{
+  char* data = reinterpret_cast<char*>(block);
+
+  if (ALPHABET_SIZE != ALPHABET_LENGTH) {
+    enigma_.codeBlock(data, length);
+    return NO_ERROR;
+  }
+
+  // The letters are gathered first so that they can be coded as a block.
+  // The letters before an invalid character are still written out.
+  size_t letters_length = 0;
+  int error_code = NO_ERROR;
+  for (size_t i = 0; i < length; i++) {
+    char next = data[i];
+    if (isspace(static_cast<unsigned char>(next))) {
+      continue;
+    }
+    if (next < ASCII_A || next > ASCII_Z) {
+      invalid_character = next;
+      error_code = INVALID_INPUT_CHARACTER;
+      break;
+    }
+    data[letters_length++] = next;
+  }
+  enigma_.codeBlock(data, letters_length);
+  length = letters_length;
+
+  return error_code;
+}
+
+template <int ALPHABET_SIZE>
+void BasicFileCoder<ALPHABET_SIZE>::setUpBlocks()
+{
+  memory_.assign(static_cast<size_t>(PIPELINE_DEPTH) * BLOCK_SIZE, 0);
+  for (int i = 0; i < PIPELINE_DEPTH; i++) {
+    blocks_[i] = memory_.data() + static_cast<size_t>(i) * BLOCK_SIZE;
+  }
+  ring_.setUp(PIPELINE_DEPTH, blocks_.data(), BLOCK_SIZE, PIPELINE_DEPTH);
+}
+
+template <int ALPHABET_SIZE>
+void BasicFileCoder<ALPHABET_SIZE>::abandonTransfers()
+{
+  if (ring_.cancel()) {
+    return;
+  }
+
+  // The old blocks are moved into a vector which is never freed.
+  new vector<uint8_t>(move(memory_));
+  setUpBlocks();
+}
+
+template class BasicFileCoder<ALPHABET_LENGTH>;
+template class BasicFileCoder<BYTE_ALPHABET_LENGTH>;
@@ -0,0 +1,98 @@
+#ifndef FILE_CODER_H
+#define FILE_CODER_H
+
+/* The FileCoder class template codes whole files with an Enigma machine,
+   for work such as re-encrypting an archive file by file. Each file is
+   read and written in blocks of BLOCK_SIZE bytes through an IoRing, which
+   keeps up to PIPELINE_DEPTH reads and writes in flight, so the device
+   queue stays full while the machine codes the blocks that have arrived.
+   The blocks are coded in order, but are read and written at their own
+   offsets, so they may complete in any order.
+   Every file is coded from the same starting positions, as a separate
+   message.
+   For the 26 letter alphabet whitespace in the input is skipped and any
+   other character which is not an upper case letter ends the file with
+   an error, as when coding standard input; the letters before it are
+   still written. For the 256 symbol alphabet every byte is coded.
+   enigma_ is the machine used to code.
+   starting_positions_ contains the rotor positions each file starts
+   from.
+   memory_ holds the PIPELINE_DEPTH blocks, and blocks_ points to each.
+   Block b of a file always uses block b % PIPELINE_DEPTH, which is free
+   again once block b - PIPELINE_DEPTH has been written.
+   ring_ carries out the reads and writes.
+   FileCoder codes with an Enigma and ByteFileCoder with a ByteEnigma. */
+
+#include "Enigma.hpp"
+#include "IoRing.hpp"
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <int ALPHABET_SIZE>
+class BasicFileCoder
+{
+public:
+  /* Function to initialise a FileCoder which codes with enigma, starting
+     every file from its current rotor positions. enigma must be set up
+     and must outlive the FileCoder. */
+  explicit BasicFileCoder(BasicEnigma<ALPHABET_SIZE>& enigma);
+
+  /* Function to code the regular file named input_file_name into the file
+     named output_file_name, which is created or truncated.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int codeFile(char const* input_file_name, char const* output_file_name);
+
+  /* Function to return true if the files are read and written through
+     io_uring rather than with pread and pwrite. */
+  bool isUsingUring() const;
+
+private:
+  /* What a block is waiting for. */
+  enum BlockState { BLOCK_FREE, BLOCK_READING, BLOCK_READY, BLOCK_WRITING };
+
+  /* The progress of a block: the file offset and length it is read from
+     or written to, and how many of those bytes have been transferred. */
+  struct BlockTransfer
+  {
+    BlockState state;
+    std::uint64_t file_offset;
+    std::size_t length;
+    std::size_t transferred;
+  };
+
+  BasicEnigma<ALPHABET_SIZE>& enigma_;
+  std::vector<int> starting_positions_;
+  std::vector<std::uint8_t> memory_;
+  std::vector<std::uint8_t*> blocks_;
+  IoRing ring_;
+
+  /* Function to code the input_size bytes of the open file input_fd into
+     the open file output_fd.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int codeOpenFile(int input_fd, std::uint64_t input_size, int output_fd,
+		   char const* input_file_name,
+		   char const* output_file_name);
+
+  /* Function to code the length bytes of a block in place, setting
+     length to the number of coded symbols to write. For letters,
+     whitespace is removed and coding stops at a character which is not
+     an upper case letter, which is returned in invalid_character.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int codeBlock(std::uint8_t* block, std::size_t& length,
+		char& invalid_character);
+
+  /* Function to allocate memory_ and point blocks_ and ring_ at it. */
+  void setUpBlocks();
+
+  /* Function to give up the reads and writes in flight after ring_ has
+     failed. If they cannot be cancelled the kernel may still use the
+     blocks, so those are left allocated for good and new ones set up. */
+  void abandonTransfers();
+};
+
+typedef BasicFileCoder<ALPHABET_LENGTH> FileCoder;
+typedef BasicFileCoder<BYTE_ALPHABET_LENGTH> ByteFileCoder;
+
+#endif
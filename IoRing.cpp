@@ -0,0 +1,299 @@
+/* This file contains the member function definitions
+   for the IoRing class */
+
+#include "IoRing.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <utility>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+  /* Functions to make the raw io_uring system calls, which have no C
+     library wrappers. */
+  int setUpRing(unsigned entries, io_uring_params* parameters)
+  {
+    return syscall(__NR_io_uring_setup, entries, parameters);
+  }
+
+  int enterRing(int ring_fd, unsigned to_submit, unsigned min_complete,
+		unsigned flags)
+  {
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+		   flags, nullptr, 0);
+  }
+
+  int registerRing(int ring_fd, unsigned operation, void* argument,
+		   unsigned number_of_arguments)
+  {
+    return syscall(__NR_io_uring_register, ring_fd, operation, argument,
+		   number_of_arguments);
+  }
+
+  /* Function to map the part of the io_uring ring_fd at offset. Returns
+     nullptr if it cannot be mapped. */
+  void* mapRing(int ring_fd, size_t size, off_t offset)
+  {
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+    return (memory == MAP_FAILED) ? nullptr : memory;
+  }
+}
+
+IoRing::IoRing() :
+  ring_fd_(-1),
+  sq_ring_(nullptr),
+  cq_ring_(nullptr),
+  sqes_(nullptr),
+  sq_ring_size_(0),
+  cq_ring_size_(0),
+  sqes_size_(0),
+  sq_head_(nullptr),
+  sq_tail_(nullptr),
+  sq_mask_(nullptr),
+  sq_array_(nullptr),
+  cq_head_(nullptr),
+  cq_tail_(nullptr),
+  cq_mask_(nullptr),
+  cqes_(nullptr),
+  buffers_(),
+  unsubmitted_(0),
+  in_flight_(0),
+  fallback_completions_() {}
+
+IoRing::~IoRing()
+{
+  tearDown();
+}
+
+void IoRing::setUp(unsigned queue_depth, uint8_t* const* buffers,
+		   size_t buffer_size, int number_of_buffers)
+{
+  tearDown();
+  buffers_.assign(buffers, buffers + number_of_buffers);
+
+  io_uring_params parameters;
+  memset(&parameters, 0, sizeof(parameters));
+  ring_fd_ = setUpRing(queue_depth, &parameters);
+  if (ring_fd_ < 0) {
+    ring_fd_ = -1;
+    return;
+  }
+
+  sq_ring_size_ = parameters.sq_off.array
+    + parameters.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = parameters.cq_off.cqes
+    + parameters.cq_entries * sizeof(io_uring_cqe);
+  bool is_single_mapping =
+    (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (is_single_mapping) {
+    sq_ring_size_ = cq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+  }
+  sqes_size_ = parameters.sq_entries * sizeof(io_uring_sqe);
+
+  sq_ring_ = static_cast<uint8_t*>(mapRing(ring_fd_, sq_ring_size_,
+					   IORING_OFF_SQ_RING));
+  cq_ring_ = (is_single_mapping || sq_ring_ == nullptr) ? sq_ring_
+    : static_cast<uint8_t*>(mapRing(ring_fd_, cq_ring_size_,
+				    IORING_OFF_CQ_RING));
+  sqes_ = mapRing(ring_fd_, sqes_size_, IORING_OFF_SQES);
+  if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+    tearDown();
+    buffers_.assign(buffers, buffers + number_of_buffers);
+    return;
+  }
+
+  sq_head_ = reinterpret_cast<unsigned*>(sq_ring_ + parameters.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq_ring_ + parameters.sq_off.tail);
+  sq_mask_ =
+    reinterpret_cast<unsigned*>(sq_ring_ + parameters.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq_ring_ + parameters.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned*>(cq_ring_ + parameters.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq_ring_ + parameters.cq_off.tail);
+  cq_mask_ =
+    reinterpret_cast<unsigned*>(cq_ring_ + parameters.cq_off.ring_mask);
+  cqes_ = cq_ring_ + parameters.cq_off.cqes;
+
+  vector<iovec> vectors(number_of_buffers);
+  for (int i = 0; i < number_of_buffers; i++) {
+    vectors[i].iov_base = buffers[i];
+    vectors[i].iov_len = buffer_size;
+  }
+  if (registerRing(ring_fd_, IORING_REGISTER_BUFFERS, vectors.data(),
+		   number_of_buffers) != 0) {
+    tearDown();
+    buffers_.assign(buffers, buffers + number_of_buffers);
+  }
+}
+
+bool IoRing::isUsingUring() const
+{
+  return ring_fd_ >= 0;
+}
+
+void IoRing::read(int fd, int buffer_index, size_t buffer_offset,
+		  size_t length, uint64_t file_offset, uint64_t tag)
+{
+  queueRequest(IORING_OP_READ_FIXED, fd, buffer_index, buffer_offset,
+	       length, file_offset, tag);
+}
+
+void IoRing::write(int fd, int buffer_index, size_t buffer_offset,
+		   size_t length, uint64_t file_offset, uint64_t tag)
+{
+  queueRequest(IORING_OP_WRITE_FIXED, fd, buffer_index, buffer_offset,
+	       length, file_offset, tag);
+}
+
+bool IoRing::waitCompletion(uint64_t& tag, long& result)
+{
+  result = 0;
+  if (in_flight_ == 0) {
+    return false;
+  }
+
+  if (ring_fd_ < 0) {
+    tag = fallback_completions_.front().first;
+    result = fallback_completions_.front().second;
+    fallback_completions_.pop_front();
+    in_flight_--;
+    return true;
+  }
+
+  // The kernel writes the tail, so it is read with acquire ordering to
+  // see the completion it published; the head is only written here.
+  unsigned head = *cq_head_;
+  while (unsubmitted_ > 0 || head == __atomic_load_n(cq_tail_,
+						      __ATOMIC_ACQUIRE)) {
+    int submitted = enterRing(ring_fd_, unsubmitted_, 1,
+			      IORING_ENTER_GETEVENTS);
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+	continue;
+      }
+      result = -errno;
+      return false;
+    }
+    unsubmitted_ -= submitted;
+  }
+
+  io_uring_cqe const* cqe =
+    static_cast<io_uring_cqe const*>(cqes_) + (head & *cq_mask_);
+  tag = cqe->user_data;
+  result = cqe->res;
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  in_flight_--;
+  return true;
+}
+
+bool IoRing::cancel()
+{
+  if (ring_fd_ < 0) {
+    fallback_completions_.clear();
+    in_flight_ = 0;
+    return true;
+  }
+
+  // Entries which have not been submitted are taken back off the queue,
+  // since the kernel only reads it when asked to submit.
+  __atomic_store_n(sq_tail_, *sq_tail_ - unsubmitted_, __ATOMIC_RELEASE);
+  in_flight_ -= unsubmitted_;
+  unsubmitted_ = 0;
+  if (in_flight_ == 0) {
+    return true;
+  }
+
+  // One request cancels all the others. Kernels which cannot do that
+  // fail it, but every request still completes and is waited for below.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  unsubmitted_++;
+  in_flight_++;
+
+  while (in_flight_ > 0) {
+    uint64_t tag;
+    long result;
+    if (!waitCompletion(tag, result)) {
+      vector<uint8_t*> buffers = buffers_;
+      tearDown();
+      buffers_ = buffers;
+      return false;
+    }
+  }
+  return true;
+}
+
+void IoRing::queueRequest(int operation, int fd, int buffer_index,
+			  size_t buffer_offset, size_t length,
+			  uint64_t file_offset, uint64_t tag)
+{
+  uint8_t* address = buffers_[buffer_index] + buffer_offset;
+  in_flight_++;
+
+  if (ring_fd_ < 0) {
+    ssize_t result = (operation == IORING_OP_READ_FIXED)
+      ? pread(fd, address, length, file_offset)
+      : pwrite(fd, address, length, file_offset);
+    fallback_completions_.emplace_back(tag, (result < 0) ? -errno : result);
+    return;
+  }
+
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = operation;
+  sqe->fd = fd;
+  sqe->off = file_offset;
+  sqe->addr = reinterpret_cast<uint64_t>(address);
+  sqe->len = length;
+  sqe->buf_index = buffer_index;
+  sqe->user_data = tag;
+  sq_array_[index] = index;
+
+  // The entry must be visible to the kernel before the new tail is.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  unsubmitted_++;
+}
+
+void IoRing::tearDown()
+{
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+
+  ring_fd_ = -1;
+  sq_ring_ = nullptr;
+  cq_ring_ = nullptr;
+  sqes_ = nullptr;
+  buffers_.clear();
+  unsubmitted_ = 0;
+  in_flight_ = 0;
+  fallback_completions_.clear();
+}
@@ -0,0 +1,114 @@
+#ifndef IO_RING_H
+#define IO_RING_H
+
+/* The IoRing class keeps several reads and writes of files in flight at
+   once with Linux io_uring, so a thread which codes blocks never waits
+   for the device while it still has work.
+   It talks to the kernel with the raw io_uring_setup, io_uring_enter and
+   io_uring_register system calls and the layout in <linux/io_uring.h>,
+   so it needs no library. The buffers are registered with the kernel
+   once, so reads and writes into them skip mapping the pages each time.
+   Where io_uring is not available (an old kernel, or a container which
+   blocks it) every request is carried out straight away with pread or
+   pwrite and its completion queued, so callers work the same either way.
+   ring_fd_ is the io_uring file descriptor, or -1 when falling back.
+   sq_ring_, cq_ring_ and sqes_ point to the mapped submission queue,
+   completion queue and submission queue entries, and sq_ring_size_,
+   cq_ring_size_ and sqes_size_ are their mapped sizes. The completion
+   queue shares the submission queue's mapping when the kernel supports
+   it.
+   sq_head_, sq_tail_, sq_mask_, sq_array_, cq_head_, cq_tail_, cq_mask_
+   and cqes_ point to the fields of the rings.
+   buffers_ contains the start of each registered buffer.
+   unsubmitted_ counts the requests queued since the last submission and
+   in_flight_ the requests whose completions have not been taken.
+   fallback_completions_ holds the completions of requests carried out
+   straight away when falling back, oldest first. */
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+class IoRing
+{
+public:
+  /* Function to initialise an IoRing object with no buffers, which falls
+     back to pread and pwrite until setUp is called. */
+  IoRing();
+
+  /* Destructor, which unmaps the rings and closes the io_uring. */
+  ~IoRing();
+
+  IoRing(IoRing const&) = delete;
+  IoRing& operator=(IoRing const&) = delete;
+
+  /* Function to set up a ring for up to queue_depth requests in flight
+     and register the number_of_buffers buffers of buffer_size bytes
+     starting at buffers[i]. If io_uring cannot be used the object falls
+     back to pread and pwrite, which isUsingUring reports. */
+  void setUp(unsigned queue_depth, std::uint8_t* const* buffers,
+	     std::size_t buffer_size, int number_of_buffers);
+
+  /* Function to return true if requests go through io_uring. */
+  bool isUsingUring() const;
+
+  /* Functions to queue a read of length bytes from the file descriptor fd
+     at file_offset into the buffer accessed by buffer_index, starting
+     buffer_offset bytes in, or a write of them from there. tag is
+     returned with the completion. No more than queue_depth requests may
+     be in flight. */
+  void read(int fd, int buffer_index, std::size_t buffer_offset,
+	    std::size_t length, std::uint64_t file_offset, std::uint64_t tag);
+  void write(int fd, int buffer_index, std::size_t buffer_offset,
+	     std::size_t length, std::uint64_t file_offset,
+	     std::uint64_t tag);
+
+  /* Function to submit the queued requests and wait until one of the
+     requests in flight completes, setting tag to its tag and result to
+     the number of bytes transferred or minus the error number. Returns
+     false if there is nothing in flight, or with result set to minus the
+     error number if the ring itself fails. */
+  bool waitCompletion(std::uint64_t& tag, long& result);
+
+  /* Function to give up every request in flight: those not yet submitted
+     are dropped, and those submitted are cancelled and waited for, so the
+     kernel no longer uses their buffers once it returns. Their
+     completions are discarded. Returns false if the ring fails while
+     waiting, in which case it is closed, the object falls back to pread
+     and pwrite, and the kernel may still use the buffers for a while. */
+  bool cancel();
+
+private:
+  int ring_fd_;
+  std::uint8_t* sq_ring_;
+  std::uint8_t* cq_ring_;
+  void* sqes_;
+  std::size_t sq_ring_size_;
+  std::size_t cq_ring_size_;
+  std::size_t sqes_size_;
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned* cq_mask_;
+  void* cqes_;
+  std::vector<std::uint8_t*> buffers_;
+  unsigned unsubmitted_;
+  unsigned in_flight_;
+  std::deque<std::pair<std::uint64_t, long>> fallback_completions_;
+
+  /* Function to queue a request with io_uring opcode operation, or carry
+     it out straight away when falling back. */
+  void queueRequest(int operation, int fd, int buffer_index,
+		    std::size_t buffer_offset, std::size_t length,
+		    std::uint64_t file_offset, std::uint64_t tag);
+
+  /* Function to unmap the rings, close the io_uring and fall back. */
+  void tearDown();
+};
+
+#endif
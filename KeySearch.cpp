@@ -0,0 +1,582 @@
+/* This file contains the member function definitions
+   for the KeySearch class */
+
+#include "KeySearch.hpp"
+#include "Enigma.hpp"
+#include "Scorer.hpp"
+#include "Catalog.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+  /* Function to multiply product by factor, returning false if the result
+     does not fit in 64 bits. */
+  bool multiply(uint64_t& product, uint64_t factor)
+  {
+    if (factor != 0 && product > UINT64_MAX / factor) {
+      return false;
+    }
+    product *= factor;
+    return true;
+  }
+
+  /* A result read from a checkpoint file by KeySearch::merge, with the
+     settings of its candidate written out. */
+  struct MergedResult
+  {
+    uint64_t score;
+    uint64_t candidate;
+    string settings;
+  };
+}
+
+KeySearch::KeySearch() :
+  ciphertext_(),
+  plugboard_file_name_(),
+  reflector_file_names_(),
+  rotor_file_names_(),
+  number_of_slots_(0),
+  number_to_keep_(0),
+  first_candidate_(0),
+  last_candidate_(0),
+  next_candidate_(0),
+  results_() {}
+
+int KeySearch::setUp(char const* ciphertext_file_name,
+		     char const* plugboard_file_name,
+		     int number_of_reflectors,
+		     char const* const* reflector_file_names,
+		     int number_of_rotors,
+		     char const* const* rotor_file_names,
+		     int number_of_slots, int number_to_keep)
+{
+  ifstream in(ciphertext_file_name);
+  if (in.fail()) {
+    cerr << "Error opening ciphertext file " << ciphertext_file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  ciphertext_.clear();
+  char next;
+  while (in.get(next)) {
+    if (isspace(static_cast<unsigned char>(next))) {
+      continue;
+    }
+    if (next < ASCII_A || next > ASCII_Z) {
+      cerr << next << " in ciphertext file " << ciphertext_file_name;
+      cerr << " is not an upper case letter" << endl;
+      return INVALID_INPUT_CHARACTER;
+    }
+    ciphertext_.push_back(next);
+  }
+
+  plugboard_file_name_ = plugboard_file_name;
+  reflector_file_names_.assign(reflector_file_names,
+			       reflector_file_names + number_of_reflectors);
+  rotor_file_names_.assign(rotor_file_names,
+			   rotor_file_names + number_of_rotors);
+  number_of_slots_ = number_of_slots;
+  number_to_keep_ = number_to_keep;
+
+  if (ciphertext_.empty() || number_of_reflectors < 1
+      || number_of_slots < 1 || number_of_slots > number_of_rotors
+      || number_to_keep < 1) {
+    cerr << "A search needs some ciphertext, a reflector, at least as many";
+    cerr << " rotors as slots and at least one candidate to keep" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  uint64_t number_of_candidates = reflector_file_names_.size();
+  uint64_t number_of_positions = 1;
+  for (int i = 0; i < number_of_slots_; i++) {
+    if (!multiply(number_of_candidates, number_of_rotors - i)
+	|| !multiply(number_of_positions, ALPHABET_LENGTH)) {
+      cerr << "There are too many candidates to number" << endl;
+      return INVALID_ARGUMENT;
+    }
+  }
+  if (!multiply(number_of_candidates, number_of_positions)) {
+    cerr << "There are too many candidates to number" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  first_candidate_ = 0;
+  last_candidate_ = number_of_candidates;
+  next_candidate_ = 0;
+  results_.clear();
+  return NO_ERROR;
+}
+
+uint64_t KeySearch::getNumberOfCandidates() const
+{
+  return reflector_file_names_.size() * getNumberOfOrders()
+    * getNumberOfPositions();
+}
+
+int KeySearch::split(int number_of_units, char const* unit_file_prefix,
+		     ostream& out) const
+{
+  if (number_of_units < 1) {
+    cerr << "A search must be split into at least one unit" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  // The unit numbers are padded to the same width, so the file names
+  // sort in the order of the units.
+  int width = to_string(number_of_units - 1).size();
+  uint64_t size = last_candidate_ - first_candidate_;
+  KeySearch unit = *this;
+  for (int i = 0; i < number_of_units; i++) {
+    unit.first_candidate_ = first_candidate_ + size / number_of_units * i
+      + min<uint64_t>(i, size % number_of_units);
+    unit.last_candidate_ = unit.first_candidate_ + size / number_of_units
+      + ((static_cast<uint64_t>(i) < size % number_of_units) ? 1 : 0);
+
+    ostringstream file_name;
+    file_name << unit_file_prefix << setw(width) << setfill('0') << i;
+    file_name << ".unit";
+    int error_code = unit.write(file_name.str().c_str());
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
+    out << file_name.str() << endl;
+  }
+
+  return NO_ERROR;
+}
+
+int KeySearch::read(char const* unit_file_name)
+{
+  ifstream in(unit_file_name);
+  if (in.fail()) {
+    cerr << "Error opening search unit file " << unit_file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  *this = KeySearch();
+  string line;
+  for (int line_number = 1; getline(in, line); line_number++) {
+    istringstream fields(line);
+    string keyword, value;
+    if (!(fields >> keyword) || keyword[0] == '#') {
+      continue;
+    }
+
+    bool is_valid = true;
+    if (keyword == "ciphertext") {
+      is_valid = static_cast<bool>(fields >> ciphertext_);
+    } else if (keyword == "plugboard") {
+      is_valid = static_cast<bool>(fields >> plugboard_file_name_);
+    } else if (keyword == "reflector" && fields >> value) {
+      reflector_file_names_.push_back(value);
+    } else if (keyword == "rotor" && fields >> value) {
+      rotor_file_names_.push_back(value);
+    } else if (keyword == "slots") {
+      is_valid = static_cast<bool>(fields >> number_of_slots_);
+    } else if (keyword == "keep") {
+      is_valid = static_cast<bool>(fields >> number_to_keep_);
+    } else if (keyword == "range") {
+      is_valid = static_cast<bool>(fields >> first_candidate_
+				   >> last_candidate_);
+    } else {
+      is_valid = false;
+    }
+    if (!is_valid || fields >> value) {
+      cerr << "Invalid line " << line_number << " in search unit file ";
+      cerr << unit_file_name << endl;
+      return INVALID_ARGUMENT;
+    }
+  }
+
+  if (ciphertext_.empty() || plugboard_file_name_.empty()
+      || reflector_file_names_.empty() || number_of_slots_ < 1
+      || number_of_slots_ > static_cast<int>(rotor_file_names_.size())
+      || number_to_keep_ < 1 || first_candidate_ > last_candidate_
+      || last_candidate_ > getNumberOfCandidates()
+      || !all_of(ciphertext_.begin(), ciphertext_.end(), [](char letter) {
+	  return letter >= ASCII_A && letter <= ASCII_Z;
+	})) {
+    cerr << "Search unit file " << unit_file_name << " is incomplete";
+    cerr << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  next_candidate_ = first_candidate_;
+  return NO_ERROR;
+}
+
+int KeySearch::write(char const* unit_file_name) const
+{
+  ofstream out(unit_file_name);
+  if (out.fail()) {
+    cerr << "Error opening search unit file " << unit_file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  out << "# enigma key search unit" << endl;
+  out << "ciphertext " << ciphertext_ << endl;
+  out << "plugboard " << plugboard_file_name_ << endl;
+  for (string const& file_name : reflector_file_names_) {
+    out << "reflector " << file_name << endl;
+  }
+  for (string const& file_name : rotor_file_names_) {
+    out << "rotor " << file_name << endl;
+  }
+  out << "slots " << number_of_slots_ << endl;
+  out << "keep " << number_to_keep_ << endl;
+  out << "range " << first_candidate_ << " " << last_candidate_ << endl;
+
+  if (!out) {
+    cerr << "Error writing search unit file " << unit_file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  return NO_ERROR;
+}
+
+int KeySearch::run(char const* unit_file_name)
+{
+  int error_code = read(unit_file_name);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+  string checkpoint_file_name = string(unit_file_name) + ".checkpoint";
+  error_code = readCheckpoint(checkpoint_file_name);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  // Every file is read once; each machine is then set up from the text.
+  string plugboard;
+  vector<string> reflectors(reflector_file_names_.size());
+  vector<string> rotors(rotor_file_names_.size());
+  error_code = readSettingText(SETTING_PLUGBOARD,
+			       plugboard_file_name_.c_str(), plugboard);
+  for (size_t i = 0; i < reflectors.size() && error_code == NO_ERROR; i++) {
+    error_code = readSettingText(SETTING_REFLECTOR,
+				 reflector_file_names_[i].c_str(),
+				 reflectors[i]);
+  }
+  for (size_t i = 0; i < rotors.size() && error_code == NO_ERROR; i++) {
+    error_code = readSettingText(SETTING_ROTOR, rotor_file_names_[i].c_str(),
+				 rotors[i]);
+  }
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  vector<char const*> rotor_names;
+  for (string const& rotor_file_name : rotor_file_names_) {
+    rotor_names.push_back(rotor_file_name.c_str());
+  }
+
+  auto enigma = Enigma();
+  Scorer scorer;
+  uint64_t number_of_positions = getNumberOfPositions();
+  uint64_t machine = UINT64_MAX;
+  int reflector_index;
+  vector<int> rotor_indices(number_of_slots_);
+  vector<int> positions(number_of_slots_);
+  for (; next_candidate_ < last_candidate_; next_candidate_++) {
+    getCandidate(next_candidate_, reflector_index, rotor_indices.data(),
+		 positions.data());
+
+    // Consecutive candidates share a machine until the positions wrap.
+    if (next_candidate_ / number_of_positions != machine) {
+      machine = next_candidate_ / number_of_positions;
+      error_code = setUpFromSettingTexts(
+	  enigma, plugboard, plugboard_file_name_.c_str(),
+	  reflectors[reflector_index],
+	  reflector_file_names_[reflector_index].c_str(), rotors.data(),
+	  rotor_names.data(), number_of_slots_, rotor_indices.data());
+      if (error_code == NO_ERROR) {
+	error_code = enigma.setEngine(ENGINE_AUTO, ciphertext_.size());
+      }
+      if (error_code != NO_ERROR) {
+	return error_code;
+      }
+    }
+
+    // Once enough candidates are kept, only a better one can be added,
+    // so the scorer gives up on any which cannot beat the worst of them.
+    uint64_t threshold = (results_.size() < size_t(number_to_keep_))
+      ? 0 : results_.back().score + 1;
+    uint64_t score;
+    enigma.setPositions(positions.data());
+    if (scorer.scoreCoincidences(enigma, ciphertext_.data(),
+				 ciphertext_.size(), threshold, score)) {
+      addResult(score, next_candidate_);
+    }
+
+    if ((next_candidate_ + 1 - first_candidate_)
+	% SEARCH_CHECKPOINT_INTERVAL == 0) {
+      next_candidate_++;
+      error_code = writeCheckpoint(checkpoint_file_name);
+      next_candidate_--;
+      if (error_code != NO_ERROR) {
+	return error_code;
+      }
+    }
+  }
+
+  return writeCheckpoint(checkpoint_file_name);
+}
+
+int KeySearch::merge(int number_of_files,
+		     char const* const* checkpoint_file_names,
+		     int number_to_keep, ostream& out)
+{
+  vector<MergedResult> results;
+  for (int i = 0; i < number_of_files; i++) {
+    ifstream in(checkpoint_file_names[i]);
+    if (in.fail()) {
+      cerr << "Error opening checkpoint file " << checkpoint_file_names[i];
+      cerr << endl;
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+    uint64_t first_candidate = 0, last_candidate = 0, next_candidate = 0;
+    size_t first_result = results.size();
+    string line;
+    for (int line_number = 1; getline(in, line); line_number++) {
+      istringstream fields(line);
+      string keyword;
+      if (!(fields >> keyword) || keyword[0] == '#') {
+	continue;
+      }
+
+      bool is_valid = true;
+      if (keyword == "range") {
+	is_valid = static_cast<bool>(fields >> first_candidate
+				     >> last_candidate);
+      } else if (keyword == "next") {
+	is_valid = static_cast<bool>(fields >> next_candidate);
+      } else if (keyword == "result") {
+	MergedResult result;
+	is_valid = static_cast<bool>(fields >> result.score
+				     >> result.candidate);
+	getline(fields >> ws, result.settings);
+	results.push_back(result);
+      } else {
+	is_valid = false;
+      }
+      if (!is_valid) {
+	cerr << "Invalid line " << line_number << " in checkpoint file ";
+	cerr << checkpoint_file_names[i] << endl;
+	return INVALID_ARGUMENT;
+      }
+    }
+
+    for (size_t j = first_result; j < results.size(); j++) {
+      if (results[j].candidate < first_candidate ||
+	  results[j].candidate >= next_candidate) {
+	cerr << "Checkpoint file " << checkpoint_file_names[i] << " has a";
+	cerr << " result outside the candidates it searched" << endl;
+	return INVALID_ARGUMENT;
+      }
+    }
+
+    if (next_candidate < last_candidate) {
+      cerr << "Checkpoint file " << checkpoint_file_names[i] << " has only";
+      cerr << " searched " << next_candidate - first_candidate << " of ";
+      cerr << last_candidate - first_candidate << " candidates" << endl;
+    }
+  }
+
+  sort(results.begin(), results.end(),
+       [](MergedResult const& first, MergedResult const& second) {
+	 return (first.score != second.score) ? first.score > second.score
+	   : first.candidate < second.candidate;
+       });
+  for (int i = 0; i < number_to_keep && i < int(results.size()); i++) {
+    out << results[i].score << " " << results[i].settings << endl;
+  }
+
+  return NO_ERROR;
+}
+
+uint64_t KeySearch::getNumberOfPositions() const
+{
+  uint64_t number_of_positions = 1;
+  for (int i = 0; i < number_of_slots_; i++) {
+    number_of_positions *= ALPHABET_LENGTH;
+  }
+  return number_of_positions;
+}
+
+uint64_t KeySearch::getNumberOfOrders() const
+{
+  return countRotorOrders(rotor_file_names_.size(), number_of_slots_);
+}
+
+void KeySearch::getCandidate(uint64_t candidate, int& reflector_index,
+			     int* rotor_indices, int* positions) const
+{
+  uint64_t number_of_positions = getNumberOfPositions();
+  uint64_t number_of_orders = getNumberOfOrders();
+  uint64_t position = candidate % number_of_positions;
+  uint64_t order = candidate / number_of_positions % number_of_orders;
+  reflector_index = candidate / number_of_positions / number_of_orders;
+
+  for (int i = number_of_slots_ - 1; i >= 0; i--) {
+    positions[i] = position % ALPHABET_LENGTH;
+    position /= ALPHABET_LENGTH;
+  }
+
+  getRotorOrder(order, rotor_file_names_.size(), number_of_slots_,
+		rotor_indices);
+}
+
+void KeySearch::writeCandidate(uint64_t candidate, ostream& out) const
+{
+  int reflector_index;
+  vector<int> rotor_indices(number_of_slots_);
+  vector<int> positions(number_of_slots_);
+  getCandidate(candidate, reflector_index, rotor_indices.data(),
+	       positions.data());
+
+  out << reflector_file_names_[reflector_index];
+  for (int i = 0; i < number_of_slots_; i++) {
+    out << " " << rotor_file_names_[rotor_indices[i]];
+  }
+  out << " |";
+  for (int i = 0; i < number_of_slots_; i++) {
+    out << " " << positions[i];
+  }
+}
+
+void KeySearch::addResult(uint64_t score, uint64_t candidate)
+{
+  // Candidates are searched in increasing order, so a candidate scoring
+  // the same as one already kept ranks after it.
+  SearchResult result = {score, candidate};
+  auto position = upper_bound(results_.begin(), results_.end(), result,
+			      [](SearchResult const& first,
+				 SearchResult const& second) {
+				return first.score > second.score;
+			      });
+  if (position - results_.begin() < number_to_keep_) {
+    results_.insert(position, result);
+    if (results_.size() > size_t(number_to_keep_)) {
+      results_.pop_back();
+    }
+  }
+}
+
+int KeySearch::readCheckpoint(string const& checkpoint_file_name)
+{
+  ifstream in(checkpoint_file_name);
+  if (in.fail()) {
+    return NO_ERROR;
+  }
+
+  uint64_t first_candidate = 0, last_candidate = 0;
+  bool has_range = false, has_next = false;
+  vector<int> result_lines;
+  vector<string> result_descriptions;
+  string line;
+  for (int line_number = 1; getline(in, line); line_number++) {
+    istringstream fields(line);
+    string keyword;
+    if (!(fields >> keyword) || keyword[0] == '#') {
+      continue;
+    }
+
+    bool is_valid = true;
+    if (keyword == "range") {
+      is_valid = has_range = static_cast<bool>(fields >> first_candidate
+					       >> last_candidate);
+    } else if (keyword == "next") {
+      is_valid = has_next = static_cast<bool>(fields >> next_candidate_);
+    } else if (keyword == "result") {
+      SearchResult result;
+      string description;
+      is_valid = static_cast<bool>(fields >> result.score
+				   >> result.candidate);
+      getline(fields >> ws, description);
+      results_.push_back(result);
+      result_lines.push_back(line_number);
+      result_descriptions.push_back(description);
+    } else {
+      is_valid = false;
+    }
+    if (!is_valid) {
+      cerr << "Invalid line " << line_number << " in checkpoint file ";
+      cerr << checkpoint_file_name << endl;
+      return INVALID_ARGUMENT;
+    }
+  }
+
+  if (!has_range || !has_next || first_candidate != first_candidate_
+      || last_candidate != last_candidate_
+      || next_candidate_ < first_candidate_
+      || next_candidate_ > last_candidate_
+      || results_.size() > size_t(number_to_keep_)) {
+    cerr << "Checkpoint file " << checkpoint_file_name;
+    cerr << " does not belong to this unit" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  // Each result must be a candidate already searched, described as it was
+  // written, and score no higher than the one before it, as addResult
+  // keeps them.
+  for (size_t i = 0; i < results_.size(); i++) {
+    SearchResult const& result = results_[i];
+    bool is_valid = (result.candidate >= first_candidate_ &&
+		     result.candidate < next_candidate_);
+    if (is_valid) {
+      ostringstream description;
+      writeCandidate(result.candidate, description);
+      is_valid = (description.str() == result_descriptions[i]);
+    }
+    if (is_valid && i > 0) {
+      is_valid = (results_[i - 1].score >= result.score);
+    }
+    if (!is_valid) {
+      cerr << "Invalid result on line " << result_lines[i];
+      cerr << " in checkpoint file " << checkpoint_file_name << endl;
+      return INVALID_ARGUMENT;
+    }
+  }
+  return NO_ERROR;
+}
+
+int KeySearch::writeCheckpoint(string const& checkpoint_file_name) const
+{
+  string temporary_file_name = checkpoint_file_name + ".tmp";
+  {
+    ofstream out(temporary_file_name);
+    out << "# enigma key search checkpoint" << endl;
+    out << "range " << first_candidate_ << " " << last_candidate_ << endl;
+    out << "next " << next_candidate_ << endl;
+    for (SearchResult const& result : results_) {
+      out << "result " << result.score << " " << result.candidate << " ";
+      writeCandidate(result.candidate, out);
+      out << endl;
+    }
+    out.flush();
+    if (!out) {
+      cerr << "Error writing checkpoint file " << temporary_file_name;
+      cerr << endl;
+      return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+  }
+
+  if (rename(temporary_file_name.c_str(), checkpoint_file_name.c_str())
+      != 0) {
+    cerr << "Error writing checkpoint file " << checkpoint_file_name;
+    cerr << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  return NO_ERROR;
+}
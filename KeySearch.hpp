@@ -0,0 +1,160 @@
+#ifndef KEY_SEARCH_H
+#define KEY_SEARCH_H
+
+/* The KeySearch class runs an exhaustive search for the key of a
+   ciphertext over a set of reflectors, every ordered choice of rotors
+   from a set of rotor files and every starting position, with a fixed
+   plugboard. Each candidate key decrypts the ciphertext and is scored by
+   the coincidences of its plaintext (see Scorer), and the best ones are
+   kept.
+   The candidates are numbered, so any range of numbers can be searched
+   on its own. Candidate c has reflector c / (orders * positions), rotor
+   order c / positions % orders and positions c % positions, where the
+   rotor orders are numbered in lexicographic order of the rotor file
+   indices and the positions are the digits of a number with the leftmost
+   rotor most significant. A search is split into work units, each a
+   range of candidates written to a small text file together with the
+   ciphertext and the names of the configuration files, so units can be
+   run by independent processes on one machine.
+   A unit file holds one setting per line, with blank lines and lines
+   starting with '#' ignored:
+     ciphertext LETTERS
+     plugboard FILE
+     reflector FILE       (one line per reflector)
+     rotor FILE           (one line per rotor)
+     slots N              (the number of rotors in the machine)
+     keep N               (the number of best candidates kept)
+     range FIRST LAST     (the candidates FIRST to LAST - 1)
+   Running a unit writes its progress and best candidates to a checkpoint
+   file, the unit file name followed by ".checkpoint", every
+   SEARCH_CHECKPOINT_INTERVAL candidates and when it finishes:
+     range FIRST LAST
+     next N               (the first candidate not yet searched)
+     result SCORE CANDIDATE REFLECTOR ROTOR... | POSITION...
+   A unit whose checkpoint exists carries on from it, so a worker which
+   is killed loses at most one interval of work. Candidates with equal
+   scores are ranked by their numbers, so the results do not depend on
+   where a unit was interrupted, and merging the checkpoints of every
+   unit gives the same best candidates as one search over everything.
+   ciphertext_ contains the letters of the ciphertext.
+   plugboard_file_name_, reflector_file_names_ and rotor_file_names_ are
+   the names of the configuration files, which may be names of built-in
+   catalog entries.
+   number_of_slots_ is the number of rotors in each candidate machine.
+   number_to_keep_ is the number of best candidates kept.
+   first_candidate_ and last_candidate_ are the range of the unit.
+   next_candidate_ is the first candidate not yet searched.
+   results_ contains the best candidates found so far, best first. */
+
+#include "Enigma.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class KeySearch
+{
+public:
+  /* Function to initialise an empty KeySearch object. */
+  KeySearch();
+
+  /* Function to describe a whole search. The ciphertext is read from the
+     file named ciphertext_file_name, in which whitespace is skipped. The
+     configuration files are named by plugboard_file_name, the
+     number_of_reflectors names in reflector_file_names and the
+     number_of_rotors names in rotor_file_names; number_of_slots of the
+     rotors are used in each candidate and the best number_to_keep
+     candidates are kept. Every candidate is in the search's range.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int setUp(char const* ciphertext_file_name,
+	    char const* plugboard_file_name, int number_of_reflectors,
+	    char const* const* reflector_file_names, int number_of_rotors,
+	    char const* const* rotor_file_names, int number_of_slots,
+	    int number_to_keep);
+
+  /* Function to return the number of candidates in the whole search. */
+  std::uint64_t getNumberOfCandidates() const;
+
+  /* Function to split the search's range into number_of_units units of
+     nearly equal size and write them to files named unit_file_prefix
+     followed by the number of the unit and ".unit", printing each file
+     name to out.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int split(int number_of_units, char const* unit_file_prefix,
+	    std::ostream& out) const;
+
+  /* Function to read the unit file named unit_file_name.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int read(char const* unit_file_name);
+
+  /* Function to write the search as a unit file named unit_file_name.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int write(char const* unit_file_name) const;
+
+  /* Function to search the unit read from unit_file_name, carrying on
+     from its checkpoint file if there is one and writing the checkpoint
+     as it goes.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int run(char const* unit_file_name);
+
+  /* Function to merge the results of the number_of_files checkpoint
+     files named in checkpoint_file_names, and write the number_to_keep
+     best candidates to out, one per line as SCORE REFLECTOR ROTOR... |
+     POSITION... Units which have not finished are reported on cerr.
+     The function returns an error code corresponding to those in 'errors.h' */
+  static int merge(int number_of_files,
+		   char const* const* checkpoint_file_names,
+		   int number_to_keep, std::ostream& out);
+
+private:
+  /* A candidate kept by the search, with its score. */
+  struct SearchResult
+  {
+    std::uint64_t score;
+    std::uint64_t candidate;
+  };
+
+  std::string ciphertext_;
+  std::string plugboard_file_name_;
+  std::vector<std::string> reflector_file_names_;
+  std::vector<std::string> rotor_file_names_;
+  int number_of_slots_;
+  int number_to_keep_;
+  std::uint64_t first_candidate_;
+  std::uint64_t last_candidate_;
+  std::uint64_t next_candidate_;
+  std::vector<SearchResult> results_;
+
+  /* Function to return the number of starting positions and of rotor
+     orders of a candidate machine. */
+  std::uint64_t getNumberOfPositions() const;
+  std::uint64_t getNumberOfOrders() const;
+
+  /* Function to set reflector_index to the reflector of candidate, and
+     rotor_indices and positions, which must hold number_of_slots_
+     entries, to its rotor file indices and starting positions from the
+     leftmost rotor. */
+  void getCandidate(std::uint64_t candidate, int& reflector_index,
+		    int* rotor_indices, int* positions) const;
+
+  /* Function to write the settings of candidate to out as REFLECTOR
+     ROTOR... | POSITION... */
+  void writeCandidate(std::uint64_t candidate, std::ostream& out) const;
+
+  /* Function to keep candidate if its score is among the best so far. */
+  void addResult(std::uint64_t score, std::uint64_t candidate);
+
+  /* Function to read the checkpoint file named checkpoint_file_name, if
+     it exists, into next_candidate_ and results_.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int readCheckpoint(std::string const& checkpoint_file_name);
+
+  /* Function to write next_candidate_ and results_ to the checkpoint
+     file named checkpoint_file_name. The checkpoint is written to a
+     temporary file first and renamed over the old one, so a worker
+     killed while writing leaves the previous checkpoint intact.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int writeCheckpoint(std::string const& checkpoint_file_name) const;
+};
+
+#endif
@@ -0,0 +1,589 @@
+/* This file contains the member function definitions
+   for the KeySheet class */
+
+#include "KeySheet.hpp"
+#include "Enigma.hpp"
+#include "Profiler.hpp"
+#include "Catalog.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+  /* Header at the start of a compiled key sheet. */
+  struct KeySheetHeader
+  {
+    char magic[8];
+    uint32_t alphabet_size;
+    uint32_t number_of_entries;
+    uint32_t number_of_key_rotors;
+    uint32_t number_of_wirings;
+    uint32_t number_of_rotors;
+    uint32_t padding;
+  };
+
+  const char KEY_SHEET_MAGIC[8] = {'E', 'N', 'I', 'G', 'K', 'E', 'Y', '2'};
+
+  /* A key as it is stored in a compiled key sheet: the plugboard and
+     reflector wirings, each rotor laid out as in the compiled file and
+     the starting position of each rotor. */
+  struct CompiledKey
+  {
+    string plugboard;
+    string reflector;
+    vector<string> rotors;
+    vector<uint32_t> positions;
+  };
+
+  /* Function to return the offset of the notch bitmask in a rotor of a
+     compiled key sheet for an alphabet of alphabet_size symbols. */
+  size_t getNotchMaskOffset(int alphabet_size)
+  {
+    return (2 * static_cast<size_t>(alphabet_size) + 7) / 8 * 8;
+  }
+
+  /* Function to return the size of a rotor in a compiled key sheet for an
+     alphabet of alphabet_size symbols. */
+  size_t getRotorSize(int alphabet_size)
+  {
+    return getNotchMaskOffset(alphabet_size)
+      + (alphabet_size + 63) / 64 * sizeof(uint64_t);
+  }
+
+  /* Function to set up enigma from the text of each of its settings, in
+     the order taken by Enigma::setUp. key names the key in error
+     messages.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  template <int ALPHABET_SIZE>
+  int setUpFromText(BasicEnigma<ALPHABET_SIZE>& enigma,
+		    vector<string> const& texts, string const& key)
+  {
+    int number_of_settings = texts.size();
+    vector<istringstream> settings(number_of_settings);
+    vector<string> names(number_of_settings);
+    for (int i = 0; i < number_of_settings; i++) {
+      settings[i].str(texts[i]);
+      names[i] = "setting " + to_string(i) + " of key " + key;
+    }
+    names[0] = "plugboard of key " + key;
+    names[1] = "reflector of key " + key;
+    names[number_of_settings - 1] = "rotor positions of key " + key;
+
+    vector<istream*> setting_pointers(number_of_settings);
+    vector<char const*> setting_names(number_of_settings);
+    for (int i = 0; i < number_of_settings; i++) {
+      setting_pointers[i] = &settings[i];
+      setting_names[i] = names[i].c_str();
+    }
+
+    return enigma.setUp(number_of_settings, setting_pointers.data(),
+			setting_names.data());
+  }
+
+  /* Function to check that a machine coding ALPHABET_SIZE symbols can be
+     set up from texts, as setUpFromText does, and fill compiled with the
+     components of that machine.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  template <int ALPHABET_SIZE>
+  int compileKey(vector<string> const& texts, string const& key,
+		 CompiledKey& compiled)
+  {
+    auto enigma = BasicEnigma<ALPHABET_SIZE>();
+    int error_code = setUpFromText(enigma, texts, key);
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
+
+    compiled.plugboard.resize(ALPHABET_SIZE);
+    compiled.reflector.resize(ALPHABET_SIZE);
+    for (int i = 0; i < ALPHABET_SIZE; i++) {
+      compiled.plugboard[i] = enigma.getPlugboard().getPlugboardLetter(i);
+      compiled.reflector[i] = enigma.getReflector().getReflectorLetter(i);
+    }
+
+    size_t notch_mask_offset = getNotchMaskOffset(ALPHABET_SIZE);
+    compiled.rotors.clear();
+    compiled.positions.clear();
+    for (int i = 0; i < enigma.getNumberOfRotors(); i++) {
+      BasicRotor<ALPHABET_SIZE> const& rotor = enigma.getRotor(i);
+      string record(getRotorSize(ALPHABET_SIZE), '\0');
+      vector<uint64_t> notch_mask((ALPHABET_SIZE + 63) / 64);
+      for (int j = 0; j < ALPHABET_SIZE; j++) {
+	record[j] = rotor.getForwardRotorLetter(j, 0);
+	record[ALPHABET_SIZE + j] = rotor.getBackwardRotorLetter(j, 0);
+	if (rotor.isNotch(j)) {
+	  notch_mask[j / 64] |= static_cast<uint64_t>(1) << (j % 64);
+	}
+      }
+      memcpy(&record[notch_mask_offset], notch_mask.data(),
+	     notch_mask.size() * sizeof(uint64_t));
+      compiled.rotors.push_back(record);
+      compiled.positions.push_back(rotor.getTopLetter());
+    }
+    return NO_ERROR;
+  }
+
+  /* Function to return the index of record in records, adding it if it
+     is not there yet. indices maps each record to its index. */
+  uint32_t findRecord(string const& record, vector<string>& records,
+		      map<string, uint32_t>& indices)
+  {
+    auto found = indices.find(record);
+    if (found == indices.end()) {
+      found = indices.insert(make_pair(record, records.size())).first;
+      records.push_back(record);
+    }
+    return found->second;
+  }
+
+  /* Function to return true if wiring holds alphabet_size letter indices
+     which pair up letters, as those of a plugboard or reflector do. */
+  bool isPairing(uint8_t const* wiring, int alphabet_size)
+  {
+    for (int i = 0; i < alphabet_size; i++) {
+      if (wiring[i] >= alphabet_size || wiring[wiring[i]] != i) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  /* Function to return true if rotor is a rotor of a compiled key sheet
+     for an alphabet of alphabet_size symbols, with a backward wiring which
+     is the inverse of its forward wiring and no notches past the end of
+     the alphabet. */
+  bool isRotor(uint8_t const* rotor, int alphabet_size)
+  {
+    uint8_t const* backward = rotor + alphabet_size;
+    for (int i = 0; i < alphabet_size; i++) {
+      if (rotor[i] >= alphabet_size || backward[rotor[i]] != i) {
+	return false;
+      }
+    }
+
+    uint64_t notch_mask[(BYTE_ALPHABET_LENGTH + 63) / 64];
+    int number_of_words = (alphabet_size + 63) / 64;
+    memcpy(notch_mask, rotor + getNotchMaskOffset(alphabet_size),
+	   number_of_words * sizeof(uint64_t));
+    int unused_bits = number_of_words * 64 - alphabet_size;
+    return unused_bits == 0 ||
+      (notch_mask[number_of_words - 1] >> (64 - unused_bits)) == 0;
+  }
+}
+
+KeySheet::KeySheet() :
+  mapping_(nullptr),
+  mapping_size_(0),
+  entries_(nullptr),
+  key_rotors_(nullptr),
+  wirings_(nullptr),
+  rotors_(nullptr),
+  rotor_size_(0),
+  alphabet_size_(0),
+  number_of_entries_(0) {}
+
+KeySheet::~KeySheet()
+{
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+int KeySheet::write(char const* sheet_file_name, int alphabet_size,
+		    char const* file_name)
+{
+  ifstream sheet(sheet_file_name);
+  if (sheet.fail()) {
+    cerr << "Error opening key sheet file " << sheet_file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  vector<KeyEntry> entries;
+  vector<vector<KeyRotor>> entry_rotors;
+  vector<string> wirings;
+  map<string, uint32_t> wiring_indices;
+  vector<string> rotor_records;
+  map<string, uint32_t> rotor_indices;
+  string line;
+  for (int line_number = 1; getline(sheet, line); line_number++) {
+    istringstream fields(line);
+    string net, date, token;
+    if (!(fields >> net) || net[0] == '#') {
+      continue;
+    }
+
+    vector<string> component_files;
+    fields >> date;
+    while (fields >> token && token != "|") {
+      component_files.push_back(token);
+    }
+    bool has_plugboard = (token == "|");
+    string plugboard;
+    token.clear();
+    while (fields >> token && token != "|") {
+      plugboard += token + " ";
+    }
+    bool has_positions = (token == "|");
+    string positions;
+    while (fields >> token) {
+      positions += token + " ";
+    }
+
+    KeyEntry entry = {};
+    if (!has_plugboard || !has_positions || component_files.empty() ||
+	!parseKey((net + ":" + date).c_str(), entry)) {
+      cerr << "Invalid key on line " << line_number << " of key sheet file ";
+      cerr << sheet_file_name << endl;
+      return INVALID_ARGUMENT;
+    }
+
+    vector<string> key_texts;
+    key_texts.push_back(plugboard);
+    for (size_t i = 0; i < component_files.size(); i++) {
+      if (isBuiltinName(component_files[i].c_str())) {
+	ostringstream component;
+	if (!writeBuiltinSetting((i == 0) ? SETTING_REFLECTOR : SETTING_ROTOR,
+				 component_files[i].c_str(), component)) {
+	  cerr << "There is no built-in component " << component_files[i];
+	  cerr << endl;
+	  return ERROR_OPENING_CONFIGURATION_FILE;
+	}
+	key_texts.push_back(component.str());
+	continue;
+      }
+
+      ifstream component(component_files[i]);
+      if (component.fail()) {
+	cerr << "Error opening configuration file " << component_files[i];
+	cerr << endl;
+	return ERROR_OPENING_CONFIGURATION_FILE;
+      }
+      key_texts.push_back(string(istreambuf_iterator<char>(component),
+				 istreambuf_iterator<char>()));
+    }
+    key_texts.push_back(positions);
+
+    string key = net + ":" + date;
+    CompiledKey compiled;
+    int error_code = (alphabet_size == ALPHABET_LENGTH)
+      ? compileKey<ALPHABET_LENGTH>(key_texts, key, compiled)
+      : compileKey<BYTE_ALPHABET_LENGTH>(key_texts, key, compiled);
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
+
+    entry.plugboard = findRecord(compiled.plugboard, wirings,
+				 wiring_indices);
+    entry.reflector = findRecord(compiled.reflector, wirings,
+				 wiring_indices);
+    vector<KeyRotor> rotors;
+    for (size_t i = 0; i < compiled.rotors.size(); i++) {
+      KeyRotor rotor = {findRecord(compiled.rotors[i], rotor_records,
+				   rotor_indices),
+			compiled.positions[i]};
+      rotors.push_back(rotor);
+    }
+    entries.push_back(entry);
+    entry_rotors.push_back(rotors);
+  }
+
+  vector<size_t> order(entries.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  sort(order.begin(), order.end(), [&entries](size_t first, size_t second) {
+      return isBefore(entries[first], entries[second]);
+    });
+  for (size_t i = 1; i < order.size(); i++) {
+    if (!isBefore(entries[order[i - 1]], entries[order[i]])) {
+      cerr << "Key " << entries[order[i]].net << ":";
+      cerr << entries[order[i]].date << " appears more than once in key";
+      cerr << " sheet file " << sheet_file_name << endl;
+      return INVALID_ARGUMENT;
+    }
+  }
+
+  vector<KeyEntry> sorted_entries;
+  vector<KeyRotor> key_rotors;
+  for (size_t i = 0; i < order.size(); i++) {
+    KeyEntry entry = entries[order[i]];
+    vector<KeyRotor> const& rotors = entry_rotors[order[i]];
+    entry.first_rotor = key_rotors.size();
+    entry.number_of_rotors = rotors.size();
+    key_rotors.insert(key_rotors.end(), rotors.begin(), rotors.end());
+    sorted_entries.push_back(entry);
+  }
+
+  ofstream out(file_name, ios::binary);
+  if (out.fail()) {
+    cerr << "Error opening key sheet file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  KeySheetHeader header = {};
+  memcpy(header.magic, KEY_SHEET_MAGIC, sizeof(KEY_SHEET_MAGIC));
+  header.alphabet_size = alphabet_size;
+  header.number_of_entries = sorted_entries.size();
+  header.number_of_key_rotors = key_rotors.size();
+  header.number_of_wirings = wirings.size();
+  header.number_of_rotors = rotor_records.size();
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  out.write(reinterpret_cast<char const*>(sorted_entries.data()),
+	    sorted_entries.size() * sizeof(KeyEntry));
+  out.write(reinterpret_cast<char const*>(key_rotors.data()),
+	    key_rotors.size() * sizeof(KeyRotor));
+  for (size_t i = 0; i < wirings.size(); i++) {
+    out.write(wirings[i].data(), wirings[i].size());
+  }
+  size_t wirings_size = wirings.size() * alphabet_size;
+  string padding((wirings_size + 7) / 8 * 8 - wirings_size, '\0');
+  out.write(padding.data(), padding.size());
+  for (size_t i = 0; i < rotor_records.size(); i++) {
+    out.write(rotor_records[i].data(), rotor_records[i].size());
+  }
+
+  if (!out) {
+    cerr << "Error writing key sheet file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  return NO_ERROR;
+}
+
+int KeySheet::setUp(char const* file_name)
+{
+  int fd = open(file_name, O_RDONLY);
+  struct stat status;
+  if (fd < 0 || fstat(fd, &status) != 0) {
+    cerr << "Error opening key sheet file " << file_name << endl;
+    if (fd >= 0) {
+      close(fd);
+    }
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  size_t size = status.st_size;
+  void* mapping = (size >= sizeof(KeySheetHeader))
+    ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+
+  KeySheetHeader const* header = static_cast<KeySheetHeader const*>(mapping);
+  if (mapping == MAP_FAILED ||
+      memcmp(header->magic, KEY_SHEET_MAGIC, sizeof(KEY_SHEET_MAGIC)) != 0) {
+    cerr << file_name << " is not a compiled key sheet file" << endl;
+    if (mapping != MAP_FAILED) {
+      munmap(mapping, size);
+    }
+    return INVALID_ARGUMENT;
+  }
+
+  // Every part, and every wiring, rotor and key inside it, must lie
+  // inside the file and be well formed, so lookups need no further checks.
+  char const* start = static_cast<char const*>(mapping);
+  int alphabet_size = header->alphabet_size;
+  bool is_complete = (alphabet_size == ALPHABET_LENGTH ||
+		      alphabet_size == BYTE_ALPHABET_LENGTH);
+  size_t rotor_size = is_complete ? getRotorSize(alphabet_size) : 0;
+  size_t entries_start = sizeof(KeySheetHeader);
+  size_t key_rotors_start = entries_start
+    + static_cast<size_t>(header->number_of_entries) * sizeof(KeyEntry);
+  size_t wirings_start = key_rotors_start
+    + static_cast<size_t>(header->number_of_key_rotors) * sizeof(KeyRotor);
+  size_t rotors_start = wirings_start
+    + (static_cast<size_t>(header->number_of_wirings) * alphabet_size + 7)
+    / 8 * 8;
+  size_t end = rotors_start
+    + static_cast<size_t>(header->number_of_rotors) * rotor_size;
+  is_complete = (is_complete && end <= size);
+
+  KeyEntry const* entries =
+    reinterpret_cast<KeyEntry const*>(start + entries_start);
+  KeyRotor const* key_rotors =
+    reinterpret_cast<KeyRotor const*>(start + key_rotors_start);
+  uint8_t const* wirings =
+    reinterpret_cast<uint8_t const*>(start + wirings_start);
+  uint8_t const* rotors =
+    reinterpret_cast<uint8_t const*>(start + rotors_start);
+  bool is_valid = is_complete;
+  for (uint32_t i = 0; is_valid && i < header->number_of_wirings; i++) {
+    is_valid = isPairing(wirings + i * alphabet_size, alphabet_size);
+  }
+  for (uint32_t i = 0; is_valid && i < header->number_of_rotors; i++) {
+    is_valid = isRotor(rotors + i * rotor_size, alphabet_size);
+  }
+  for (uint32_t i = 0; is_valid && i < header->number_of_key_rotors; i++) {
+    is_valid = (key_rotors[i].rotor < header->number_of_rotors &&
+		key_rotors[i].position <
+		static_cast<uint32_t>(alphabet_size));
+  }
+  for (uint32_t i = 0; is_valid && i < header->number_of_entries; i++) {
+    KeyEntry const& entry = entries[i];
+    is_valid = (entry.plugboard < header->number_of_wirings &&
+		entry.reflector < header->number_of_wirings &&
+		entry.number_of_rotors >= 1 &&
+		entry.first_rotor <= header->number_of_key_rotors &&
+		entry.number_of_rotors <=
+		header->number_of_key_rotors - entry.first_rotor &&
+		entry.net[KEY_FIELD_LENGTH - 1] == '\0' &&
+		entry.date[KEY_FIELD_LENGTH - 1] == '\0');
+  }
+  if (!is_valid) {
+    cerr << "Key sheet file " << file_name;
+    cerr << (is_complete ? " is corrupt" : " is truncated") << endl;
+    munmap(mapping, size);
+    return INVALID_ARGUMENT;
+  }
+
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = mapping;
+  mapping_size_ = size;
+  entries_ = entries;
+  key_rotors_ = key_rotors;
+  wirings_ = wirings;
+  rotors_ = rotors;
+  rotor_size_ = rotor_size;
+  alphabet_size_ = alphabet_size;
+  number_of_entries_ = header->number_of_entries;
+
+  return NO_ERROR;
+}
+
+int KeySheet::getNumberOfEntries() const
+{
+  return number_of_entries_;
+}
+
+template <int ALPHABET_SIZE>
+int KeySheet::setUpEnigma(char const* key,
+			  BasicEnigma<ALPHABET_SIZE>& enigma,
+			  Profiler* profiler) const
+{
+  if (alphabet_size_ != ALPHABET_SIZE) {
+    cerr << "The key sheet is for machines with " << alphabet_size_;
+    cerr << " symbols, not " << ALPHABET_SIZE << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  KeyEntry const* entry = findEntry(key);
+  if (entry == nullptr) {
+    cerr << "There is no key " << key << " in the key sheet" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  int number_of_rotors = entry->number_of_rotors;
+  size_t notch_mask_offset = getNotchMaskOffset(ALPHABET_SIZE);
+  vector<uint8_t const*> forward_wirings(number_of_rotors);
+  vector<uint8_t const*> backward_wirings(number_of_rotors);
+  vector<uint64_t const*> notch_masks(number_of_rotors);
+  vector<int> positions(number_of_rotors);
+  for (int i = 0; i < number_of_rotors; i++) {
+    KeyRotor const& key_rotor = key_rotors_[entry->first_rotor + i];
+    uint8_t const* rotor = rotors_ + key_rotor.rotor * rotor_size_;
+    forward_wirings[i] = rotor;
+    backward_wirings[i] = rotor + ALPHABET_SIZE;
+    notch_masks[i] =
+      reinterpret_cast<uint64_t const*>(rotor + notch_mask_offset);
+    positions[i] = key_rotor.position;
+  }
+
+  return enigma.setUp(wirings_ + entry->plugboard * ALPHABET_SIZE,
+		      wirings_ + entry->reflector * ALPHABET_SIZE,
+		      number_of_rotors, forward_wirings.data(),
+		      backward_wirings.data(), notch_masks.data(),
+		      positions.data(), profiler);
+}
+
+bool KeySheet::parseKey(char const* key, KeyEntry& entry)
+{
+  char const* separator = strchr(key, ':');
+  if (separator == nullptr || separator == key ||
+      separator - key >= KEY_FIELD_LENGTH ||
+      strlen(separator + 1) >= KEY_FIELD_LENGTH ||
+      !isDate(separator + 1)) {
+    return false;
+  }
+
+  memset(entry.net, 0, sizeof(entry.net));
+  memset(entry.date, 0, sizeof(entry.date));
+  memcpy(entry.net, key, separator - key);
+  strcpy(entry.date, separator + 1);
+  return true;
+}
+
+bool KeySheet::isDate(char const* date)
+{
+  char const layout[] = "0000-00-00";
+  if (strlen(date) != strlen(layout)) {
+    return false;
+  }
+  for (size_t i = 0; layout[i] != '\0'; i++) {
+    bool is_digit = (date[i] >= ASCII_ZERO && date[i] <= ASCII_NINE);
+    if ((layout[i] == '-') ? date[i] != '-' : !is_digit) {
+      return false;
+    }
+  }
+
+  int year = atoi(date);
+  int month = atoi(date + 5);
+  int day = atoi(date + 8);
+  int const days_in_month[] = {31, 28, 31, 30, 31, 30,
+			       31, 31, 30, 31, 30, 31};
+  if (month < 1 || month > 12) {
+    return false;
+  }
+  bool is_leap_year = (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
+  int month_length = days_in_month[month - 1]
+    + ((month == 2 && is_leap_year) ? 1 : 0);
+  return day >= 1 && day <= month_length;
+}
+
+bool KeySheet::isBefore(KeyEntry const& first, KeyEntry const& second)
+{
+  int net_order = memcmp(first.net, second.net, KEY_FIELD_LENGTH);
+  if (net_order != 0) {
+    return net_order < 0;
+  }
+  return memcmp(first.date, second.date, KEY_FIELD_LENGTH) < 0;
+}
+
+KeySheet::KeyEntry const* KeySheet::findEntry(char const* key) const
+{
+  KeyEntry wanted = {};
+  if (!parseKey(key, wanted)) {
+    return nullptr;
+  }
+
+  KeyEntry const* end = entries_ + number_of_entries_;
+  KeyEntry const* found = lower_bound(entries_, end, wanted, isBefore);
+  if (found == end || isBefore(wanted, *found)) {
+    return nullptr;
+  }
+  return found;
+}
+
+template int KeySheet::setUpEnigma(char const* key,
+				   BasicEnigma<ALPHABET_LENGTH>& enigma,
+				   Profiler* profiler) const;
+template int KeySheet::setUpEnigma(char const* key,
+				   BasicEnigma<BYTE_ALPHABET_LENGTH>& enigma,
+				   Profiler* profiler) const;
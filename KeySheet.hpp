@@ -0,0 +1,123 @@
+#ifndef KEY_SHEET_H
+#define KEY_SHEET_H
+
+/* The KeySheet class holds the daily keys of one or more nets, so the
+   machine for a day can be set up from a single file instead of one
+   file per component.
+   A key sheet is written as text, one key per line:
+     net date reflector-file (<rotor-file>)* | plugboard | positions
+   where net is a name of up to 15 characters, date is written as
+   YYYY-MM-DD, plugboard contains the numbers of a plugboard file and
+   positions the numbers of a rotor position file. Blank lines and lines
+   starting with '#' are ignored. Every key is checked by setting up a
+   machine with it when the sheet is compiled, and the wirings, notches
+   and positions of that machine are stored in the compiled file, so a
+   key is set up again without reading any settings.
+   The compiled file is laid out so it can be mapped straight into
+   memory:
+     a header (see KeySheetHeader in 'KeySheet.cpp'),
+     the keys (see KeyEntry), sorted by net and then date, so a key is
+     found with a binary search,
+     the rotors of every key (see KeyRotor),
+     the plugboard and reflector wirings, alphabet_size_ letter indices
+     each, padded to a multiple of 8 bytes, and
+     the rotors, each laid out as its forward wiring, its backward wiring,
+     padding to a multiple of 8 bytes and its notch bitmask, as taken by
+     Rotor::setUp.
+   Wirings and rotors shared by several keys are only stored once.
+   mapping_ and mapping_size_ describe the mapped file.
+   entries_, key_rotors_, wirings_ and rotors_ point to the parts of it,
+   and rotor_size_ is the size of each rotor.
+   alphabet_size_ and number_of_entries_ are taken from the header. */
+
+#include "Enigma.hpp"
+#include "Profiler.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/* Longest net name and date, including the terminating null. */
+#define KEY_FIELD_LENGTH 16
+
+class KeySheet
+{
+public:
+  /* Function to initialise an empty KeySheet object. */
+  KeySheet();
+
+  /* Destructor, which unmaps the key sheet file. */
+  ~KeySheet();
+
+  KeySheet(KeySheet const&) = delete;
+  KeySheet& operator=(KeySheet const&) = delete;
+
+  /* Function to compile the text key sheet named sheet_file_name for
+     machines coding an alphabet of alphabet_size symbols, and write it to
+     the file named file_name.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  static int write(char const* sheet_file_name, int alphabet_size,
+		   char const* file_name);
+
+  /* Function to map the compiled key sheet named file_name into memory.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int setUp(char const* file_name);
+
+  /* Function to return the number of keys in the sheet. */
+  int getNumberOfEntries() const;
+
+  /* Function to set up enigma with the key named key, written as
+     NET:DATE. profiler is passed on to Enigma::setUp.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  template <int ALPHABET_SIZE>
+  int setUpEnigma(char const* key, BasicEnigma<ALPHABET_SIZE>& enigma,
+		  Profiler* profiler = nullptr) const;
+
+private:
+  /* A key in the compiled file. plugboard and reflector index wirings_
+     and the rotors of the key are key_rotors_[first_rotor] onwards. */
+  struct KeyEntry
+  {
+    char net[KEY_FIELD_LENGTH];
+    char date[KEY_FIELD_LENGTH];
+    std::uint32_t plugboard;
+    std::uint32_t reflector;
+    std::uint32_t first_rotor;
+    std::uint32_t number_of_rotors;
+  };
+
+  /* A rotor of a key: the index of the rotor in rotors_ and its starting
+     position. */
+  struct KeyRotor
+  {
+    std::uint32_t rotor;
+    std::uint32_t position;
+  };
+
+  void* mapping_;
+  std::size_t mapping_size_;
+  KeyEntry const* entries_;
+  KeyRotor const* key_rotors_;
+  std::uint8_t const* wirings_;
+  std::uint8_t const* rotors_;
+  std::size_t rotor_size_;
+  int alphabet_size_;
+  int number_of_entries_;
+
+  /* Function to fill entry with the net and date of key, written as
+     NET:DATE. Returns false if key is not written that way. */
+  static bool parseKey(char const* key, KeyEntry& entry);
+
+  /* Function to return true if date is a date written as YYYY-MM-DD. */
+  static bool isDate(char const* date);
+
+  /* Function to return true if first comes before second in the sorted
+     keys. */
+  static bool isBefore(KeyEntry const& first, KeyEntry const& second);
+
+  /* Function to return the key named key, or nullptr if there is none. */
+  KeyEntry const* findEntry(char const* key) const;
+};
+
+#endif
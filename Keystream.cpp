@@ -0,0 +1,136 @@
+/* This file contains the member function definitions
+   for the Keystream and KeystreamIterator class templates */
+
+#include "Keystream.hpp"
+#include "EnigmaSpec.hpp"
+#include "EnigmaCursor.hpp"
+#include "constants.h"
+#include <cstdint>
+
+using namespace std;
+
+template <int ALPHABET_SIZE>
+BasicKeystreamIterator<ALPHABET_SIZE>::BasicKeystreamIterator(
+    BasicEnigmaSpec<ALPHABET_SIZE> const& spec,
+    uint64_t keystroke) :
+  cursor_(spec),
+  cursor_steps_(0),
+  keystroke_(keystroke),
+  permutation_(),
+  is_permutation_ready_(false) {}
+
+template <int ALPHABET_SIZE>
+typename BasicKeystreamIterator<ALPHABET_SIZE>::reference
+BasicKeystreamIterator<ALPHABET_SIZE>::operator*() const
+{
+  if (!is_permutation_ready_) {
+    catchUp();
+    cursor_.getPermutation(permutation_.data());
+    is_permutation_ready_ = true;
+  }
+  return permutation_;
+}
+
+template <int ALPHABET_SIZE>
+typename BasicKeystreamIterator<ALPHABET_SIZE>::pointer
+BasicKeystreamIterator<ALPHABET_SIZE>::operator->() const
+{
+  return &**this;
+}
+
+template <int ALPHABET_SIZE>
+BasicKeystreamIterator<ALPHABET_SIZE>&
+BasicKeystreamIterator<ALPHABET_SIZE>::operator++()
+{
+  return *this += 1;
+}
+
+template <int ALPHABET_SIZE>
+BasicKeystreamIterator<ALPHABET_SIZE>
+BasicKeystreamIterator<ALPHABET_SIZE>::operator++(int)
+{
+  BasicKeystreamIterator previous(*this);
+  *this += 1;
+  return previous;
+}
+
+template <int ALPHABET_SIZE>
+BasicKeystreamIterator<ALPHABET_SIZE>&
+BasicKeystreamIterator<ALPHABET_SIZE>::operator+=(
+    uint64_t number_of_keystrokes)
+{
+  if (number_of_keystrokes > 0) {
+    keystroke_ += number_of_keystrokes;
+    is_permutation_ready_ = false;
+  }
+  return *this;
+}
+
+template <int ALPHABET_SIZE>
+uint64_t BasicKeystreamIterator<ALPHABET_SIZE>::getKeystroke() const
+{
+  return keystroke_;
+}
+
+template <int ALPHABET_SIZE>
+int BasicKeystreamIterator<ALPHABET_SIZE>::getPosition(int rotor_index) const
+{
+  catchUp();
+  return cursor_.getPosition(rotor_index);
+}
+
+template <int ALPHABET_SIZE>
+bool BasicKeystreamIterator<ALPHABET_SIZE>::operator==(
+    BasicKeystreamIterator const& other) const
+{
+  return keystroke_ == other.keystroke_;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicKeystreamIterator<ALPHABET_SIZE>::operator!=(
+    BasicKeystreamIterator const& other) const
+{
+  return keystroke_ != other.keystroke_;
+}
+
+template <int ALPHABET_SIZE>
+void BasicKeystreamIterator<ALPHABET_SIZE>::catchUp() const
+{
+  // Keystroke k is coded after the rotors have stepped k + 1 times.
+  if (cursor_steps_ < keystroke_ + 1) {
+    cursor_.advance(keystroke_ + 1 - cursor_steps_);
+    cursor_steps_ = keystroke_ + 1;
+  }
+}
+
+template <int ALPHABET_SIZE>
+BasicKeystream<ALPHABET_SIZE>::BasicKeystream(
+    BasicEnigmaSpec<ALPHABET_SIZE> const& spec,
+    uint64_t length) :
+  spec_(&spec),
+  length_(length) {}
+
+template <int ALPHABET_SIZE>
+typename BasicKeystream<ALPHABET_SIZE>::iterator
+BasicKeystream<ALPHABET_SIZE>::begin() const
+{
+  return iterator(*spec_, 0);
+}
+
+template <int ALPHABET_SIZE>
+typename BasicKeystream<ALPHABET_SIZE>::iterator
+BasicKeystream<ALPHABET_SIZE>::end() const
+{
+  return iterator(*spec_, length_);
+}
+
+template <int ALPHABET_SIZE>
+uint64_t BasicKeystream<ALPHABET_SIZE>::size() const
+{
+  return length_;
+}
+
+template class BasicKeystreamIterator<ALPHABET_LENGTH>;
+template class BasicKeystreamIterator<BYTE_ALPHABET_LENGTH>;
+template class BasicKeystream<ALPHABET_LENGTH>;
+template class BasicKeystream<BYTE_ALPHABET_LENGTH>;
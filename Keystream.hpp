@@ -0,0 +1,126 @@
+#ifndef KEYSTREAM_H
+#define KEYSTREAM_H
+
+/* The Keystream class template is a range over the keystrokes of a
+   message: element k is the permutation the machine codes with on
+   keystroke k (counting from 0), after the rotors have stepped for it,
+   together with the rotor positions. Nothing is worked out until it is
+   asked for, so a whole period can be walked, or sampled, without coding
+   every letter at every position; and it runs on an EnigmaCursor over an
+   EnigmaSpec, so the machine the spec was taken from is never stepped.
+   A Keystream is used with range-based for loops and the standard
+   algorithms like any input range, for example
+     for (KeystreamIterator::value_type const& permutation : keystream)
+   The iterators also skip ahead with += in time proportional to the
+   number of carries rather than the number of keystrokes skipped.
+   spec_ points to the configuration coded with, which must outlive the
+   keystream and its iterators.
+   length_ is the number of keystrokes in the range, or KEYSTREAM_ENDLESS
+   for a range with no end.
+   Keystream is taken from an EnigmaSpec and ByteKeystream from a
+   ByteEnigmaSpec. */
+
+#include "EnigmaSpec.hpp"
+#include "EnigmaCursor.hpp"
+#include "constants.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/* Length of a keystream which never ends. */
+#define KEYSTREAM_ENDLESS UINT64_MAX
+
+/* The KeystreamIterator class template walks the keystrokes of a
+   Keystream. Moving the iterator only counts the keystrokes to skip; the
+   cursor is stepped over them when the iterator is next dereferenced or
+   asked for a position, and the permutation is only worked out when it
+   is dereferenced. Copies of an iterator walk on independently.
+   cursor_, cursor_steps_, permutation_ and is_permutation_ready_ are
+   brought up to date by the const functions which need them.
+   cursor_steps_ is the number of keystrokes cursor_ has stepped for, so
+   cursor_ is at the positions of keystroke cursor_steps_ - 1.
+   keystroke_ is the keystroke the iterator is at.
+   permutation_ holds the permutation of keystroke_ once
+   is_permutation_ready_ is true. */
+template <int ALPHABET_SIZE>
+class BasicKeystreamIterator
+{
+public:
+  typedef std::input_iterator_tag iterator_category;
+  typedef std::array<std::uint8_t, ALPHABET_SIZE> value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef value_type const* pointer;
+  typedef value_type const& reference;
+
+  /* Function to initialise an iterator at keystroke of a message coded
+     with spec from its starting positions. */
+  BasicKeystreamIterator(BasicEnigmaSpec<ALPHABET_SIZE> const& spec,
+			 std::uint64_t keystroke);
+
+  /* Function to return the permutation of the current keystroke, which
+     maps each letter index to the letter index it is coded to. */
+  reference operator*() const;
+  pointer operator->() const;
+
+  /* Functions to move to the next keystroke. */
+  BasicKeystreamIterator& operator++();
+  BasicKeystreamIterator operator++(int);
+
+  /* Function to skip number_of_keystrokes keystrokes ahead. */
+  BasicKeystreamIterator& operator+=(std::uint64_t number_of_keystrokes);
+
+  /* Function to return the number of the current keystroke. */
+  std::uint64_t getKeystroke() const;
+
+  /* Function to return the position of the rotor accessed by index at
+     the current keystroke, without working out the permutation. */
+  int getPosition(int rotor_index) const;
+
+  /* Functions to compare the keystrokes two iterators of the same range
+     are at. */
+  bool operator==(BasicKeystreamIterator const& other) const;
+  bool operator!=(BasicKeystreamIterator const& other) const;
+
+private:
+  mutable BasicEnigmaCursor<ALPHABET_SIZE> cursor_;
+  mutable std::uint64_t cursor_steps_;
+  std::uint64_t keystroke_;
+  mutable value_type permutation_;
+  mutable bool is_permutation_ready_;
+
+  /* Function to step cursor_ to the positions of keystroke_. */
+  void catchUp() const;
+};
+
+template <int ALPHABET_SIZE>
+class BasicKeystream
+{
+public:
+  typedef BasicKeystreamIterator<ALPHABET_SIZE> iterator;
+  typedef BasicKeystreamIterator<ALPHABET_SIZE> const_iterator;
+
+  /* Function to initialise the range of the first length keystrokes of
+     a message coded with spec from its starting positions. */
+  explicit BasicKeystream(BasicEnigmaSpec<ALPHABET_SIZE> const& spec,
+			  std::uint64_t length = KEYSTREAM_ENDLESS);
+
+  /* Functions to return iterators at the first keystroke and one past
+     the last. */
+  iterator begin() const;
+  iterator end() const;
+
+  /* Function to return the number of keystrokes in the range. */
+  std::uint64_t size() const;
+
+private:
+  BasicEnigmaSpec<ALPHABET_SIZE> const* spec_;
+  std::uint64_t length_;
+};
+
+typedef BasicKeystreamIterator<ALPHABET_LENGTH> KeystreamIterator;
+typedef BasicKeystreamIterator<BYTE_ALPHABET_LENGTH> ByteKeystreamIterator;
+typedef BasicKeystream<ALPHABET_LENGTH> Keystream;
+typedef BasicKeystream<BYTE_ALPHABET_LENGTH> ByteKeystream;
+
+#endif
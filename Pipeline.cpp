@@ -0,0 +1,247 @@
+/* This file contains the member function definitions
+   for the Pipeline class template */
+
+#include "Pipeline.hpp"
+#include "Enigma.hpp"
+#include "BlockRing.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+  /* Number of times a waiting stage yields before it starts sleeping. */
+  const int YIELDS_BEFORE_SLEEPING = 1024;
+
+  /* Time a waiting stage sleeps between checks once it has stopped
+     yielding, and the longest time the reader waits for input before
+     checking whether the pipeline is stopping. */
+  const chrono::microseconds WAIT_SLEEP(50);
+  const int INPUT_POLL_MILLISECONDS = 100;
+
+  /* Function to pause a waiting stage. attempts is the number of times
+     the stage has already waited. */
+  void backOff(int attempts)
+  {
+    if (attempts < YIELDS_BEFORE_SLEEPING) {
+      this_thread::yield();
+    } else {
+      this_thread::sleep_for(WAIT_SLEEP);
+    }
+  }
+}
+
+template <int ALPHABET_SIZE>
+BasicPipeline<ALPHABET_SIZE>::BasicPipeline(
+    BasicEnigma<ALPHABET_SIZE>& enigma,
+    int input_fd, int output_fd,
+    int number_of_blocks,
+    size_t block_size) :
+  enigma_(enigma),
+  input_fd_(input_fd),
+  output_fd_(output_fd),
+  blocks_(number_of_blocks),
+  free_blocks_(number_of_blocks),
+  read_blocks_(number_of_blocks),
+  coded_blocks_(number_of_blocks),
+  is_stopping_(false),
+  error_code_(NO_ERROR),
+  invalid_character_(0)
+{
+  for (int i = 0; i < number_of_blocks; i++) {
+    blocks_[i].data.resize(block_size);
+    blocks_[i].length = 0;
+    blocks_[i].is_last = false;
+    free_blocks_.push(i);
+  }
+}
+
+template <int ALPHABET_SIZE>
+int BasicPipeline<ALPHABET_SIZE>::run()
+{
+  thread reader(&BasicPipeline::readInput, this);
+  thread encoder(&BasicPipeline::codeInput, this);
+  thread writer(&BasicPipeline::writeOutput, this);
+
+  writer.join();
+  encoder.join();
+  reader.join();
+
+  return error_code_;
+}
+
+template <int ALPHABET_SIZE>
+char BasicPipeline<ALPHABET_SIZE>::getInvalidCharacter() const
+{
+  return invalid_character_;
+}
+
+template <int ALPHABET_SIZE>
+void BasicPipeline<ALPHABET_SIZE>::readInput()
+{
+  bool is_last = false;
+  while (!is_last) {
+    int block_index;
+    if (!waitToPop(free_blocks_, block_index) || !waitForInput()) {
+      return;
+    }
+
+    Block& block = blocks_[block_index];
+    ssize_t length = read(input_fd_, block.data.data(), block.data.size());
+    while (length < 0 && errno == EINTR) {
+      length = read(input_fd_, block.data.data(), block.data.size());
+    }
+
+    // A read error ends the stream like the end of the file does.
+    is_last = (length <= 0);
+    block.length = (length > 0) ? length : 0;
+    block.is_last = is_last;
+
+    if (!waitToPush(read_blocks_, block_index)) {
+      return;
+    }
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicPipeline<ALPHABET_SIZE>::codeInput()
+{
+  bool is_last = false;
+  while (!is_last) {
+    int block_index;
+    if (!waitToPop(read_blocks_, block_index)) {
+      return;
+    }
+
+    Block& block = blocks_[block_index];
+    int code_error = codeBlock(block);
+    if (code_error != NO_ERROR) {
+      error_code_ = code_error;
+      block.is_last = true;
+    }
+    is_last = block.is_last;
+
+    if (!waitToPush(coded_blocks_, block_index)) {
+      return;
+    }
+  }
+
+  // Release the reader, which may still be waiting for a free block or
+  // for more input after an error.
+  is_stopping_.store(true, memory_order_release);
+}
+
+template <int ALPHABET_SIZE>
+void BasicPipeline<ALPHABET_SIZE>::writeOutput()
+{
+  bool is_last = false;
+  while (!is_last) {
+    int block_index;
+    if (!waitToPop(coded_blocks_, block_index)) {
+      return;
+    }
+
+    Block& block = blocks_[block_index];
+    size_t written = 0;
+    while (written < block.length) {
+      ssize_t length = write(output_fd_, block.data.data() + written,
+			     block.length - written);
+      if (length < 0 && errno == EINTR) {
+	continue;
+      }
+      if (length <= 0) {
+	is_stopping_.store(true, memory_order_release);
+	return;
+      }
+      written += length;
+    }
+    is_last = block.is_last;
+
+    free_blocks_.push(block_index);
+  }
+}
+
+template <int ALPHABET_SIZE>
+int BasicPipeline<ALPHABET_SIZE>::codeBlock(Block& block)
+{
+  char* data = block.data.data();
+
+  if (ALPHABET_SIZE != ALPHABET_LENGTH) {
+    enigma_.codeBlock(data, block.length);
+    return NO_ERROR;
+  }
+
+  // The letters are gathered first so that they can be coded as a block.
+  size_t letters_length = 0;
+  int error_code = NO_ERROR;
+  for (size_t i = 0; i < block.length; i++) {
+    char next = data[i];
+    if (isspace(static_cast<unsigned char>(next))) {
+      continue;
+    }
+    if (next < ASCII_A || next > ASCII_Z) {
+      invalid_character_ = next;
+      error_code = INVALID_INPUT_CHARACTER;
+      break;
+    }
+    data[letters_length++] = next;
+  }
+  enigma_.codeBlock(data, letters_length);
+  block.length = letters_length;
+
+  return error_code;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicPipeline<ALPHABET_SIZE>::waitToPop(BlockRing& ring,
+					     int& block_index)
+{
+  for (int attempts = 0; !ring.pop(block_index); attempts++) {
+    // A stage pushes its last block before it sets is_stopping_, so the
+    // ring is tried once more to pick up a block pushed since the pop.
+    if (is_stopping_.load(memory_order_acquire)) {
+      return ring.pop(block_index);
+    }
+    backOff(attempts);
+  }
+  return true;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicPipeline<ALPHABET_SIZE>::waitToPush(BlockRing& ring,
+					      int block_index)
+{
+  for (int attempts = 0; !ring.push(block_index); attempts++) {
+    if (is_stopping_.load(memory_order_acquire)) {
+      return false;
+    }
+    backOff(attempts);
+  }
+  return true;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicPipeline<ALPHABET_SIZE>::waitForInput()
+{
+  struct pollfd input = {input_fd_, POLLIN, 0};
+  while (!is_stopping_.load(memory_order_acquire)) {
+    int ready = poll(&input, 1, INPUT_POLL_MILLISECONDS);
+    if (ready != 0 && !(ready < 0 && errno == EINTR)) {
+      // Errors are left for the following read to report.
+      return true;
+    }
+  }
+  return false;
+}
+
+template class BasicPipeline<ALPHABET_LENGTH>;
+template class BasicPipeline<BYTE_ALPHABET_LENGTH>;
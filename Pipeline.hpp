@@ -0,0 +1,112 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/* The Pipeline class template codes a stream with three threads: a reader
+   filling blocks from the input file descriptor, an encoder coding the
+   blocks with an Enigma machine and a writer emptying them to the output
+   file descriptor. Reading, coding and writing of different blocks
+   therefore overlap, which hides the latency of slow pipes and network
+   file systems from the encoder.
+   The blocks are allocated once and then circulate between the threads
+   through three BlockRing queues:
+   free_blocks_ carries empty blocks from the writer to the reader,
+   read_blocks_ carries filled blocks from the reader to the encoder and
+   coded_blocks_ carries coded blocks from the encoder to the writer.
+   A stage which finds its input queue empty or its output queue full
+   waits, so a slow stage holds back the others (backpressure) once all
+   the blocks are in use.
+   enigma_ is the machine used to code the stream.
+   input_fd_ and output_fd_ are the file descriptors read and written.
+   blocks_ contains the reusable blocks.
+   is_stopping_ is set when a stage fails, so the other stages give up.
+   error_code_ is an error code corresponding to those in 'errors.h'.
+   invalid_character_ is the input character which caused an
+   INVALID_INPUT_CHARACTER error.
+   For the 26 letter alphabet whitespace in the input is skipped and any
+   other character which is not an upper case letter ends the stream with
+   an error, as when coding without the pipeline. For the 256 symbol
+   alphabet every byte is coded. */
+
+#include "Enigma.hpp"
+#include "BlockRing.hpp"
+#include "constants.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <int ALPHABET_SIZE>
+class BasicPipeline
+{
+public:
+  /* Function to initialise Pipeline object to code from input_fd to
+     output_fd with the given machine, which must already be set up.
+     number_of_blocks blocks of block_size bytes are allocated. */
+  BasicPipeline(BasicEnigma<ALPHABET_SIZE>& enigma,
+		int input_fd, int output_fd,
+		int number_of_blocks = PIPELINE_DEPTH,
+		std::size_t block_size = BLOCK_SIZE);
+
+  /* Function to code the whole input stream, returning once the reader,
+     encoder and writer threads have all finished.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int run();
+
+  /* Function to return the character which caused an
+     INVALID_INPUT_CHARACTER error. */
+  char getInvalidCharacter() const;
+
+private:
+  /* A reusable buffer. length is the number of bytes of data it holds
+     and is_last is set on the final block of the stream. */
+  struct Block
+  {
+    std::vector<char> data;
+    std::size_t length;
+    bool is_last;
+  };
+
+  BasicEnigma<ALPHABET_SIZE>& enigma_;
+  int input_fd_;
+  int output_fd_;
+  std::vector<Block> blocks_;
+  BlockRing free_blocks_;
+  BlockRing read_blocks_;
+  BlockRing coded_blocks_;
+  std::atomic<bool> is_stopping_;
+  int error_code_;
+  char invalid_character_;
+
+  /* Function run by the reader thread. */
+  void readInput();
+
+  /* Function run by the encoder thread. */
+  void codeInput();
+
+  /* Function run by the writer thread. */
+  void writeOutput();
+
+  /* Function to code a block in place. For the 26 letter alphabet the
+     whitespace is removed from the block, which may make it shorter.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int codeBlock(Block& block);
+
+  /* Function to wait until a block index can be taken from ring.
+     Returns false if the pipeline is stopping before one arrives. */
+  bool waitToPop(BlockRing& ring, int& block_index);
+
+  /* Function to wait until block_index can be added to ring.
+     Returns false if the pipeline is stopping before there is room. */
+  bool waitToPush(BlockRing& ring, int block_index);
+
+  /* Function to wait until the input file descriptor has data or is at
+     the end of the file. Returns false if the pipeline is stopping first,
+     so the reader never stays blocked on a silent pipe. */
+  bool waitForInput();
+};
+
+typedef BasicPipeline<ALPHABET_LENGTH> Pipeline;
+typedef BasicPipeline<BYTE_ALPHABET_LENGTH> BytePipeline;
+
+#endif
@@ -1,5 +1,5 @@
 /* This file contains the member function definitions 
-   for the Plugboard class */
+   for the Plugboard class template */
 
 #include "Plugboard.hpp"
 #include "Wiring.hpp"
@@ -8,17 +8,28 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstdio>
+#include <cstdint>
 #include <fstream>
+#include <istream>
 #include <string>
 
 using namespace std;
 
-Plugboard::Plugboard() :
-  wiring_(Wiring()) {}
+template <int ALPHABET_SIZE>
+BasicPlugboard<ALPHABET_SIZE>::BasicPlugboard() :
+  wiring_(BasicWiring<ALPHABET_SIZE>()) {}
 
-int Plugboard::setUp(char const* const input_file_name)
+template <int ALPHABET_SIZE>
+int BasicPlugboard<ALPHABET_SIZE>::setUp(char const* const input_file_name)
 {
   ifstream in(input_file_name);
+  return setUp(in, input_file_name);
+}
+
+template <int ALPHABET_SIZE>
+int BasicPlugboard<ALPHABET_SIZE>::setUp(istream& in,
+					 char const* const input_file_name)
+{
   if (in.fail()) {
     cerr << "Error opening plugboard file " << input_file_name << endl;
     return ERROR_OPENING_CONFIGURATION_FILE;
@@ -26,16 +37,13 @@ int Plugboard::setUp(char const* const input_file_name)
 
   in >> ws;
   if (in.peek() == EOF) {
-    in.close();
     return NO_ERROR;
   } else {
     int size = 0;
-    int connections[ALPHABET_LENGTH / 2][2];
+    int connections[ALPHABET_SIZE / 2][2];
     int plugboard_error = readPlugboardInput(size, connections,
 					     in, input_file_name);
     
-    in.close();
-
     if (plugboard_error != NO_ERROR) {
       return plugboard_error;
     }
@@ -46,22 +54,44 @@ int Plugboard::setUp(char const* const input_file_name)
   return NO_ERROR;
 }
 
-int Plugboard::getPlugboardLetter(int input_letter) const
+template <int ALPHABET_SIZE>
+void BasicPlugboard<ALPHABET_SIZE>::setUp(uint8_t const mapping[ALPHABET_SIZE])
+{
+  wiring_.setUp(mapping);
+}
+
+template <int ALPHABET_SIZE>
+int BasicPlugboard<ALPHABET_SIZE>::getPlugboardLetter(int input_letter) const
 {
   return wiring_.getOutputLetter(input_letter);
 }
 
-int Plugboard::readPlugboardInput(int& size,
-				  int connections[ALPHABET_LENGTH / 2][2],
-				  ifstream& in,
-				  char const* const file_name) const
+template <int ALPHABET_SIZE>
+void BasicPlugboard<ALPHABET_SIZE>::swapPlugPair(int first_letter,
+						 int second_letter)
+{
+  int first_partner = wiring_.getOutputLetter(first_letter);
+  int second_partner = wiring_.getOutputLetter(second_letter);
+  wiring_.setOutputLetter(first_partner, first_partner);
+  wiring_.setOutputLetter(second_partner, second_partner);
+
+  wiring_.setOutputLetter(first_letter, second_letter);
+  wiring_.setOutputLetter(second_letter, first_letter);
+}
+
+template <int ALPHABET_SIZE>
+int BasicPlugboard<ALPHABET_SIZE>::readPlugboardInput(
+    int& size,
+    int connections[ALPHABET_SIZE / 2][2],
+    istream& in,
+    char const* const file_name) const
 {
   string first_number, second_number;
   in >> first_number >> second_number;
   bool in_is_open = true; // Every loop, this bool will be set to true if
                           // the first_number read in successfully.
 
-  for (; in && size < ALPHABET_LENGTH / 2; size++)
+  for (; in && size < ALPHABET_SIZE / 2; size++)
     {
       int numeric_error = checkNumeric(first_number, file_name);
       if (numeric_error != NO_ERROR) {
@@ -111,8 +141,10 @@ int Plugboard::readPlugboardInput(int& size,
   return NO_ERROR;
 }
 
-int Plugboard::checkNumeric(string number_string,
-			    char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicPlugboard<ALPHABET_SIZE>::checkNumeric(
+    string number_string,
+    char const* const file_name) const
 {
   for (int i = 0; number_string[i]; i++) {
     if (number_string[i] < ASCII_ZERO || number_string[i] > ASCII_NINE) {
@@ -123,18 +155,21 @@ int Plugboard::checkNumeric(string number_string,
   return NO_ERROR;
 }
 
-int Plugboard::checkIndex(int letter_index,
-			  char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicPlugboard<ALPHABET_SIZE>::checkIndex(int letter_index,
+					      char const* const file_name) const
 {
-  if (letter_index < A_INDEX || letter_index > Z_INDEX) {
+  if (letter_index < A_INDEX || letter_index > ALPHABET_SIZE - 1) {
     cerr << "Invalid index in plugboard file " << file_name << endl;
     return INVALID_INDEX;
   }
   return NO_ERROR;
 }
 
-int Plugboard::checkRepeat(int const connections[][2], int size,
-			   char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicPlugboard<ALPHABET_SIZE>::checkRepeat(
+    int const connections[][2], int size,
+    char const* const file_name) const
 {
   for (int i = 0; i < size; i++) { // iterates over rows
     for (int j = 0; j < 2; j++) { // iterates over columns of final row
@@ -152,3 +187,6 @@ int Plugboard::checkRepeat(int const connections[][2], int size,
   }
   return NO_ERROR;   
 }
+
+template class BasicPlugboard<ALPHABET_LENGTH>;
+template class BasicPlugboard<BYTE_ALPHABET_LENGTH>;
@@ -1,22 +1,24 @@
 #ifndef PLUGBOARD_H
 #define PLUGBOARD_H
 
-/* The Plugboard class contains a single Wiring object, which
+/* The Plugboard class template contains a single Wiring object, which
    contains the Plugboard mappings. 
    Plugboard letters can map to themselves, or two letters can 
    be paired and map to eachother. */
 
 #include "Wiring.hpp"
 #include "constants.h"
-#include <fstream>
+#include <cstdint>
+#include <istream>
 #include <string>
 
-class Plugboard
+template <int ALPHABET_SIZE>
+class BasicPlugboard
 {
  public:
   /* Function to initialise Plugboard object to have
      all letters mapping to themselves. */
-  Plugboard();
+  BasicPlugboard();
 
   /* Function to set up Plugboard object with mappings given
      in the configuration file. 
@@ -27,25 +29,44 @@ class Plugboard
      'errors.h' file. */
   int setUp(char const* const input_file_name);
 
+  /* Function to set up the object like setUp above, reading the
+     configuration from the input stream in instead of a named file, so
+     it can also come from memory.
+     input_file_name is the name used for the configuration in error
+     messages. */
+  int setUp(std::istream& in, char const* const input_file_name);
+
+  /* Function to set up the object from a mapping which has already been
+     checked, such as one from the built-in catalog, without reading any
+     file. mapping holds the output letter index of every letter. */
+  void setUp(std::uint8_t const mapping[ALPHABET_SIZE]);
+
   /* Function to return the output letter index that the input letter
      index maps to. */
   int getPlugboardLetter(int input_letter) const;
+
+  /* Function to plug a cable between the letters with indices
+     first_letter and second_letter, first unplugging any cables already
+     plugged into either of them. If the two indices are the same, the
+     letter is just unplugged. Both indices must be between 0 and
+     ALPHABET_SIZE - 1. */
+  void swapPlugPair(int first_letter, int second_letter);
   
  private:
-  Wiring wiring_;
+  BasicWiring<ALPHABET_SIZE> wiring_;
 
     /* Function to check and extract plugbaord input from configuration file. 
      size is an integer which counts the number of pairs of mappings in the 
      configuration file. It must be set to zero before the function is called.
-     connections is an empty 13x2 array which is filled up with 
-     the mappings given in the configuration file.
+     connections is an empty (ALPHABET_SIZE / 2)x2 array which is filled
+     up with the mappings given in the configuration file.
      in is the input file stream connected to the configuration file. 
      file_name is a pointer to a c-string containing the name of the
      configuration file. 
      The function returns an error code corresponding to those in 'errors.h' */
   int readPlugboardInput(int& size,
-			 int connections[ALPHABET_LENGTH / 2][2],
-			 std::ifstream& in,
+			 int connections[ALPHABET_SIZE / 2][2],
+			 std::istream& in,
 			 char const* const file_name) const;
 
   /* Function to check if plugboard input is a numeric character.
@@ -57,7 +78,7 @@ class Plugboard
 		   char const* const file_name) const;
 
   /* Function to check if plugboard input is a valid index between 
-     0 and 25.
+     0 and ALPHABET_SIZE - 1.
      letter_index is the number to be checked.
      file_name is a pointer to a c-string containing the name of the
      configuration file. 
@@ -76,4 +97,7 @@ class Plugboard
 		  char const* const file_name) const;
 };
 
+typedef BasicPlugboard<ALPHABET_LENGTH> Plugboard;
+typedef BasicPlugboard<BYTE_ALPHABET_LENGTH> BytePlugboard;
+
 #endif
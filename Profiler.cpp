@@ -0,0 +1,273 @@
+/* This file contains the member function definitions
+   for the Profiler class */
+
+#include "Profiler.hpp"
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_X86_COUNTERS 1
+#endif
+
+using namespace std;
+
+namespace {
+  /* Largest number of counters opened in the group. */
+  const int MAX_GROUP_COUNTERS = 8;
+
+  /* Function to read a hardware counter directly from user space. */
+#ifdef HAS_X86_COUNTERS
+  inline uint64_t rdpmc(uint32_t counter)
+  {
+    uint32_t low, high;
+    __asm__ __volatile__("rdpmc" : "=a"(low), "=d"(high) : "c"(counter));
+    return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+  }
+#endif
+
+  /* Function to read a counter through its mapped user page, which only
+     works while the kernel has the counter scheduled on a hardware
+     register. Returns false if the counter cannot be read this way. */
+  bool readUserPage(void* page, uint64_t& count)
+  {
+#ifdef HAS_X86_COUNTERS
+    if (page == nullptr) {
+      return false;
+    }
+
+    auto volatile* info = static_cast<perf_event_mmap_page volatile*>(page);
+    uint32_t sequence;
+    do {
+      sequence = info->lock;
+      __asm__ __volatile__("" ::: "memory");
+      uint32_t index = info->index;
+      if (!info->cap_user_rdpmc || index == 0) {
+	return false;
+      }
+      int64_t value = rdpmc(index - 1);
+      int width = info->pmc_width;
+      value <<= 64 - width;
+      value >>= 64 - width;
+      count = info->offset + value;
+      __asm__ __volatile__("" ::: "memory");
+    } while (info->lock != sequence);
+    return true;
+#else
+    (void) page;
+    (void) count;
+    return false;
+#endif
+  }
+}
+
+Profiler::Profiler() :
+  calls_(),
+  nanoseconds_(),
+  phase_start_nanoseconds_(0)
+{
+  openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles");
+  if (!counter_fds_.empty()) {
+    openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,
+		"instructions");
+    openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,
+		"branch-misses");
+    openCounter(PERF_TYPE_HW_CACHE,
+		PERF_COUNT_HW_CACHE_L1D
+		| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+		| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		"L1D-read-misses");
+    openCounter(PERF_TYPE_HW_CACHE,
+		PERF_COUNT_HW_CACHE_LL
+		| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+		| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		"LLC-read-misses");
+    source_ = "perf_event";
+  } else {
+#ifdef HAS_X86_COUNTERS
+    counter_names_.push_back("tsc-ticks");
+    source_ = "rdtsc";
+#else
+    source_ = "clock_gettime";
+#endif
+  }
+
+  for (int i = 0; i < NUMBER_OF_PROFILE_PHASES; i++) {
+    counts_[i].assign(counter_names_.size(), 0);
+  }
+  phase_start_counts_.assign(counter_names_.size(), 0);
+  phase_end_counts_.assign(counter_names_.size(), 0);
+}
+
+Profiler::~Profiler()
+{
+  long page_size = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < counter_fds_.size(); i++) {
+    if (counter_pages_[i] != nullptr) {
+      munmap(counter_pages_[i], page_size);
+    }
+    close(counter_fds_[i]);
+  }
+}
+
+void Profiler::begin(int phase)
+{
+  readCounters(phase_start_counts_);
+  phase_start_nanoseconds_ = readNanoseconds();
+  (void) phase;
+}
+
+void Profiler::end(int phase)
+{
+  uint64_t end_nanoseconds = readNanoseconds();
+  readCounters(phase_end_counts_);
+  vector<uint64_t>& totals = counts_[phase];
+  for (size_t i = 0; i < totals.size(); i++) {
+    totals[i] += phase_end_counts_[i] - phase_start_counts_[i];
+  }
+  nanoseconds_[phase] += end_nanoseconds - phase_start_nanoseconds_;
+  calls_[phase]++;
+}
+
+string Profiler::getSource() const
+{
+  return source_;
+}
+
+void Profiler::printTable(ostream& out) const
+{
+  out << "Profile (" << source_ << ")" << endl;
+  out << left << setw(20) << "phase" << right << setw(12) << "calls";
+  out << setw(14) << "ns";
+  for (size_t i = 0; i < counter_names_.size(); i++) {
+    out << setw(17) << counter_names_[i];
+  }
+  bool has_ipc = (counter_names_.size() >= 2 && source_ == "perf_event");
+  if (has_ipc) {
+    out << setw(7) << "IPC";
+  }
+  out << endl;
+
+  for (int phase = 0; phase < NUMBER_OF_PROFILE_PHASES; phase++) {
+    if (calls_[phase] == 0) {
+      continue;
+    }
+    out << left << setw(20) << getPhaseName(phase) << right;
+    out << setw(12) << calls_[phase] << setw(14) << nanoseconds_[phase];
+    for (size_t i = 0; i < counts_[phase].size(); i++) {
+      out << setw(17) << counts_[phase][i];
+    }
+    if (has_ipc) {
+      double cycles = counts_[phase][0];
+      double instructions = counts_[phase][1];
+      out << setw(7) << fixed << setprecision(2);
+      out << ((cycles > 0) ? instructions / cycles : 0.0);
+      out.unsetf(ios::floatfield);
+    }
+    out << endl;
+  }
+}
+
+void Profiler::printJson(ostream& out) const
+{
+  out << "{\"source\": \"" << source_ << "\", \"phases\": [";
+  bool is_first = true;
+  for (int phase = 0; phase < NUMBER_OF_PROFILE_PHASES; phase++) {
+    if (calls_[phase] == 0) {
+      continue;
+    }
+    out << ((is_first) ? "" : ", ");
+    out << "{\"name\": \"" << getPhaseName(phase) << "\"";
+    out << ", \"calls\": " << calls_[phase];
+    out << ", \"nanoseconds\": " << nanoseconds_[phase];
+    out << ", \"counters\": {";
+    for (size_t i = 0; i < counts_[phase].size(); i++) {
+      out << ((i == 0) ? "" : ", ");
+      out << "\"" << counter_names_[i] << "\": " << counts_[phase][i];
+    }
+    out << "}}";
+    is_first = false;
+  }
+  out << "]}" << endl;
+}
+
+void Profiler::openCounter(uint32_t type, uint64_t config, char const* name)
+{
+  perf_event_attr attributes;
+  memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.type = type;
+  attributes.config = config;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_GROUP;
+
+  int group_fd = (counter_fds_.empty()) ? -1 : counter_fds_[0];
+  int fd = syscall(SYS_perf_event_open, &attributes, 0, -1, group_fd, 0);
+  if (fd < 0) {
+    return;
+  }
+
+  void* page = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED,
+		    fd, 0);
+  counter_fds_.push_back(fd);
+  counter_pages_.push_back((page == MAP_FAILED) ? nullptr : page);
+  counter_names_.push_back(name);
+}
+
+void Profiler::readCounters(vector<uint64_t>& counts) const
+{
+  if (counter_fds_.empty()) {
+#ifdef HAS_X86_COUNTERS
+    counts[0] = __rdtsc();
+#endif
+    return;
+  }
+
+  bool is_read = true;
+  for (size_t i = 0; i < counts.size() && is_read; i++) {
+    is_read = readUserPage(counter_pages_[i], counts[i]);
+  }
+  if (is_read) {
+    return;
+  }
+
+  // The group leader reads every counter of the group at once, in the
+  // order they were opened.
+  uint64_t values[1 + MAX_GROUP_COUNTERS] = {};
+  if (read(counter_fds_[0], values, sizeof(values)) <= 0) {
+    values[0] = 0;
+  }
+  for (size_t i = 0; i < counts.size(); i++) {
+    counts[i] = (i < values[0]) ? values[1 + i] : 0;
+  }
+}
+
+uint64_t Profiler::readNanoseconds()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+char const* Profiler::getPhaseName(int phase)
+{
+  char const* const names[NUMBER_OF_PROFILE_PHASES] = {
+    "plugboard-parsing",
+    "reflector-parsing",
+    "rotor-parsing",
+    "rotor-positioning",
+    "stepping",
+    "signal-path",
+    "input-output"
+  };
+  return names[phase];
+}
@@ -0,0 +1,98 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/* The Profiler class records hardware performance counters separately
+   for each phase of running an Enigma machine, so it can be seen whether
+   a workload is bound by branches, memory or input and output.
+   The counters are opened as one group with the Linux perf_event_open
+   system call and only count user space events of the calling thread.
+   Where the kernel allows it the counters are read with the rdpmc
+   instruction, which is cheap enough to wrap every keystroke; otherwise
+   they are read with the read system call. When no counters can be
+   opened the profiler falls back to counting time stamp counter ticks
+   with rdtsc, or only wall clock time on processors without one.
+   counter_fds_ contains the file descriptors of the opened counters and
+   counter_pages_ the user page mapped for each of them (nullptr if it
+   could not be mapped).
+   counter_names_ contains the name of each opened counter.
+   source_ names where the counts come from: "perf_event", "rdtsc" or
+   "clock_gettime".
+   calls_, nanoseconds_ and counts_ contain the totals of each phase.
+   phase_start_nanoseconds_ and phase_start_counts_ contain the readings
+   taken when each phase was last begun, and phase_end_counts_ the
+   readings taken when it was last ended. */
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Phases of running a machine, in the order they are reported. */
+#define PROFILE_PLUGBOARD_PARSING  0
+#define PROFILE_REFLECTOR_PARSING  1
+#define PROFILE_ROTOR_PARSING      2
+#define PROFILE_ROTOR_POSITIONING  3
+#define PROFILE_STEPPING           4
+#define PROFILE_SIGNAL_PATH        5
+#define PROFILE_INPUT_OUTPUT       6
+#define NUMBER_OF_PROFILE_PHASES   7
+
+class Profiler
+{
+public:
+  /* Function to initialise Profiler object, opening the performance
+     counters or choosing a fallback if they are unavailable. */
+  Profiler();
+
+  /* Destructor, which closes the performance counters. */
+  ~Profiler();
+
+  Profiler(Profiler const&) = delete;
+  Profiler& operator=(Profiler const&) = delete;
+
+  /* Function to start counting for a phase. Phases must not overlap. */
+  void begin(int phase);
+
+  /* Function to stop counting for a phase and add the counts since the
+     matching call to begin to the totals of the phase. */
+  void end(int phase);
+
+  /* Function to return where the counts come from: "perf_event",
+     "rdtsc" or "clock_gettime". */
+  std::string getSource() const;
+
+  /* Function to write the totals as a table with one row per phase. */
+  void printTable(std::ostream& out) const;
+
+  /* Function to write the totals as a JSON object. */
+  void printJson(std::ostream& out) const;
+
+private:
+  std::vector<int> counter_fds_;
+  std::vector<void*> counter_pages_;
+  std::vector<std::string> counter_names_;
+  std::string source_;
+  std::uint64_t calls_[NUMBER_OF_PROFILE_PHASES];
+  std::uint64_t nanoseconds_[NUMBER_OF_PROFILE_PHASES];
+  std::vector<std::uint64_t> counts_[NUMBER_OF_PROFILE_PHASES];
+  std::uint64_t phase_start_nanoseconds_;
+  std::vector<std::uint64_t> phase_start_counts_;
+  std::vector<std::uint64_t> phase_end_counts_;
+
+  /* Function to open one counter as part of the group led by the first
+     counter opened. Counters the processor does not support are
+     skipped. */
+  void openCounter(std::uint32_t type, std::uint64_t config,
+		   char const* name);
+
+  /* Function to fill counts with the current value of every counter. */
+  void readCounters(std::vector<std::uint64_t>& counts) const;
+
+  /* Function to return the current wall clock time in nanoseconds. */
+  static std::uint64_t readNanoseconds();
+
+  /* Function to return the name of the phase. */
+  static char const* getPhaseName(int phase);
+};
+
+#endif
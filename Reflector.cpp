@@ -1,5 +1,5 @@
 /* This file contains the member function definitions 
-   for the Reflector class */
+   for the Reflector class template */
 
 #include "Reflector.hpp"
 #include "Wiring.hpp"
@@ -8,17 +8,28 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstdio>
+#include <cstdint>
 #include <fstream>
+#include <istream>
 #include <string>
 
 using namespace std;
 
-Reflector::Reflector() :
-  wiring_(Wiring()) {}
+template <int ALPHABET_SIZE>
+BasicReflector<ALPHABET_SIZE>::BasicReflector() :
+  wiring_(BasicWiring<ALPHABET_SIZE>()) {}
 
-int Reflector::setUp(char const* const input_file_name)
+template <int ALPHABET_SIZE>
+int BasicReflector<ALPHABET_SIZE>::setUp(char const* const input_file_name)
 {
   ifstream in(input_file_name);
+  return setUp(in, input_file_name);
+}
+
+template <int ALPHABET_SIZE>
+int BasicReflector<ALPHABET_SIZE>::setUp(istream& in,
+					 char const* const input_file_name)
+{
   if (in.fail()) {
     cerr << "Error opening reflector file " << input_file_name << endl;
     return ERROR_OPENING_CONFIGURATION_FILE;
@@ -28,33 +39,46 @@ int Reflector::setUp(char const* const input_file_name)
   if (in.peek() == EOF) {
     cerr << "Reflector parameter file " << input_file_name;
     cerr << " is empty." << endl;
-    in.close();
     return INCORRECT_NUMBER_OF_REFLECTOR_PARAMETERS;
   } else {
-    int connections[ALPHABET_LENGTH / 2][2];
+    int connections[ALPHABET_SIZE / 2][2];
     int reflector_error = readReflectorInput(connections, in,
 					      input_file_name);
 
-    in.close();
-    
     if (reflector_error != NO_ERROR) {
       return reflector_error;
     }
     
-    wiring_.setUp(connections, ALPHABET_LENGTH / 2);
+    wiring_.setUp(connections, ALPHABET_SIZE / 2);
   }
   
   return NO_ERROR;
 }
 
-int Reflector::getReflectorLetter(int input_letter) const
+template <int ALPHABET_SIZE>
+void BasicReflector<ALPHABET_SIZE>::setUp(uint8_t const mapping[ALPHABET_SIZE])
+{
+  wiring_.setUp(mapping);
+}
+
+template <int ALPHABET_SIZE>
+int BasicReflector<ALPHABET_SIZE>::getReflectorLetter(int input_letter) const
 {
   return wiring_.getOutputLetter(input_letter);
 }
 
-int Reflector::readReflectorInput(int connections[ALPHABET_LENGTH / 2][2],
-				  ifstream& in,
-				  char const* const file_name) const
+template <int ALPHABET_SIZE>
+BasicWiring<ALPHABET_SIZE> const& BasicReflector<ALPHABET_SIZE>::getWiring()
+  const
+{
+  return wiring_;
+}
+
+template <int ALPHABET_SIZE>
+int BasicReflector<ALPHABET_SIZE>::readReflectorInput(
+    int connections[ALPHABET_SIZE / 2][2],
+    istream& in,
+    char const* const file_name) const
 {
   string first_number, second_number;
   in >> first_number >> second_number;
@@ -62,7 +86,7 @@ int Reflector::readReflectorInput(int connections[ALPHABET_LENGTH / 2][2],
                           // the first_number read in successfully.
   
   int i = 0;
-  for (; i < ALPHABET_LENGTH / 2 && in; i++)
+  for (; i < ALPHABET_SIZE / 2 && in; i++)
     {
       int numeric_error = checkNumeric(first_number, file_name);
       if (numeric_error != NO_ERROR) {
@@ -100,8 +124,8 @@ int Reflector::readReflectorInput(int connections[ALPHABET_LENGTH / 2][2],
       in >> second_number;
     }
 
-  if (!(i == ALPHABET_LENGTH / 2 && !in_is_open)) { 
-    if (i == ALPHABET_LENGTH / 2) {
+  if (!(i == ALPHABET_SIZE / 2 && !in_is_open)) { 
+    if (i == ALPHABET_SIZE / 2) {
       cerr << "Too many parameters in reflector file " << file_name << endl;
     } else {
       if (in_is_open) {
@@ -118,8 +142,10 @@ int Reflector::readReflectorInput(int connections[ALPHABET_LENGTH / 2][2],
   return NO_ERROR;
 }
 
-int Reflector::checkNumeric(string number_string,
-			    char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicReflector<ALPHABET_SIZE>::checkNumeric(
+    string number_string,
+    char const* const file_name) const
 {
   for (int i = 0; number_string[i]; i++) {
     if (number_string[i] < ASCII_ZERO || number_string[i] > ASCII_NINE) {
@@ -130,18 +156,21 @@ int Reflector::checkNumeric(string number_string,
   return NO_ERROR;
 }
 
-int Reflector::checkIndex(int letter_index,
-			  char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicReflector<ALPHABET_SIZE>::checkIndex(int letter_index,
+					      char const* const file_name) const
 {
-  if (letter_index < A_INDEX || letter_index > Z_INDEX) {
+  if (letter_index < A_INDEX || letter_index > ALPHABET_SIZE - 1) {
     cerr << "Invalid index in reflector file " << file_name << endl;
     return INVALID_INDEX;
   }
   return NO_ERROR;
 }
 
-int Reflector::checkRepeat(int const connections[][2], int size,
-			   char const* const file_name) const
+template <int ALPHABET_SIZE>
+int BasicReflector<ALPHABET_SIZE>::checkRepeat(
+    int const connections[][2], int size,
+    char const* const file_name) const
 {
   for (int i = 0; i < size; i++) { // Iterate over rows
     for (int j = 0; j < 2; j++) { // Iterate over columns in final row
@@ -159,3 +188,6 @@ int Reflector::checkRepeat(int const connections[][2], int size,
   }
   return NO_ERROR;
 }
+
+template class BasicReflector<ALPHABET_LENGTH>;
+template class BasicReflector<BYTE_ALPHABET_LENGTH>;
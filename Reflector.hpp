@@ -1,23 +1,26 @@
 #ifndef REFLECTOR_H
 #define REFLECTOR_H
 
-/* The Reflector class contains a single Wiring object, which
+/* The Reflector class template contains a single Wiring object, which
    contains the Reflector mappings. 
-   The reflector mapping consists of 13 pairs of letters, where the
-   letters in the pair map to eachother. 
+   The reflector mapping consists of ALPHABET_SIZE / 2 pairs of letters
+   (13 for the 26 letter alphabet), where the letters in the pair map to
+   eachother. 
    Letters cannot map to themselves. */
 
 #include "Wiring.hpp"
 #include "constants.h"
-#include <fstream>
+#include <cstdint>
+#include <istream>
 #include <string>
 
-class Reflector
+template <int ALPHABET_SIZE>
+class BasicReflector
 {
 public:
   /* Function to initialise Reflector object to have all letters mapping
    to themselves. */
-  Reflector();
+  BasicReflector();
   
   /* Function to set up Reflector object so that all letters are paired.
      The pairs are read from the configuration file. 
@@ -28,22 +31,37 @@ public:
      'errors.h' file. */
   int setUp(char const* const input_file_name);
 
+  /* Function to set up the object like setUp above, reading the
+     configuration from the input stream in instead of a named file, so
+     it can also come from memory.
+     input_file_name is the name used for the configuration in error
+     messages. */
+  int setUp(std::istream& in, char const* const input_file_name);
+
+  /* Function to set up the object from a mapping which has already been
+     checked, such as one from the built-in catalog, without reading any
+     file. mapping holds the output letter index of every letter. */
+  void setUp(std::uint8_t const mapping[ALPHABET_SIZE]);
+
   /* Function to return the output letter index that the input 
      letter index maps to. */
   int getReflectorLetter(int input_letter) const;
+
+  /* Function to return the whole reflector mapping. */
+  BasicWiring<ALPHABET_SIZE> const& getWiring() const;
   
 private:
-  Wiring wiring_;
+  BasicWiring<ALPHABET_SIZE> wiring_;
 
   /* Function to check and extract reflector input from configuration file.
-     connections is an empty 13x2 array which is filled up with 
-     the mappings given in the configuration file. 
+     connections is an empty (ALPHABET_SIZE / 2)x2 array which is filled
+     up with the mappings given in the configuration file. 
      in is the input file stream connected to the configuration file. 
      file_name is a pointer to a c-string containing the name of the
      configuration file. 
      The function returns an error code corresponding to those in 'errors.h' */
-  int readReflectorInput(int connections[ALPHABET_LENGTH / 2][2],
-			 std::ifstream& in,
+  int readReflectorInput(int connections[ALPHABET_SIZE / 2][2],
+			 std::istream& in,
 			  char const* const file_name) const;
 
   /* Function to check if reflector input is a numeric character.
@@ -55,7 +73,7 @@ private:
 		   char const* const file_name) const;
 
   /* Function to check if reflector input is a valid index between 
-     0 and 25.
+     0 and ALPHABET_SIZE - 1.
      letter_index is the number to be checked.
      file_name is a pointer to a c-string containing the name of the
      configuration file. 
@@ -75,4 +93,7 @@ private:
   
 };
 
+typedef BasicReflector<ALPHABET_LENGTH> Reflector;
+typedef BasicReflector<BYTE_ALPHABET_LENGTH> ByteReflector;
+
 #endif
@@ -1,5 +1,5 @@
 /* This file contains the member function definitions 
-   for the Rotor class */
+   for the Rotor class template */
 
 #include "Rotor.hpp"
 #include "Wiring.hpp"
@@ -8,26 +8,32 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstdio>
+#include <cstdint>
 #include <fstream>
+#include <istream>
 #include <string>
 
 using namespace std;
 
-Rotor::Rotor() :
-  forward_wiring_(Wiring()),
-  backward_wiring_(Wiring()),
-  letter_tracker_(Wiring()),
-  notch_array_(nullptr),
-  number_of_notches_(0) {}
+template <int ALPHABET_SIZE>
+BasicRotor<ALPHABET_SIZE>::BasicRotor() :
+  forward_wiring_(BasicWiring<ALPHABET_SIZE>()),
+  backward_wiring_(BasicWiring<ALPHABET_SIZE>()),
+  position_(0),
+  ring_setting_(0),
+  notch_mask_() {}
 
-Rotor::~Rotor()
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::setUp(char const* const input_file_name)
 {
-  delete [] notch_array_;
+  ifstream in(input_file_name);
+  return setUp(in, input_file_name);
 }
 
-int Rotor::setUp(char const* const input_file_name)
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::setUp(istream& in,
+				     char const* const input_file_name)
 {
-  ifstream in(input_file_name);
   if (in.fail()) {
     cerr << "Error opening rotor file " << input_file_name << endl;
     return ERROR_OPENING_CONFIGURATION_FILE;
@@ -36,102 +42,172 @@ int Rotor::setUp(char const* const input_file_name)
   in >> ws;
   if (in.peek() == EOF) {
     cerr << "Rotor mapping file " << input_file_name << " is empty." << endl;
-    in.close();
     return INVALID_ROTOR_MAPPING;
   } else {
-    int forward_connections[ALPHABET_LENGTH];
-    int backward_connections[ALPHABET_LENGTH];
-    int dummy_notch_array[ALPHABET_LENGTH];
+    int forward_connections[ALPHABET_SIZE];
+    int dummy_notch_array[ALPHABET_SIZE];
+    int number_of_notches = 0;
     int rotor_error = readRotorInput(forward_connections, dummy_notch_array,
-				     in, input_file_name);
+				     number_of_notches, in, input_file_name);
 
-    in.close();
-    
     if (rotor_error != NO_ERROR) {
       return rotor_error;
     }
     
     forward_wiring_.setUp(forward_connections);
-    convertForwardToBackward(forward_connections, backward_connections);
-    backward_wiring_.setUp(backward_connections);
+    backward_wiring_.setInverse(forward_wiring_);
+    ring_setting_ = 0;
 
-    notch_array_ = new int[number_of_notches_];
-    for (int i = 0; i < number_of_notches_; i++) {
-      notch_array_[i] = dummy_notch_array[i];
+    for (int i = 0; i < number_of_notches; i++) {
+      int notch = dummy_notch_array[i];
+      notch_mask_[notch / 64] |= static_cast<uint64_t>(1) << (notch % 64);
     }
 
   }
   return NO_ERROR;
 }
 
-int Rotor::getForwardRotorLetter(int input_letter) const
+template <int ALPHABET_SIZE>
+void BasicRotor<ALPHABET_SIZE>::setUp(uint8_t const forward[ALPHABET_SIZE],
+				      uint8_t const backward[ALPHABET_SIZE],
+				      uint64_t const* notch_mask)
 {
-  return forward_wiring_.getOutputLetter(input_letter);
+  forward_wiring_.setUp(forward);
+  backward_wiring_.setUp(backward);
+  ring_setting_ = 0;
+  for (int i = 0; i < NOTCH_MASK_WORDS; i++) {
+    notch_mask_[i] = notch_mask[i];
+  }
 }
 
-int Rotor::getBackwardRotorLetter(int input_letter) const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getForwardRotorLetter(int input_letter) const
 {
-  return backward_wiring_.getOutputLetter(input_letter);
+  return getForwardRotorLetter(input_letter, position_);
 }
 
-int Rotor::getTopLetter() const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getBackwardRotorLetter(int input_letter) const
 {
- return letter_tracker_.getOutputLetter(0);
+  return getBackwardRotorLetter(input_letter, position_);
 }
 
-int Rotor::getNumberOfNotches() const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getForwardRotorLetter(int input_letter,
+						     int position) const
 {
-  return number_of_notches_;
+  int output_letter =
+    forward_wiring_.getOutputLetter(wrap(input_letter + position));
+  return wrap(output_letter - position + ALPHABET_SIZE);
 }
 
-int Rotor::getNotch(int index) const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getBackwardRotorLetter(int input_letter,
+						      int position) const
 {
-  return notch_array_[index];
+  int output_letter =
+    backward_wiring_.getOutputLetter(wrap(input_letter + position));
+  return wrap(output_letter - position + ALPHABET_SIZE);
 }
 
-void Rotor::rotateUp()
+template <int ALPHABET_SIZE>
+void BasicRotor<ALPHABET_SIZE>::getForwardWiring(
+    BasicWiring<ALPHABET_SIZE>& wiring) const
 {
-  // Store the first mappings to be moved to the end of the arrays.
-  // The values are also decreased by 1 (except 0 which is set to 25)
-  int first_forward_temp = (forward_wiring_.getOutputLetter(A_INDEX)
-			    - 1 + ALPHABET_LENGTH) % ALPHABET_LENGTH;
-  int first_backward_temp = (backward_wiring_.getOutputLetter(A_INDEX)
-			     - 1 + ALPHABET_LENGTH) % ALPHABET_LENGTH;
-  int first_letter_temp = letter_tracker_.getOutputLetter(A_INDEX);
+  wiring.setShifted(forward_wiring_, position_);
+}
 
-  // Move every mapping up one and decrease the value it maps to by 1
-  for (int i = 0; i < ALPHABET_LENGTH - 1; i++) {
-    int forward_temp = (forward_wiring_.getOutputLetter(i + 1)
-			- 1 + ALPHABET_LENGTH) % ALPHABET_LENGTH;
-    int backward_temp = (backward_wiring_.getOutputLetter(i + 1)
-			 - 1 + ALPHABET_LENGTH) % ALPHABET_LENGTH;
-    int letter_temp = letter_tracker_.getOutputLetter(i + 1);
-    forward_wiring_.setOutputLetter(i, forward_temp);
-    backward_wiring_.setOutputLetter(i, backward_temp);
-    letter_tracker_.setOutputLetter(i, letter_temp);
-  }
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getTopLetter() const
+{
+  return position_;
+}
 
-  forward_wiring_.setOutputLetter(Z_INDEX, first_forward_temp);
-  backward_wiring_.setOutputLetter(Z_INDEX, first_backward_temp);
-  letter_tracker_.setOutputLetter(Z_INDEX, first_letter_temp);
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getNumberOfNotches() const
+{
+  int number_of_notches = 0;
+  for (int i = 0; i < NOTCH_MASK_WORDS; i++) {
+    number_of_notches += __builtin_popcountll(notch_mask_[i]);
+  }
+  return number_of_notches;
 }
 
-void Rotor::rotate(int amount_to_rotate_by)
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getNotch(int index) const
 {
-  for (int i = 0; i < amount_to_rotate_by; i++) {
-    rotateUp();
+  for (int notch = 0; notch < ALPHABET_SIZE; notch++) {
+    if ((notch_mask_[notch / 64] >> (notch % 64)) & 1) {
+      if (index == 0) {
+	return notch;
+      }
+      index--;
+    }
   }
+  return ALPHABET_SIZE;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicRotor<ALPHABET_SIZE>::isAtNotch() const
+{
+  return isNotch(position_);
+}
+
+template <int ALPHABET_SIZE>
+bool BasicRotor<ALPHABET_SIZE>::isNotch(int position) const
+{
+  return (notch_mask_[position / 64] >> (position % 64)) & 1;
 }
 
-int Rotor::readRotorInput(int connections[ALPHABET_LENGTH],
-			  int dummy_notch_array[ALPHABET_LENGTH],
-			  ifstream& in, char const* const file_name)
+template <int ALPHABET_SIZE>
+void BasicRotor<ALPHABET_SIZE>::rotateUp()
+{
+  position_ = static_cast<uint8_t>(wrap(position_ + 1));
+}
+
+template <int ALPHABET_SIZE>
+void BasicRotor<ALPHABET_SIZE>::rotate(int amount_to_rotate_by)
+{
+  position_ = static_cast<uint8_t>((position_ + amount_to_rotate_by)
+				   % ALPHABET_SIZE);
+}
+
+template <int ALPHABET_SIZE>
+bool BasicRotor<ALPHABET_SIZE>::isBeforeNotch() const
+{
+  return isNotch(wrap(position_ + 1));
+}
+
+template <int ALPHABET_SIZE>
+void BasicRotor<ALPHABET_SIZE>::setRingSetting(int ring_setting)
+{
+  // Turning the core by offset moves the contact at letter x to
+  // x + offset and adds offset to the letter it is wired to, which is the
+  // same for both directions: the wiring turned back by offset.
+  int offset = ring_setting - ring_setting_;
+  forward_wiring_.setShifted(forward_wiring_, -offset);
+  backward_wiring_.setShifted(backward_wiring_, -offset);
+  ring_setting_ = static_cast<uint8_t>(ring_setting);
+}
+
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::getRingSetting() const
+{
+  return ring_setting_;
+}
+
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::readRotorInput(
+    int connections[ALPHABET_SIZE],
+    int dummy_notch_array[ALPHABET_SIZE],
+    int& number_of_notches,
+    istream& in, char const* const file_name)
 {
   string number;
   in >> number;
 
   int i = 0;
-  for (; i < ALPHABET_LENGTH && in; i++)
+  for (; i < ALPHABET_SIZE && in; i++)
     {
       int numeric_error = checkNumeric(number, file_name);
       if (numeric_error != NO_ERROR) {
@@ -149,7 +225,7 @@ int Rotor::readRotorInput(int connections[ALPHABET_LENGTH],
       in >> number;
     }
 
-  if (i < ALPHABET_LENGTH) {
+  if (i < ALPHABET_SIZE) {
     cerr << "Not all inputs mapped in rotor file " << file_name << endl;
     return INVALID_ROTOR_MAPPING;
   }
@@ -159,7 +235,7 @@ int Rotor::readRotorInput(int connections[ALPHABET_LENGTH],
   }
 
   i = 0;
-  for (; i < ALPHABET_LENGTH && in; i++)
+  for (; i < ALPHABET_SIZE && in; i++)
     {
       int numeric_error = checkNumeric(number, file_name, true);
       if (numeric_error != NO_ERROR) {
@@ -177,20 +253,21 @@ int Rotor::readRotorInput(int connections[ALPHABET_LENGTH],
       in >> number;
     }
 
-  if (i == ALPHABET_LENGTH && in) {
+  if (i == ALPHABET_SIZE && in) {
     cerr << "Too many rotor notches provided in rotor file ";
     cerr << file_name << endl;
     return INVALID_ROTOR_MAPPING;
   }
 
-  number_of_notches_ = i;
+  number_of_notches = i;
       
   return NO_ERROR;
 }
 
-int Rotor::checkNumeric(string number_string,
-			char const* const file_name,
-			bool is_notch) const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::checkNumeric(string number_string,
+					    char const* const file_name,
+					    bool is_notch) const
 {
   for (int i = 0; number_string[i]; i++) {
     if (number_string[i] < ASCII_ZERO || number_string[i] > ASCII_NINE) {
@@ -203,10 +280,12 @@ int Rotor::checkNumeric(string number_string,
   return NO_ERROR;
 }
 
-int Rotor::checkIndex(int letter_index, char const* const file_name,
-		      bool is_notch) const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::checkIndex(int letter_index,
+					  char const* const file_name,
+					  bool is_notch) const
 {
-  if (letter_index < A_INDEX || letter_index > Z_INDEX) {
+  if (letter_index < A_INDEX || letter_index > ALPHABET_SIZE - 1) {
     string component = (is_notch) ? "notch" : "mapping";
     cerr << "Invalid index for " << component << " in rotor file ";
     cerr << file_name << endl;
@@ -215,8 +294,10 @@ int Rotor::checkIndex(int letter_index, char const* const file_name,
   return NO_ERROR;
 }
 
-int Rotor::checkRepeat(int const connections[], int size,
-		       char const* const file_name, bool is_notch) const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::checkRepeat(int const connections[], int size,
+					   char const* const file_name,
+					   bool is_notch) const
 {
   for (int i = 0; i < size; i++) {
     if (connections[size] == connections[i]) {
@@ -235,12 +316,15 @@ int Rotor::checkRepeat(int const connections[], int size,
   return NO_ERROR;
 }
 
-void Rotor::convertForwardToBackward(
-    int const forward_connections[ALPHABET_LENGTH],
-    int backward_connections[ALPHABET_LENGTH]) const
+template <int ALPHABET_SIZE>
+int BasicRotor<ALPHABET_SIZE>::wrap(int letter_index)
 {
-  for (int i = 0; i < ALPHABET_LENGTH; i++) {
-    int input_index = forward_connections[i];
-    backward_connections[input_index] = i;
-  }
+  return (letter_index >= ALPHABET_SIZE) ? letter_index - ALPHABET_SIZE
+					 : letter_index;
 }
+
+static_assert(sizeof(BasicRotor<ALPHABET_LENGTH>) == CACHE_LINE_SIZE,
+	      "a 26 letter rotor should fill exactly one cache line");
+
+template class BasicRotor<ALPHABET_LENGTH>;
+template class BasicRotor<BYTE_ALPHABET_LENGTH>;
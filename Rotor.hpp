@@ -1,33 +1,39 @@
 #ifndef ROTOR_H
 #define ROTOR_H
 
-/* The Rotor class contains three Wiring objects, a pointer and an integer.
+/* The Rotor class template contains two Wiring objects, a byte and a
+   notch bitmask, all stored inline so that a 26 letter rotor fills exactly
+   one cache line and an array of rotors is one contiguous block.
    forward_wiring_ contains the mappings when moving from the plugboard to
-   the reflector.
+   the reflector, with the rotor in its A position.
    backward_wiring_ contains the mappings when moving from the reflector
-   to the plugboard. 
+   to the plugboard, with the rotor in its A position. 
    These are different because the letters do not have to be paired, any 
    letter can map to any letter, as long as every letter is mapped to and 
    from exactly once.
-   letter_tracker_ contains the positions of each letter as the rotor rotates.
-   notch_array_ points to an integer array which contains the notch positions
-   for the rotor. 
-   number_of_notches_ is the number of notches that the rotor has.*/
+   position_ is the letter at the top of the rotor. Rotating the rotor only
+   changes position_; the wirings are offset by it on every lookup.
+   ring_setting_ is the offset of the wiring core from the alphabet ring
+   (the Ringstellung). It is folded into both wirings when it is set, so
+   lookups cost the same whatever the ring setting. The notches are on
+   the ring and do not move with it.
+   notch_mask_ contains one bit per letter, set for the letters that have
+   a notch.
+   Rotor is the 26 letter rotor and ByteRotor the 256 symbol rotor. */
 
 #include "Wiring.hpp"
 #include "constants.h"
-#include <fstream>
+#include <cstdint>
+#include <istream>
 #include <string>
 
-class Rotor
+template <int ALPHABET_SIZE>
+class alignas(CACHE_LINE_SIZE) BasicRotor
 {
  public:
   /* Function to initialise Rotor object to have all letters
      mapping to themselves, and no notches.*/
-  Rotor();
-
-  /* Destructor. */
-  ~Rotor();
+  BasicRotor();
 
   /* Function to set up Rotor object with mappings and notches given
      in the configuration file. 
@@ -38,6 +44,24 @@ class Rotor
      'errors.h' file. */
   int setUp(char const* const input_file_name);
 
+  /* Function to set up the object like setUp above, reading the
+     configuration from the input stream in instead of a named file, so
+     it can also come from memory.
+     input_file_name is the name used for the configuration in error
+     messages. */
+  int setUp(std::istream& in, char const* const input_file_name);
+
+  /* Function to set up the object from wirings and notches which have
+     already been checked, such as those of the built-in catalog, without
+     reading any file.
+     forward and backward are the two wirings at position 0, backward
+     being the inverse of forward.
+     notch_mask holds one bit per letter, set for the letters with a
+     notch, in (ALPHABET_SIZE + 63) / 64 words. */
+  void setUp(std::uint8_t const forward[ALPHABET_SIZE],
+	     std::uint8_t const backward[ALPHABET_SIZE],
+	     std::uint64_t const* notch_mask);
+
   /* Function to return the output letter index that the rotor maps the 
      input letter index to in the forward direction. */
   int getForwardRotorLetter(int input_letter) const;
@@ -46,15 +70,35 @@ class Rotor
      input letter index to in the backward direction. */
   int getBackwardRotorLetter(int input_letter) const;
 
+  /* Functions to return the output letter index that the rotor would map
+     the input letter index to if it were at position instead of its own
+     position, so one rotor can be shared by machines at different
+     positions. */
+  int getForwardRotorLetter(int input_letter, int position) const;
+  int getBackwardRotorLetter(int input_letter, int position) const;
+
+  /* Function to set wiring to the whole mapping of the rotor in the
+     forward direction at its current position. */
+  void getForwardWiring(BasicWiring<ALPHABET_SIZE>& wiring) const;
+
   /* Function to return letter at the absolute A position. */
   int getTopLetter() const;
 
   /* Function to get number of notches. */
   int getNumberOfNotches() const;
 
-  /* Function to get notch in notch array element accessed by index. */
+  /* Function to get the notch accessed by index, counting the notches
+     in alphabetical order. */
   int getNotch(int index) const;
 
+  /* Function to return true if the letter at the top of the rotor has a
+     notch. */
+  bool isAtNotch() const;
+
+  /* Function to return true if the letter with index position has a
+     notch. */
+  bool isNotch(int position) const;
+
   /* Function to rotate rotor 'up' by 1 position (position 1 moves to 
      position 0). */
   void rotateUp();
@@ -62,26 +106,43 @@ class Rotor
   /* Function to rotate rotor by number of letters given. */
   void rotate(int amount_to_rotate_by);
 
+  /* Function to return true if the rotor is one step before a notch, so
+     its next step will land on it. */
+  bool isBeforeNotch() const;
+
+  /* Function to turn the wiring core to ring_setting letters from its
+     position on the ring, which must be between 0 and ALPHABET_SIZE - 1.
+     The position and notches are unchanged. */
+  void setRingSetting(int ring_setting);
+
+  /* Function to return the ring setting. */
+  int getRingSetting() const;
+
 
  private:
-  Wiring forward_wiring_;
-  Wiring backward_wiring_;
-  Wiring letter_tracker_;
-  int* notch_array_;
-  int number_of_notches_;
+  /* Number of 64 bit words in the notch bitmask. */
+  static const int NOTCH_MASK_WORDS = (ALPHABET_SIZE + 63) / 64;
+
+  BasicWiring<ALPHABET_SIZE> forward_wiring_;
+  BasicWiring<ALPHABET_SIZE> backward_wiring_;
+  std::uint8_t position_;
+  std::uint8_t ring_setting_;
+  std::uint64_t notch_mask_[NOTCH_MASK_WORDS];
 
   /* Function to check and extract rotor input from configuration file. 
-     connections is an empty 26 element array which is filled up with 
-     the mappings given in the configuration file.
-     dummy_notch_array is an empty 26 element array which is filled up
-     with the notch positions given in the configuration file.
+     connections is an empty ALPHABET_SIZE element array which is filled
+     up with the mappings given in the configuration file.
+     dummy_notch_array is an empty ALPHABET_SIZE element array which is
+     filled up with the notch positions given in the configuration file.
+     number_of_notches is set to the number of notches read in.
      in is the input file stream connected to the configuration file. 
      file_name is a pointer to a c-string containing the name of the
      configuration file. 
      The function returns an error code corresponding to those in 'errors.h' */
-  int readRotorInput(int connections[ALPHABET_LENGTH],
-		     int dummy_notch_array[ALPHABET_LENGTH],
-		     std::ifstream& in,
+  int readRotorInput(int connections[ALPHABET_SIZE],
+		     int dummy_notch_array[ALPHABET_SIZE],
+		     int& number_of_notches,
+		     std::istream& in,
 		     char const* const file_name);
 
   /* Function to check if rotor input is a numeric character.
@@ -96,7 +157,7 @@ class Rotor
 		   bool is_notch = false) const;
 
   /* Function to check if rotor input is a valid index between 
-     0 and 25.
+     0 and ALPHABET_SIZE - 1.
      letter_index is the number to be checked.
      file_name is a pointer to a c-string containing the name of the
      configuration file. 
@@ -121,13 +182,12 @@ class Rotor
 		  char const* const file_name,
 		  bool notch = false) const;
 
-  /* Function to convert forward mapping to equivalent backward mapping. 
-   forward_connections is a 26 element array containing the rotor mappings
-   read from the configuration file. 
-   backward_connections is an empty 26 element array which will be filled
-   with the backward mappings. */ 
-  void convertForwardToBackward(int const forward_connections[ALPHABET_LENGTH],
-				int backward_connections[ALPHABET_LENGTH]) const;
+  /* Function to bring a letter index in the range 0 to
+     2 * ALPHABET_SIZE - 1 back into the alphabet. */
+  static int wrap(int letter_index);
 };
 
+typedef BasicRotor<ALPHABET_LENGTH> Rotor;
+typedef BasicRotor<BYTE_ALPHABET_LENGTH> ByteRotor;
+
 #endif
@@ -0,0 +1,155 @@
+/* This file contains the member function definitions
+   for the Scorer class template */
+
+#include "Scorer.hpp"
+#include "Enigma.hpp"
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+template <int ALPHABET_SIZE>
+BasicScorer<ALPHABET_SIZE>::BasicScorer() :
+  bigram_scores_(ALPHABET_SIZE * ALPHABET_SIZE, 0),
+  best_bigram_score_(0) {}
+
+template <int ALPHABET_SIZE>
+void BasicScorer<ALPHABET_SIZE>::setBigramScores(
+    int const scores[ALPHABET_SIZE][ALPHABET_SIZE])
+{
+  best_bigram_score_ = scores[0][0];
+  for (int i = 0; i < ALPHABET_SIZE; i++) {
+    for (int j = 0; j < ALPHABET_SIZE; j++) {
+      bigram_scores_[i * ALPHABET_SIZE + j] = scores[i][j];
+      if (scores[i][j] > best_bigram_score_) {
+	best_bigram_score_ = scores[i][j];
+      }
+    }
+  }
+}
+
+template <int ALPHABET_SIZE>
+bool BasicScorer<ALPHABET_SIZE>::scoreCoincidences(
+    BasicEnigma<ALPHABET_SIZE>& enigma,
+    char const* ciphertext, size_t length,
+    uint64_t threshold, uint64_t& score) const
+{
+  uint32_t counts[ALPHABET_SIZE] = {};
+
+  // Working out the bound costs a pass over the histogram, so it is only
+  // checked about once per ALPHABET_SIZE letters.
+  const size_t blocks_per_check =
+    (ALPHABET_SIZE + SCORE_BLOCK_LENGTH - 1) / SCORE_BLOCK_LENGTH;
+
+  size_t i = 0;
+  for (size_t block = 1; i + SCORE_BLOCK_LENGTH <= length; block++) {
+    countBlock(enigma, ciphertext + i, counts);
+    i += SCORE_BLOCK_LENGTH;
+    if (block % blocks_per_check != 0) {
+      continue;
+    }
+
+    uint64_t partial_score = 0;
+    uint64_t highest_count = 0;
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+      uint64_t count = counts[letter];
+      partial_score += count * (count - 1);
+      highest_count = (count > highest_count) ? count : highest_count;
+    }
+
+    // The score grows fastest if every remaining letter is the most
+    // common one so far, when the k-th of them adds 2(highest + k).
+    uint64_t remaining = length - i;
+    uint64_t best_final_score = partial_score + 2 * remaining * highest_count
+      + remaining * (remaining - 1);
+    if (best_final_score < threshold) {
+      score = partial_score;
+      return false;
+    }
+  }
+
+  for (; i < length; i++) {
+    int letter_index = static_cast<unsigned char>(ciphertext[i])
+      - BasicEnigma<ALPHABET_SIZE>::FIRST_SYMBOL;
+    counts[enigma.codeIndex(letter_index)]++;
+  }
+
+  score = 0;
+  for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+    uint64_t count = counts[letter];
+    score += count * (count - 1);
+  }
+  return score >= threshold;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicScorer<ALPHABET_SIZE>::scoreBigrams(
+    BasicEnigma<ALPHABET_SIZE>& enigma,
+    char const* ciphertext, size_t length,
+    int64_t threshold, int64_t& score) const
+{
+  score = 0;
+  if (length == 0) {
+    return score >= threshold;
+  }
+
+  int previous_letter = enigma.codeIndex(
+      static_cast<unsigned char>(ciphertext[0])
+      - BasicEnigma<ALPHABET_SIZE>::FIRST_SYMBOL);
+
+  for (size_t i = 1; i < length; i++) {
+    int letter = enigma.codeIndex(static_cast<unsigned char>(ciphertext[i])
+				  - BasicEnigma<ALPHABET_SIZE>::FIRST_SYMBOL);
+    score += bigram_scores_[previous_letter * ALPHABET_SIZE + letter];
+    previous_letter = letter;
+
+    if (i % SCORE_BLOCK_LENGTH == 0) {
+      int64_t remaining = length - 1 - i;
+      if (score + remaining * best_bigram_score_ < threshold) {
+	return false;
+      }
+    }
+  }
+
+  return score >= threshold;
+}
+
+template <int ALPHABET_SIZE>
+void BasicScorer<ALPHABET_SIZE>::countBlock(
+    BasicEnigma<ALPHABET_SIZE>& enigma,
+    char const* ciphertext, uint32_t* counts)
+{
+  alignas(SCORE_BLOCK_LENGTH) uint8_t plaintext[SCORE_BLOCK_LENGTH];
+  for (int i = 0; i < SCORE_BLOCK_LENGTH; i++) {
+    int letter_index = static_cast<unsigned char>(ciphertext[i])
+      - BasicEnigma<ALPHABET_SIZE>::FIRST_SYMBOL;
+    plaintext[i] = enigma.codeIndex(letter_index);
+  }
+
+#ifdef __SSE2__
+  // With only 26 letters it is cheaper to compare the whole block with
+  // each letter in turn than to update the histogram one letter at a
+  // time, which would chain dependent loads and stores to the same
+  // counters.
+  if (ALPHABET_SIZE == ALPHABET_LENGTH) {
+    __m128i block = _mm_load_si128(reinterpret_cast<__m128i*>(plaintext));
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++) {
+      __m128i matches = _mm_cmpeq_epi8(block, _mm_set1_epi8(letter));
+      counts[letter] += __builtin_popcount(_mm_movemask_epi8(matches));
+    }
+    return;
+  }
+#endif
+
+  for (int i = 0; i < SCORE_BLOCK_LENGTH; i++) {
+    counts[plaintext[i]]++;
+  }
+}
+
+template class BasicScorer<ALPHABET_LENGTH>;
+template class BasicScorer<BYTE_ALPHABET_LENGTH>;
@@ -0,0 +1,75 @@
+#ifndef SCORER_H
+#define SCORER_H
+
+/* The Scorer class template decrypts a ciphertext with an Enigma machine
+   and scores the result in the same pass, for key searches which try
+   very many candidate settings. The plaintext is never written out:
+   each letter goes straight from the machine into the running score, so
+   the only memory traffic is reading the ciphertext.
+   Two scores are supported. The coincidence score is the number of
+   ordered pairs of equal letters in the plaintext, the sum over the
+   alphabet of n(n - 1) for a letter occurring n times, which is the
+   numerator of the index of coincidence and needs no language data.
+   The bigram score is the sum of the scores of consecutive letter
+   pairs, taken from a table such as log probabilities of a language.
+   Both kernels take a threshold and stop early, returning false, as
+   soon as the score can no longer reach it however the remaining letters
+   turn out, so poor candidates cost little more than their first few
+   blocks.
+   For the 26 letter alphabet the histogram is counted a block of
+   SCORE_BLOCK_LENGTH letters at a time with SSE2 byte comparisons.
+   bigram_scores_ contains the score of each pair of letters, indexed by
+   first letter * ALPHABET_SIZE + second letter.
+   best_bigram_score_ is the largest score in bigram_scores_.
+   Scorer scores with an Enigma and ByteScorer with a ByteEnigma. */
+
+#include "Enigma.hpp"
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <int ALPHABET_SIZE>
+class BasicScorer
+{
+public:
+  /* Function to initialise Scorer object with every bigram scoring 0. */
+  BasicScorer();
+
+  /* Function to set the bigram scores. scores[a][b] is the score of
+     letter index a followed by letter index b. */
+  void setBigramScores(int const scores[ALPHABET_SIZE][ALPHABET_SIZE]);
+
+  /* Function to decrypt length symbols of ciphertext with enigma, which
+     is stepped as if they were coded, and set score to the coincidence
+     score of the plaintext. Every ciphertext symbol must be a valid
+     input to enigma.
+     Returns false, with score set to the score so far, if the final
+     score is certain to be below threshold. The machine is then left
+     part way through the ciphertext. */
+  bool scoreCoincidences(BasicEnigma<ALPHABET_SIZE>& enigma,
+			 char const* ciphertext, std::size_t length,
+			 std::uint64_t threshold, std::uint64_t& score) const;
+
+  /* Function to decrypt like scoreCoincidences and set score to the
+     bigram score of the plaintext, returning false if the final score
+     is certain to be below threshold. */
+  bool scoreBigrams(BasicEnigma<ALPHABET_SIZE>& enigma,
+		    char const* ciphertext, std::size_t length,
+		    std::int64_t threshold, std::int64_t& score) const;
+
+private:
+  std::vector<std::int32_t> bigram_scores_;
+  std::int32_t best_bigram_score_;
+
+  /* Function to decrypt the block of SCORE_BLOCK_LENGTH symbols starting
+     at ciphertext and add the number of times each letter index occurs
+     in the plaintext to counts. */
+  static void countBlock(BasicEnigma<ALPHABET_SIZE>& enigma,
+			 char const* ciphertext, std::uint32_t* counts);
+};
+
+typedef BasicScorer<ALPHABET_LENGTH> Scorer;
+typedef BasicScorer<BYTE_ALPHABET_LENGTH> ByteScorer;
+
+#endif
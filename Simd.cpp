@@ -0,0 +1,145 @@
+/* This file contains the definitions of the vector functions */
+
+#include "Simd.hpp"
+#include "constants.h"
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_VECTORS 1
+#endif
+
+using namespace std;
+
+#ifdef HAS_X86_VECTORS
+namespace {
+  /* Function to load a wiring into two registers, each holding one half
+     of it in both of their 16 byte lanes. */
+  __attribute__((target("avx2")))
+  inline void loadWiring(uint8_t const* wiring, __m256i& low, __m256i& high)
+  {
+    low = _mm256_broadcastsi128_si256(
+	_mm_load_si128(reinterpret_cast<__m128i const*>(wiring)));
+    high = _mm256_broadcastsi128_si256(
+	_mm_load_si128(reinterpret_cast<__m128i const*>(wiring + 16)));
+  }
+
+  /* Function to map every letter index in letters through the wiring
+     loaded into low and high. A byte shuffle only indexes 16 bytes, so
+     both halves are looked up and the right result chosen per byte. */
+  __attribute__((target("avx2")))
+  inline __m256i lookUp(__m256i low, __m256i high, __m256i letters)
+  {
+    __m256i from_low = _mm256_shuffle_epi8(low, letters);
+    __m256i from_high =
+      _mm256_shuffle_epi8(high, _mm256_sub_epi8(letters,
+						_mm256_set1_epi8(16)));
+    __m256i is_high = _mm256_cmpgt_epi8(letters, _mm256_set1_epi8(15));
+    return _mm256_blendv_epi8(from_low, from_high, is_high);
+  }
+
+  /* Function to reduce every byte of letters, each below twice the
+     alphabet length, to a letter index. */
+  __attribute__((target("avx2")))
+  inline __m256i wrap(__m256i letters)
+  {
+    __m256i alphabet = _mm256_set1_epi8(ALPHABET_LENGTH);
+    __m256i is_past_z = _mm256_cmpgt_epi8(letters,
+					  _mm256_set1_epi8(Z_INDEX));
+    return _mm256_sub_epi8(letters, _mm256_and_si256(is_past_z, alphabet));
+  }
+}
+#endif
+
+bool hasAvx2()
+{
+#ifdef HAS_X86_VECTORS
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+#ifdef HAS_X86_VECTORS
+__attribute__((target("avx2")))
+#endif
+void codeLetterBlockAvx2(
+    SimdLetterWirings const& wirings,
+    uint8_t const (*inner_wirings)[SIMD_BLOCK_LENGTH],
+    uint8_t const* inner_wiring_indices,
+    int number_of_inner_wirings,
+    uint8_t const* positions,
+    uint8_t* letters)
+{
+#ifdef HAS_X86_VECTORS
+  __m256i alphabet = _mm256_set1_epi8(ALPHABET_LENGTH);
+  __m256i low, high;
+  __m256i rotor_positions =
+    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(positions));
+  __m256i block =
+    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(letters));
+
+  loadWiring(wirings.plugboard, low, high);
+  block = lookUp(low, high, block);
+
+  // The rotor is turned by offsetting the letter on the way in and out.
+  loadWiring(wirings.forward, low, high);
+  block = lookUp(low, high, wrap(_mm256_add_epi8(block, rotor_positions)));
+  block = wrap(_mm256_sub_epi8(_mm256_add_epi8(block, alphabet),
+			       rotor_positions));
+
+  loadWiring(inner_wirings[0], low, high);
+  __m256i inner = lookUp(low, high, block);
+  __m256i indices =
+    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(inner_wiring_indices));
+  for (int i = 1; i < number_of_inner_wirings; i++) {
+    loadWiring(inner_wirings[i], low, high);
+    __m256i is_used = _mm256_cmpeq_epi8(indices, _mm256_set1_epi8(i));
+    inner = _mm256_blendv_epi8(inner, lookUp(low, high, block), is_used);
+  }
+
+  loadWiring(wirings.backward, low, high);
+  block = lookUp(low, high, wrap(_mm256_add_epi8(inner, rotor_positions)));
+  block = wrap(_mm256_sub_epi8(_mm256_add_epi8(block, alphabet),
+			       rotor_positions));
+
+  loadWiring(wirings.plugboard, low, high);
+  block = lookUp(low, high, block);
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(letters), block);
+#else
+  (void) wirings;
+  (void) inner_wirings;
+  (void) inner_wiring_indices;
+  (void) number_of_inner_wirings;
+  (void) positions;
+  (void) letters;
+#endif
+}
+
+#ifdef HAS_X86_VECTORS
+__attribute__((target("avx2")))
+#endif
+uint32_t findCribClashesAvx2(uint8_t const* text,
+			     uint8_t const (*crib)[SIMD_BLOCK_LENGTH],
+			     int crib_length)
+{
+#ifdef HAS_X86_VECTORS
+  // Lane i of the register loaded at text + j holds the symbol under
+  // crib symbol j when the crib starts at offset i.
+  __m256i clashes = _mm256_setzero_si256();
+  for (int j = 0; j < crib_length; j++) {
+    __m256i symbols =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + j));
+    __m256i crib_symbol =
+      _mm256_load_si256(reinterpret_cast<__m256i const*>(crib[j]));
+    clashes = _mm256_or_si256(clashes,
+			      _mm256_cmpeq_epi8(symbols, crib_symbol));
+  }
+  return static_cast<uint32_t>(_mm256_movemask_epi8(clashes));
+#else
+  (void) text;
+  (void) crib;
+  (void) crib_length;
+  return 0;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/* The functions in this file code blocks of letters, and rule out crib
+   positions, with the vector instructions of the processor. They are
+   compiled for AVX2 with a function attribute rather than a compiler
+   flag, so the rest of the program still runs on processors without it,
+   and must only be called once hasAvx2 has returned true.
+   A letter wiring is held in SIMD_BLOCK_LENGTH bytes, of which only the
+   first ALPHABET_LENGTH are used, so it fills one vector register and
+   each letter of a block is mapped by a single byte shuffle. */
+
+#include "constants.h"
+#include <cstdint>
+
+/* The wirings which stay the same for a whole block of letters:
+   the plugboard, and the rightmost rotor forward and backward at
+   position 0. */
+struct SimdLetterWirings
+{
+  alignas(SIMD_BLOCK_LENGTH) std::uint8_t plugboard[SIMD_BLOCK_LENGTH];
+  alignas(SIMD_BLOCK_LENGTH) std::uint8_t forward[SIMD_BLOCK_LENGTH];
+  alignas(SIMD_BLOCK_LENGTH) std::uint8_t backward[SIMD_BLOCK_LENGTH];
+};
+
+/* Function to return true if the processor supports AVX2. */
+bool hasAvx2();
+
+/* Function to code SIMD_BLOCK_LENGTH letter indices in place.
+   positions contains the position of the rightmost rotor for each
+   letter, after it stepped.
+   inner_wirings contains number_of_inner_wirings inner wirings (see
+   Enigma) and inner_wiring_indices contains the index of the one used
+   for each letter, so a block may span carries of the slower rotors. */
+void codeLetterBlockAvx2(
+    SimdLetterWirings const& wirings,
+    std::uint8_t const (*inner_wirings)[SIMD_BLOCK_LENGTH],
+    std::uint8_t const* inner_wiring_indices,
+    int number_of_inner_wirings,
+    std::uint8_t const* positions,
+    std::uint8_t* letters);
+
+/* Function to compare a crib with text at SIMD_BLOCK_LENGTH consecutive
+   offsets. Returns a mask with bit i set if some symbol of the crib is
+   the same as the symbol of text it would sit on at offset i, which
+   rules that offset out, since the machine never codes a symbol as
+   itself. crib holds crib_length rows, each filled with one symbol of
+   the crib, and must be aligned to SIMD_BLOCK_LENGTH bytes. text must
+   have SIMD_BLOCK_LENGTH + crib_length - 1 readable bytes. */
+std::uint32_t findCribClashesAvx2(
+    std::uint8_t const* text,
+    std::uint8_t const (*crib)[SIMD_BLOCK_LENGTH],
+    int crib_length);
+
+#endif
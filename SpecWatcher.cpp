@@ -0,0 +1,261 @@
+/* This file contains the member function definitions
+   for the SpecWatcher class template */
+
+#include "SpecWatcher.hpp"
+#include "EnigmaSpec.hpp"
+#include "Enigma.hpp"
+#include "Catalog.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace std;
+
+template <int ALPHABET_SIZE>
+BasicSpecWatcher<ALPHABET_SIZE>::BasicSpecWatcher() :
+  configuration_files_(),
+  ring_file_name_(),
+  is_double_stepping_(false),
+  spec_(),
+  version_(0),
+  watched_files_(),
+  inotify_fd_(-1),
+  stop_fd_(-1),
+  thread_() {}
+
+template <int ALPHABET_SIZE>
+BasicSpecWatcher<ALPHABET_SIZE>::~BasicSpecWatcher()
+{
+  stop();
+}
+
+template <int ALPHABET_SIZE>
+int BasicSpecWatcher<ALPHABET_SIZE>::start(
+    int number_of_files,
+    char const* const* const configuration_files,
+    char const* const ring_file_name,
+    bool is_double_stepping)
+{
+  stop();
+  configuration_files_.assign(configuration_files,
+			      configuration_files + number_of_files);
+  ring_file_name_ = (ring_file_name != nullptr) ? ring_file_name : "";
+  is_double_stepping_ = is_double_stepping;
+
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  stop_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (inotify_fd_ < 0 || stop_fd_ < 0) {
+    cerr << "Cannot watch the configuration files: " << strerror(errno);
+    cerr << endl;
+    closeDescriptors();
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  // The files are watched before they are first read, so a change made
+  // while they are being read still raises an event and is picked up.
+  int error_code = NO_ERROR;
+  watched_files_.clear();
+  for (string const& file_name : configuration_files_) {
+    error_code = watchFile(file_name);
+    if (error_code != NO_ERROR) {
+      closeDescriptors();
+      return error_code;
+    }
+  }
+  if (!ring_file_name_.empty()) {
+    error_code = watchFile(ring_file_name_);
+    if (error_code != NO_ERROR) {
+      closeDescriptors();
+      return error_code;
+    }
+  }
+
+  shared_ptr<BasicEnigmaSpec<ALPHABET_SIZE> const> spec;
+  error_code = loadSpec(spec);
+  if (error_code != NO_ERROR) {
+    closeDescriptors();
+    return error_code;
+  }
+  atomic_store(&spec_, spec);
+  version_.fetch_add(1);
+
+  thread_ = thread(&BasicSpecWatcher::watch, this);
+  return NO_ERROR;
+}
+
+template <int ALPHABET_SIZE>
+void BasicSpecWatcher<ALPHABET_SIZE>::stop()
+{
+  if (thread_.joinable()) {
+    std::uint64_t increment = 1;
+    while (write(stop_fd_, &increment, sizeof(increment)) < 0
+	   && errno == EINTR) {
+    }
+    thread_.join();
+  }
+  closeDescriptors();
+}
+
+template <int ALPHABET_SIZE>
+shared_ptr<BasicEnigmaSpec<ALPHABET_SIZE> const>
+BasicSpecWatcher<ALPHABET_SIZE>::getSpec() const
+{
+  return atomic_load(&spec_);
+}
+
+template <int ALPHABET_SIZE>
+std::uint64_t BasicSpecWatcher<ALPHABET_SIZE>::getVersion() const
+{
+  return version_.load();
+}
+
+template <int ALPHABET_SIZE>
+int BasicSpecWatcher<ALPHABET_SIZE>::loadSpec(
+    shared_ptr<BasicEnigmaSpec<ALPHABET_SIZE> const>& spec) const
+{
+  vector<char const*> configuration_files;
+  for (string const& file_name : configuration_files_) {
+    configuration_files.push_back(file_name.c_str());
+  }
+
+  BasicEnigma<ALPHABET_SIZE> enigma;
+  enigma.setDoubleStepping(is_double_stepping_);
+  int error_code = enigma.setUp(configuration_files.size(),
+				configuration_files.data());
+  if (error_code == NO_ERROR && !ring_file_name_.empty()) {
+    error_code = enigma.setUpRingSettings(ring_file_name_.c_str());
+  }
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  spec = make_shared<BasicEnigmaSpec<ALPHABET_SIZE> const>(enigma);
+  return NO_ERROR;
+}
+
+template <int ALPHABET_SIZE>
+int BasicSpecWatcher<ALPHABET_SIZE>::watchFile(string const& file_name)
+{
+  if (isBuiltinName(file_name.c_str())) {
+    return NO_ERROR;
+  }
+
+  size_t slash = file_name.rfind('/');
+  string directory = (slash == string::npos) ? "."
+    : (slash == 0) ? "/" : file_name.substr(0, slash);
+  string name = (slash == string::npos)
+    ? file_name : file_name.substr(slash + 1);
+
+  int watch_descriptor =
+    inotify_add_watch(inotify_fd_, directory.c_str(),
+		      IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+  if (watch_descriptor < 0) {
+    cerr << "Cannot watch configuration file " << file_name << ": ";
+    cerr << strerror(errno) << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  watched_files_.push_back(WatchedFile{watch_descriptor, name});
+  return NO_ERROR;
+}
+
+template <int ALPHABET_SIZE>
+bool BasicSpecWatcher<ALPHABET_SIZE>::readEvents()
+{
+  alignas(inotify_event) char buffer[4096];
+  bool is_changed = false;
+  ssize_t length;
+  while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+    for (ssize_t offset = 0; offset < length;) {
+      inotify_event const* event =
+	reinterpret_cast<inotify_event const*>(buffer + offset);
+      for (WatchedFile const& file : watched_files_) {
+	if (event->wd == file.watch_descriptor && event->len > 0
+	    && file.name == event->name) {
+	  is_changed = true;
+	}
+      }
+      offset += sizeof(inotify_event) + event->len;
+    }
+  }
+  return is_changed;
+}
+
+template <int ALPHABET_SIZE>
+void BasicSpecWatcher<ALPHABET_SIZE>::reload()
+{
+  shared_ptr<BasicEnigmaSpec<ALPHABET_SIZE> const> spec;
+  if (loadSpec(spec) != NO_ERROR) {
+    cerr << "Keeping the previous configuration" << endl;
+    return;
+  }
+
+  // Streams which took the old spec keep their own reference to it, so
+  // it is only freed once the last of them has finished.
+  atomic_store(&spec_, spec);
+  version_.fetch_add(1);
+}
+
+template <int ALPHABET_SIZE>
+void BasicSpecWatcher<ALPHABET_SIZE>::watch()
+{
+  pollfd descriptors[2] = {
+    {inotify_fd_, POLLIN, 0},
+    {stop_fd_, POLLIN, 0}
+  };
+
+  // A change is only acted on once the files have been quiet for a
+  // while, so a key change which rewrites several files, or writes one
+  // in several steps, is loaded once and as a whole.
+  bool is_changed = false;
+  for (;;) {
+    int timeout = (is_changed) ? WATCH_SETTLE_MILLISECONDS : -1;
+    int ready = poll(descriptors, 2, timeout);
+    if (ready < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      cerr << "Stopped watching the configuration files: ";
+      cerr << strerror(errno) << endl;
+      return;
+    }
+    if (descriptors[1].revents != 0) {
+      return;
+    }
+    if (ready == 0) {
+      is_changed = false;
+      reload();
+    } else if (readEvents()) {
+      is_changed = true;
+    }
+  }
+}
+
+template <int ALPHABET_SIZE>
+void BasicSpecWatcher<ALPHABET_SIZE>::closeDescriptors()
+{
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+  }
+  if (stop_fd_ >= 0) {
+    close(stop_fd_);
+    stop_fd_ = -1;
+  }
+  watched_files_.clear();
+}
+
+template class BasicSpecWatcher<ALPHABET_LENGTH>;
+template class BasicSpecWatcher<BYTE_ALPHABET_LENGTH>;
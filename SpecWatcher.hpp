@@ -0,0 +1,132 @@
+#ifndef SPEC_WATCHER_H
+#define SPEC_WATCHER_H
+
+/* The SpecWatcher class template keeps an EnigmaSpec up to date with the
+   configuration files it was set up from, so a long-running process can
+   pick up new keys without restarting. A background thread watches the
+   files with inotify and, once they have stopped changing for
+   WATCH_SETTLE_MILLISECONDS, sets up a machine from them again. If every
+   file is still valid the new spec is published by swapping one shared
+   pointer; otherwise the errors are reported and the previous spec stays
+   in use.
+   Published specs are never changed, and each stream takes the current
+   one when it starts (see getSpec) and codes with its own EnigmaCursor,
+   so streams in flight keep the configuration they started with and
+   coding never waits for the watcher. A spec is freed once the last
+   stream holding it lets go, as in read-copy-update.
+   configuration_files_ contains the names of the configuration files,
+   in the order taken by Enigma::setUp. Names of built-in catalog entries
+   are kept but never watched.
+   ring_file_name_ is the name of the ring setting file, or empty if the
+   rings are not set.
+   is_double_stepping_ chooses the stepping (see
+   Enigma::setDoubleStepping).
+   spec_ is the current spec. It is only read and written with the
+   atomic shared pointer functions, so the watcher thread can replace it
+   while other threads take it.
+   version_ counts the specs published, starting from 1 for the one set
+   up by start.
+   watched_files_ contains the inotify watch of the directory holding
+   each watched file and the file's name within it. Directories are
+   watched rather than the files, so a file replaced by renaming a new
+   one over it, as editors and deployment tools do, is still noticed.
+   inotify_fd_ is the inotify file descriptor and stop_fd_ an eventfd
+   which wakes the watcher thread to stop, or -1 if they are not open.
+   thread_ runs the watcher thread.
+   SpecWatcher publishes an EnigmaSpec and ByteSpecWatcher a
+   ByteEnigmaSpec. */
+
+#include "EnigmaSpec.hpp"
+#include "constants.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+template <int ALPHABET_SIZE>
+class BasicSpecWatcher
+{
+public:
+  /* Function to initialise a watcher which has no spec yet. */
+  BasicSpecWatcher();
+
+  /* Destructor, which stops the watcher thread. */
+  ~BasicSpecWatcher();
+
+  /* The watcher thread refers to the watcher, so it is never copied. */
+  BasicSpecWatcher(BasicSpecWatcher const&) = delete;
+  BasicSpecWatcher& operator=(BasicSpecWatcher const&) = delete;
+
+  /* Function to set up the first spec from the number_of_files
+     configuration files named in configuration_files, as Enigma::setUp
+     does, and to start watching them. If ring_file_name is not nullptr
+     the ring settings are read from it, and it is watched too.
+     is_double_stepping chooses the stepping.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int start(int number_of_files,
+	    char const* const* const configuration_files,
+	    char const* const ring_file_name, bool is_double_stepping);
+
+  /* Function to stop watching the files. The current spec stays
+     available. */
+  void stop();
+
+  /* Function to return the current spec, which stays valid for as long
+     as the returned pointer is held even if a newer one is published. */
+  std::shared_ptr<BasicEnigmaSpec<ALPHABET_SIZE> const> getSpec() const;
+
+  /* Function to return the number of specs published so far. */
+  std::uint64_t getVersion() const;
+
+private:
+  /* A watched file: the watch descriptor of its directory and its name
+     within that directory. */
+  struct WatchedFile
+  {
+    int watch_descriptor;
+    std::string name;
+  };
+
+  std::vector<std::string> configuration_files_;
+  std::string ring_file_name_;
+  bool is_double_stepping_;
+  std::shared_ptr<BasicEnigmaSpec<ALPHABET_SIZE> const> spec_;
+  std::atomic<std::uint64_t> version_;
+  std::vector<WatchedFile> watched_files_;
+  int inotify_fd_;
+  int stop_fd_;
+  std::thread thread_;
+
+  /* Function to set up a machine from the configuration files and take a
+     spec from it into spec.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int loadSpec(
+    std::shared_ptr<BasicEnigmaSpec<ALPHABET_SIZE> const>& spec) const;
+
+  /* Function to add an inotify watch on the directory holding the file
+     named file_name.
+     The function returns an error code corresponding to those in 'errors.h' */
+  int watchFile(std::string const& file_name);
+
+  /* Function to read the pending inotify events. Returns true if any of
+     them is about a watched file. */
+  bool readEvents();
+
+  /* Function to load and publish a new spec, keeping the current one if
+     any file is invalid. */
+  void reload();
+
+  /* Function run by the watcher thread, which reloads the files each time
+     they settle after a change until stop is called. */
+  void watch();
+
+  /* Function to close the file descriptors which are open. */
+  void closeDescriptors();
+};
+
+typedef BasicSpecWatcher<ALPHABET_LENGTH> SpecWatcher;
+typedef BasicSpecWatcher<BYTE_ALPHABET_LENGTH> ByteSpecWatcher;
+
+#endif
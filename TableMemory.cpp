@@ -0,0 +1,236 @@
+/* This file contains the member function definitions
+   for the TableMemory class */
+
+#include "TableMemory.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+  /* The state shared by every table in the process. tables holds every
+     table which currently has memory mapped. clock is bumped on every
+     pin to order the tables by their last use. */
+  struct TableRegistry
+  {
+    mutex lock;
+    size_t budget = DEFAULT_TABLE_MEMORY_BUDGET;
+    size_t bytes_in_use = 0;
+    std::uint64_t clock = 0;
+    vector<TableMemory*> tables;
+  };
+
+  /* Function to return the registry, which is created on first use so
+     machines constructed before main can still allocate tables. It is
+     never destroyed, so machines destroyed after main returns, such as
+     static ones, can still release their tables. */
+  TableRegistry& getRegistry()
+  {
+    static auto* registry = new TableRegistry;
+    return *registry;
+  }
+
+  /* Function to round size up to a whole number of pages of page_size
+     bytes. */
+  size_t roundUp(size_t size, size_t page_size)
+  {
+    return (size + page_size - 1) / page_size * page_size;
+  }
+
+  /* Function to map mapped_size bytes of zeroed memory, which must be a
+     whole number of huge pages if is_huge is true. Explicit huge pages
+     are tried first; when none are reserved the memory is aligned to a
+     huge page and offered to transparent huge pages instead, so the
+     kernel can still back it with them. is_huge is cleared if neither
+     works. Returns nullptr if nothing could be mapped. */
+  std::uint8_t* mapMemory(size_t mapped_size, bool& is_huge)
+  {
+    int const protection = PROT_READ | PROT_WRITE;
+    int const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (!is_huge) {
+      void* memory = mmap(nullptr, mapped_size, protection, flags, -1, 0);
+      return (memory == MAP_FAILED)
+	? nullptr : static_cast<std::uint8_t*>(memory);
+    }
+
+#ifdef MAP_HUGETLB
+    void* memory = mmap(nullptr, mapped_size, protection,
+			flags | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+      return static_cast<std::uint8_t*>(memory);
+    }
+#endif
+
+    // Map an extra huge page so that a huge page aligned range of the
+    // right size lies inside, then unmap what is either side of it.
+    size_t padded_size = mapped_size + HUGE_PAGE_SIZE;
+    void* padded = mmap(nullptr, padded_size, protection, flags, -1, 0);
+    if (padded == MAP_FAILED) {
+      return nullptr;
+    }
+    std::uint8_t* start = static_cast<std::uint8_t*>(padded);
+    std::uint8_t* aligned = reinterpret_cast<std::uint8_t*>(
+      roundUp(reinterpret_cast<uintptr_t>(start), HUGE_PAGE_SIZE));
+    if (aligned > start) {
+      munmap(start, aligned - start);
+    }
+    munmap(aligned + mapped_size,
+	   start + padded_size - (aligned + mapped_size));
+
+#ifdef MADV_HUGEPAGE
+    is_huge = (madvise(aligned, mapped_size, MADV_HUGEPAGE) == 0);
+#else
+    is_huge = false;
+#endif
+    return aligned;
+  }
+}
+
+TableMemory::TableMemory() :
+  data_(nullptr),
+  mapped_size_(0),
+  last_use_(0),
+  pins_(0),
+  is_huge_(false) {}
+
+TableMemory::~TableMemory()
+{
+  release();
+}
+
+std::uint8_t* TableMemory::allocate(size_t size)
+{
+  release();
+
+  // Tables smaller than a huge page would mostly waste one, so they are
+  // given normal pages.
+  bool is_huge = (size >= HUGE_PAGE_SIZE);
+  size_t mapped_size = (is_huge) ? roundUp(size, HUGE_PAGE_SIZE)
+    : roundUp(size, sysconf(_SC_PAGESIZE));
+
+  // The memory is charged to the budget before it is mapped, so two
+  // threads allocating at once cannot both take the last of it.
+  TableRegistry& registry = getRegistry();
+  {
+    lock_guard<mutex> guard(registry.lock);
+    if (mapped_size > registry.budget) {
+      return nullptr;
+    }
+    while (registry.bytes_in_use + mapped_size > registry.budget) {
+      if (!evictLeastRecentlyUsed(this)) {
+	return nullptr;
+      }
+    }
+    registry.bytes_in_use += mapped_size;
+  }
+
+  std::uint8_t* data = mapMemory(mapped_size, is_huge);
+
+  lock_guard<mutex> guard(registry.lock);
+  if (data == nullptr) {
+    registry.bytes_in_use -= mapped_size;
+    return nullptr;
+  }
+  data_ = data;
+  mapped_size_ = mapped_size;
+  last_use_ = ++registry.clock;
+  pins_ = 1;
+  is_huge_ = is_huge;
+  registry.tables.push_back(this);
+  return data_;
+}
+
+void TableMemory::release()
+{
+  TableRegistry& registry = getRegistry();
+  lock_guard<mutex> guard(registry.lock);
+  if (data_ != nullptr) {
+    unmap();
+  }
+  pins_ = 0;
+}
+
+std::uint8_t* TableMemory::pin()
+{
+  TableRegistry& registry = getRegistry();
+  lock_guard<mutex> guard(registry.lock);
+  if (data_ != nullptr) {
+    pins_++;
+    last_use_ = ++registry.clock;
+  }
+  return data_;
+}
+
+void TableMemory::unpin()
+{
+  TableRegistry& registry = getRegistry();
+  lock_guard<mutex> guard(registry.lock);
+  if (pins_ > 0) {
+    pins_--;
+  }
+}
+
+bool TableMemory::isHuge() const
+{
+  return is_huge_;
+}
+
+void TableMemory::setBudget(size_t budget)
+{
+  TableRegistry& registry = getRegistry();
+  lock_guard<mutex> guard(registry.lock);
+  registry.budget = budget;
+  while (registry.bytes_in_use > registry.budget
+	 && evictLeastRecentlyUsed(nullptr)) {
+  }
+}
+
+size_t TableMemory::getBudget()
+{
+  TableRegistry& registry = getRegistry();
+  lock_guard<mutex> guard(registry.lock);
+  return registry.budget;
+}
+
+size_t TableMemory::getBytesInUse()
+{
+  TableRegistry& registry = getRegistry();
+  lock_guard<mutex> guard(registry.lock);
+  return registry.bytes_in_use;
+}
+
+void TableMemory::unmap()
+{
+  TableRegistry& registry = getRegistry();
+  munmap(data_, mapped_size_);
+  registry.bytes_in_use -= mapped_size_;
+  registry.tables.erase(find(registry.tables.begin(), registry.tables.end(),
+			     this));
+  data_ = nullptr;
+  mapped_size_ = 0;
+  is_huge_ = false;
+}
+
+bool TableMemory::evictLeastRecentlyUsed(TableMemory const* kept_table)
+{
+  TableMemory* oldest_table = nullptr;
+  for (TableMemory* table : getRegistry().tables) {
+    if (table != kept_table && table->pins_ == 0
+	&& (oldest_table == nullptr
+	    || table->last_use_ < oldest_table->last_use_)) {
+      oldest_table = table;
+    }
+  }
+
+  if (oldest_table == nullptr) {
+    return false;
+  }
+  oldest_table->unmap();
+  return true;
+}
@@ -0,0 +1,102 @@
+#ifndef TABLEMEMORY_H
+#define TABLEMEMORY_H
+
+/* The TableMemory class holds the memory of one large lookup table, such
+   as the keystroke table of ENGINE_TABLE. The memory is mapped straight
+   from the kernel, on 2 MB huge pages when the table fills at least one,
+   so a table covering a whole period of a machine costs a few TLB entries
+   instead of hundreds.
+   Every table in the process is charged against one memory budget (see
+   setBudget). When a new table does not fit, the tables which have gone
+   longest without being used are evicted to make room: their memory is
+   unmapped and their owners find out the next time they pin them, and go
+   back to coding without a table.
+   data_ points to the table, or is nullptr if none is allocated or it has
+   been evicted.
+   mapped_size_ is the number of bytes mapped for the table, which is the
+   size asked for rounded up to whole pages and is what the budget is
+   charged.
+   last_use_ is the value of a process-wide counter when the table was
+   last pinned, so the table with the lowest value is the least recently
+   used.
+   pins_ counts the owner's pins which have not been undone. A pinned
+   table is never evicted.
+   is_huge_ is true if the table is backed by huge pages.
+   Every member is guarded by one process-wide mutex, so machines in
+   different threads can allocate, pin and evict tables safely. */
+
+#include <cstddef>
+#include <cstdint>
+
+/* The size of a huge page, and the budget shared by every table until
+   setBudget is called. */
+#define HUGE_PAGE_SIZE              (2 << 20)
+#define DEFAULT_TABLE_MEMORY_BUDGET (256 << 20)
+
+class TableMemory
+{
+public:
+  /* Function to initialise an empty TableMemory object. */
+  TableMemory();
+
+  /* Destructor, which releases the table. */
+  ~TableMemory();
+
+  /* A table belongs to one owner, so it is never copied. */
+  TableMemory(TableMemory const&) = delete;
+  TableMemory& operator=(TableMemory const&) = delete;
+
+  /* Function to replace the table with size uninitialised bytes, evicting
+     the least recently used tables of other owners if the budget would
+     otherwise be exceeded. The new table starts out pinned, so it can be
+     filled in before anything else evicts it; unpin must be called once
+     it is ready.
+     Returns the table, or nullptr, leaving no table, if it cannot fit in
+     the budget even after evicting every unpinned table, or if the memory
+     cannot be mapped. */
+  std::uint8_t* allocate(std::size_t size);
+
+  /* Function to unmap the table, if there is one, and return its memory
+     to the budget. */
+  void release();
+
+  /* Function to keep the table from being evicted until unpin is called,
+     and to mark it as the most recently used. Returns the table, or
+     nullptr if there is none because it was never allocated or has been
+     evicted. */
+  std::uint8_t* pin();
+
+  /* Function to undo a pin which returned a table. */
+  void unpin();
+
+  /* Function to return true if the table is backed by huge pages. */
+  bool isHuge() const;
+
+  /* Function to set the number of bytes all the tables in the process may
+     map together, evicting the least recently used unpinned tables until
+     they fit. */
+  static void setBudget(std::size_t budget);
+
+  /* Function to return the budget. */
+  static std::size_t getBudget();
+
+  /* Function to return the number of bytes mapped for tables. */
+  static std::size_t getBytesInUse();
+
+private:
+  std::uint8_t* data_;
+  std::size_t mapped_size_;
+  std::uint64_t last_use_;
+  int pins_;
+  bool is_huge_;
+
+  /* Function to unmap the table. The process-wide mutex must be held. */
+  void unmap();
+
+  /* Function to evict the least recently used unpinned table other than
+     kept_table, which may be nullptr. The process-wide mutex must be
+     held. Returns false if there is no such table. */
+  static bool evictLeastRecentlyUsed(TableMemory const* kept_table);
+};
+
+#endif
@@ -0,0 +1,163 @@
+/* This file contains the member function definitions
+   for the Tracer class */
+
+#include "Tracer.hpp"
+#include "errors.h"
+#include "constants.h"
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+  /* Header at the start of a trace file. first_keystroke is the number,
+     counting from 1, of the keystroke in the first record. */
+  struct TraceHeader
+  {
+    char magic[8];
+    uint32_t alphabet_size;
+    uint32_t number_of_rotors;
+    uint64_t number_of_records;
+    uint64_t first_keystroke;
+  };
+
+  const char TRACE_MAGIC[8] = {'E', 'N', 'I', 'G', 'T', 'R', 'C', '1'};
+}
+
+Tracer::Tracer(int alphabet_size, int number_of_rotors, size_t capacity) :
+  alphabet_size_(alphabet_size),
+  number_of_rotors_(number_of_rotors),
+  record_size_(4 + 3 * number_of_rotors),
+  capacity_(capacity),
+  records_(capacity * record_size_),
+  next_record_(0),
+  number_of_keystrokes_(0) {}
+
+uint8_t* Tracer::nextRecord()
+{
+  uint8_t* record = records_.data() + next_record_ * record_size_;
+  next_record_ = (next_record_ + 1 == capacity_) ? 0 : next_record_ + 1;
+  number_of_keystrokes_++;
+  return record;
+}
+
+int Tracer::write(char const* file_name) const
+{
+  ofstream out(file_name, ios::binary);
+  if (out.fail()) {
+    cerr << "Error opening trace file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  uint64_t number_of_records = (number_of_keystrokes_ < capacity_)
+    ? number_of_keystrokes_ : capacity_;
+
+  TraceHeader header = {};
+  memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  header.alphabet_size = alphabet_size_;
+  header.number_of_rotors = number_of_rotors_;
+  header.number_of_records = number_of_records;
+  header.first_keystroke = number_of_keystrokes_ - number_of_records + 1;
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+  // Once the ring has wrapped the oldest record is the one about to be
+  // overwritten.
+  size_t oldest = (number_of_keystrokes_ < capacity_) ? 0 : next_record_;
+  for (uint64_t i = 0; i < number_of_records; i++) {
+    size_t slot = (oldest + i) % capacity_;
+    out.write(reinterpret_cast<char const*>(records_.data())
+	      + slot * record_size_, record_size_);
+  }
+
+  if (!out) {
+    cerr << "Error writing trace file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+  return NO_ERROR;
+}
+
+int Tracer::printTrace(char const* file_name, ostream& out)
+{
+  ifstream in(file_name, ios::binary);
+  if (in.fail()) {
+    cerr << "Error opening trace file " << file_name << endl;
+    return ERROR_OPENING_CONFIGURATION_FILE;
+  }
+
+  TraceHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+    cerr << file_name << " is not a trace file" << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  // The records must fill the rest of the file exactly, so a damaged
+  // header is never trusted to size the record buffer or the reads.
+  in.seekg(0, ios::end);
+  uint64_t records_size = static_cast<uint64_t>(in.tellg()) - sizeof(header);
+  in.seekg(sizeof(header));
+  uint64_t record_size = 4 + 3 * static_cast<uint64_t>(header.number_of_rotors);
+  bool is_complete = in &&
+    header.number_of_records <= records_size / record_size;
+  bool is_valid = is_complete &&
+    (header.alphabet_size == ALPHABET_LENGTH ||
+     header.alphabet_size == BYTE_ALPHABET_LENGTH) &&
+    header.number_of_rotors <= INT_MAX / 3 &&
+    header.number_of_records * record_size == records_size;
+  if (!is_valid) {
+    cerr << "Trace file " << file_name;
+    cerr << (is_complete ? " is corrupt" : " is truncated") << endl;
+    return INVALID_ARGUMENT;
+  }
+
+  int rotors = header.number_of_rotors;
+  int alphabet_size = header.alphabet_size;
+  vector<uint8_t> record((header.number_of_records > 0) ? record_size : 0);
+  for (uint64_t i = 0; i < header.number_of_records; i++) {
+    if (!in.read(reinterpret_cast<char*>(record.data()), record.size())) {
+      cerr << "Trace file " << file_name << " is truncated" << endl;
+      return INVALID_ARGUMENT;
+    }
+
+    out << "#" << header.first_keystroke + i << " positions";
+    for (int j = 0; j < rotors; j++) {
+      out << " ";
+      printLetter(out, alphabet_size, record[4 + 2 * rotors + j]);
+    }
+    out << ": ";
+
+    printLetter(out, alphabet_size, record[0]);
+    out << " plugboard ";
+    printLetter(out, alphabet_size, record[1]);
+    for (int j = 0; j < rotors; j++) {
+      out << " rotor " << (rotors - 1 - j) << " ";
+      printLetter(out, alphabet_size, record[2 + j]);
+    }
+    out << " reflector ";
+    printLetter(out, alphabet_size, record[2 + rotors]);
+    for (int j = 0; j < rotors; j++) {
+      out << " rotor " << j << " ";
+      printLetter(out, alphabet_size, record[3 + rotors + j]);
+    }
+    out << " plugboard ";
+    printLetter(out, alphabet_size, record[3 + 2 * rotors]);
+    out << endl;
+  }
+
+  return NO_ERROR;
+}
+
+void Tracer::printLetter(ostream& out, int alphabet_size, int letter)
+{
+  if (alphabet_size == ALPHABET_LENGTH) {
+    out << static_cast<char>(ASCII_A + letter);
+  } else {
+    out << letter;
+  }
+}
@@ -0,0 +1,76 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+/* The Tracer class records the signal path of every keystroke coded by
+   an Enigma machine into a ring buffer in memory, keeping the most
+   recent keystrokes, and writes them to a binary trace file which
+   printTrace renders as text.
+   Recording is only compiled into the Enigma class when ENIGMA_TRACE is
+   defined (build with 'make TRACE=1'), so the default build has no
+   tracing code at all in its signal path. Reading trace files works in
+   every build.
+   Each record holds, as one byte per letter index:
+     the input letter, the letter after the plugboard,
+     the letter after each rotor on the way in, from the rightmost rotor
+     to the leftmost,
+     the letter after the reflector,
+     the letter after each rotor on the way out, from the leftmost rotor
+     to the rightmost,
+     the output letter after the plugboard and
+     the position of each rotor after stepping, from the leftmost rotor to
+     the rightmost.
+   The trace file is a header (see TraceHeader in 'Tracer.cpp') followed
+   by the records, oldest first.
+   alphabet_size_ and number_of_rotors_ describe the traced machine.
+   record_size_ is the number of bytes in a record.
+   records_ contains capacity_ records and next_record_ is the index of
+   the slot the next record goes in.
+   number_of_keystrokes_ is the number of keystrokes recorded so far,
+   including those which have since been overwritten. */
+
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+class Tracer
+{
+public:
+  /* Function to initialise Tracer object to keep the last capacity
+     keystrokes of a machine with the given alphabet and rotors. */
+  Tracer(int alphabet_size, int number_of_rotors,
+	 std::size_t capacity = TRACE_RING_RECORDS);
+
+  /* Function to return the slot for the next keystroke, overwriting the
+     oldest record once the buffer is full. The record layout is given
+     above; the caller fills in every byte. */
+  std::uint8_t* nextRecord();
+
+  /* Function to write the recorded keystrokes to the trace file named
+     file_name.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  int write(char const* file_name) const;
+
+  /* Function to read the trace file named file_name and print one line
+     per keystroke to out.
+     The function returns an error code corresponding to those in
+     'errors.h' */
+  static int printTrace(char const* file_name, std::ostream& out);
+
+private:
+  int alphabet_size_;
+  int number_of_rotors_;
+  std::size_t record_size_;
+  std::size_t capacity_;
+  std::vector<std::uint8_t> records_;
+  std::size_t next_record_;
+  std::uint64_t number_of_keystrokes_;
+
+  /* Function to print a letter index as a letter for the 26 letter
+     alphabet and as a number otherwise. */
+  static void printLetter(std::ostream& out, int alphabet_size, int letter);
+};
+
+#endif
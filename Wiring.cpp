@@ -1,40 +1,145 @@
 /* This file contains the member function definitions 
-   for the Wiring class */
+   for the Wiring class template */
 
 #include "Wiring.hpp"
 #include "constants.h"
+#include <cstdint>
+#include <cstring>
 
 using namespace std;
 
-Wiring::Wiring()
+template <int ALPHABET_SIZE>
+BasicWiring<ALPHABET_SIZE>::BasicWiring()
 {
-  for (int i = 0; i < ALPHABET_LENGTH; i++){
-    mapping_[i] = i;
+  for (int i = 0; i < ALPHABET_SIZE; i++){
+    mapping_[i] = static_cast<uint8_t>(i);
   }
 }
 
-void Wiring::setUp(int const wires_to_swap[ALPHABET_LENGTH])
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setUp(int const wires_to_swap[ALPHABET_SIZE])
 {
-  for (int i = 0; i < ALPHABET_LENGTH; i++){
-    mapping_[i] = wires_to_swap[i];
+  for (int i = 0; i < ALPHABET_SIZE; i++){
+    mapping_[i] = static_cast<uint8_t>(wires_to_swap[i]);
   }
 }
 
-void Wiring::setUp(int const wires_to_swap[][2], int size)
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setUp(int const wires_to_swap[][2], int size)
 {
   for (int i = 0; i < size; i++){
-    mapping_[wires_to_swap[i][0]] = wires_to_swap[i][1];
-    mapping_[wires_to_swap[i][1]] = wires_to_swap[i][0];
+    mapping_[wires_to_swap[i][0]] = static_cast<uint8_t>(wires_to_swap[i][1]);
+    mapping_[wires_to_swap[i][1]] = static_cast<uint8_t>(wires_to_swap[i][0]);
   }
 }
 
-int Wiring::getOutputLetter(int input_letter) const
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setUp(uint8_t const mapping[ALPHABET_SIZE])
+{
+  for (int i = 0; i < ALPHABET_SIZE; i++){
+    mapping_[i] = mapping[i];
+  }
+}
+
+template <int ALPHABET_SIZE>
+int BasicWiring<ALPHABET_SIZE>::getOutputLetter(int input_letter) const
 {
   return mapping_[input_letter];
 }
 
-void Wiring::setOutputLetter(int input_letter, int output_letter)
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setOutputLetter(int input_letter,
+						 int output_letter)
+{
+  mapping_[input_letter] = static_cast<uint8_t>(output_letter);
+}
+
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setComposition(BasicWiring const& first,
+						BasicWiring const& second)
 {
-  mapping_[input_letter] = output_letter;
+  uint8_t composition[ALPHABET_SIZE];
+  for (int i = 0; i < ALPHABET_SIZE; i++) {
+    composition[i] = second.mapping_[first.mapping_[i]];
+  }
+  memcpy(mapping_, composition, ALPHABET_SIZE);
+}
+
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setInverse(BasicWiring const& wiring)
+{
+  uint8_t inverse[ALPHABET_SIZE];
+  for (int i = 0; i < ALPHABET_SIZE; i++) {
+    inverse[wiring.mapping_[i]] = static_cast<uint8_t>(i);
+  }
+  memcpy(mapping_, inverse, ALPHABET_SIZE);
+}
+
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setShifted(BasicWiring const& wiring,
+					    int shift)
+{
+  shift %= ALPHABET_SIZE;
+  if (shift < 0) {
+    shift += ALPHABET_SIZE;
+  }
+
+  uint8_t shifted[ALPHABET_SIZE];
+  for (int i = 0; i < ALPHABET_SIZE; i++) {
+    int output_letter = wiring.mapping_[(i + shift) % ALPHABET_SIZE];
+    shifted[i] = static_cast<uint8_t>((output_letter - shift + ALPHABET_SIZE)
+				      % ALPHABET_SIZE);
+  }
+  memcpy(mapping_, shifted, ALPHABET_SIZE);
+}
+
+template <int ALPHABET_SIZE>
+void BasicWiring<ALPHABET_SIZE>::setPower(BasicWiring const& wiring,
+					  long exponent)
+{
+  // Each letter moves exponent steps round its own cycle, so the exponent
+  // is taken modulo the length of each cycle. This also keeps negative
+  // exponents, even the most negative long, clear of overflow.
+  uint8_t letters[ALPHABET_SIZE];
+  int cycle_lengths[ALPHABET_SIZE];
+  int number_of_cycles = wiring.getCycles(letters, cycle_lengths);
+
+  uint8_t power[ALPHABET_SIZE];
+  uint8_t const* cycle = letters;
+  for (int i = 0; i < number_of_cycles; i++) {
+    long length = cycle_lengths[i];
+    long steps = (exponent % length + length) % length;
+    for (long j = 0; j < length; j++) {
+      power[cycle[j]] = cycle[(j + steps) % length];
+    }
+    cycle += length;
+  }
+  memcpy(mapping_, power, ALPHABET_SIZE);
+}
+
+template <int ALPHABET_SIZE>
+int BasicWiring<ALPHABET_SIZE>::getCycles(uint8_t* letters,
+					  int* cycle_lengths) const
+{
+  bool is_visited[ALPHABET_SIZE] = {};
+  int number_of_cycles = 0;
+  int number_of_letters = 0;
+  for (int start = 0; start < ALPHABET_SIZE; start++) {
+    if (is_visited[start]) {
+      continue;
+    }
+    int length = 0;
+    int letter = start;
+    do {
+      is_visited[letter] = true;
+      letters[number_of_letters++] = static_cast<uint8_t>(letter);
+      length++;
+      letter = mapping_[letter];
+    } while (letter != start);
+    cycle_lengths[number_of_cycles++] = length;
+  }
+  return number_of_cycles;
 }
 
+template class BasicWiring<ALPHABET_LENGTH>;
+template class BasicWiring<BYTE_ALPHABET_LENGTH>;
@@ -1,39 +1,53 @@
 #ifndef WIRING_H
 #define WIRING_H
 
-/* The wiring class contains an integer array with 26 elements. 
-   The elements contain the numbers 0 to 25 corresponding to 
-   the zero-based indices into the alphabet.
+/* The wiring class template contains a byte array with ALPHABET_SIZE
+   elements. The elements contain the numbers 0 to ALPHABET_SIZE - 1
+   corresponding to the zero-based indices into the alphabet, which fit
+   in a byte for both alphabets, so a 26 letter wiring takes 26 bytes.
    The element index represents the input letter.
    The integer contained in the element represents the output 
-   letter. */
+   letter.
+   A wiring is a permutation of the alphabet, and whole wirings can be
+   combined with the operations of permutations: composed, inverted,
+   turned like a rotor and raised to powers, and split into cycles. Each
+   operation is a plain loop over the letters, for both alphabets.
+   Wiring is the 26 letter wiring used by the classic machine and
+   ByteWiring is the 256 symbol wiring used to code binary data. */
 
 #include "constants.h"
+#include <cstdint>
 
-class Wiring
+template <int ALPHABET_SIZE>
+class BasicWiring
 {
 public:
   /* Function to initialise Wiring object to have
      all letters map to themselves. */
-  Wiring();
+  BasicWiring();
   
   /* Function to set up Wiring object with
      letters mapping to those given in the input array. 
      To use when setting up rotors. 
-     The input array must contain every number from 0 to 25
-     exactly once. The position of the number in the array
-     corresponds the input letter index and the number itself
+     The input array must contain every number from 0 to
+     ALPHABET_SIZE - 1 exactly once. The position of the number in the
+     array corresponds the input letter index and the number itself
      corresponds to the output letter index. */
-  void setUp(int const wires_to_swap[ALPHABET_LENGTH]);
+  void setUp(int const wires_to_swap[ALPHABET_SIZE]);
 
   /* Function to set up Wiring object with
      letters mapping to those given in the input array.
      To use when setting up plugboards and reflectors. 
      The input array must contain distinct numbers from 
-     0 to 25. Each row contains a pair of numbers
+     0 to ALPHABET_SIZE - 1. Each row contains a pair of numbers
      which will be mapped to eachother. */
   void setUp(int const wires_to_swap[][2], int size);
 
+  /* Function to set up Wiring object by copying a mapping which has
+     already been checked, such as one from the built-in catalog.
+     mapping must hold ALPHABET_SIZE output letter indices. */
+  void setUp(std::uint8_t const mapping[ALPHABET_SIZE]);
+
   /* Function to return the output letter index that the 
      input letter index maps to. */
   int getOutputLetter(int input_letter) const;
@@ -41,10 +55,42 @@ public:
   /* Function to set the output letter index that the 
      input letter index maps to. */
   void setOutputLetter(int input_letter, int output_letter);
-  
+
+  /* Function to set the wiring to map each letter through first and then
+     through second. Either may be this wiring. */
+  void setComposition(BasicWiring const& first, BasicWiring const& second);
+
+  /* Function to set the wiring to the inverse of wiring, which maps each
+     output letter of wiring back to its input letter. wiring may be this
+     wiring. */
+  void setInverse(BasicWiring const& wiring);
+
+  /* Function to set the wiring to wiring turned shift letters, as a rotor
+     with that wiring at position shift, so each letter is offset by shift
+     on the way in and back on the way out. shift is taken modulo
+     ALPHABET_SIZE and wiring may be this wiring. */
+  void setShifted(BasicWiring const& wiring, int shift);
+
+  /* Function to set the wiring to wiring applied exponent times in turn.
+     A negative exponent applies the inverse of wiring, and an exponent of
+     0 gives the wiring mapping every letter to itself. wiring may be this
+     wiring. */
+  void setPower(BasicWiring const& wiring, long exponent);
+
+  /* Function to split the wiring into its cycles, each the letters
+     visited from a letter until it maps back to it. letters is filled
+     with the letters of the cycles one after another, each starting from
+     its smallest letter, in order of those letters, and cycle_lengths with
+     the length of each cycle in the same order; both must have room for
+     ALPHABET_SIZE elements. Returns the number of cycles. */
+  int getCycles(std::uint8_t* letters, int* cycle_lengths) const;
+
 private:
-  int mapping_[ALPHABET_LENGTH];
+  std::uint8_t mapping_[ALPHABET_SIZE];
 
 };
 
+typedef BasicWiring<ALPHABET_LENGTH> Wiring;
+typedef BasicWiring<BYTE_ALPHABET_LENGTH> ByteWiring;
+
 #endif
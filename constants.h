@@ -1,8 +1,22 @@
 /* Constants */
 #define ALPHABET_LENGTH  26
+#define BYTE_ALPHABET_LENGTH 256
 #define ASCII_ZERO       48
 #define ASCII_NINE       57
 #define ASCII_A          65
 #define ASCII_Z          90
 #define A_INDEX          0
 #define Z_INDEX          25
+#define CACHE_LINE_SIZE  64
+#define BLOCK_SIZE       65536
+#define PIPELINE_DEPTH   8
+#define COMPOSITION_TREE_MIN_ROTORS 8
+#define SCORE_BLOCK_LENGTH 16
+#define CRIB_INDEX_KEYSTROKES 10
+#define INDICATOR_LENGTH 6
+#define TRACE_RING_RECORDS 65536
+#define CURSOR_INLINE_ROTORS 16
+#define SIMD_BLOCK_LENGTH 32
+#define WATCH_SETTLE_MILLISECONDS 100
+#define SEARCH_CHECKPOINT_INTERVAL 65536
+#define SEARCH_KEEP 10
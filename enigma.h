@@ -0,0 +1,90 @@
+#ifndef ENIGMA_C_H
+#define ENIGMA_C_H
+
+/* C interface to the Enigma machine, for programs which link libenigma
+   instead of running the enigma executable.
+   A machine is created from settings held in memory, which use the same
+   layout as the plugboard, reflector, rotor and rotor position files.
+   Every function which can fail returns an error code corresponding to
+   those in 'errors.h', with NO_ERROR on success and INVALID_ARGUMENT for
+   null pointers or settings which do not fit the machine, and
+   OUT_OF_MEMORY if a machine cannot be allocated. Descriptions
+   of configuration errors are written to standard error, as they are by
+   the enigma executable.
+   A machine must not be used by more than one thread at a time.
+   Only the functions declared here, marked ENIGMA_API, are exported from
+   libenigma.so. */
+
+#include "errors.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* Version of the interface, raised whenever it changes incompatibly. */
+#define ENIGMA_API_VERSION 1
+
+/* Alphabets a machine can code: the upper case letters A-Z, or every
+   byte value. */
+#define ENIGMA_LETTERS 26
+#define ENIGMA_BYTES   256
+
+/* Marks the functions exported from the shared library, which is built
+   with every other symbol hidden. */
+#define ENIGMA_API __attribute__((visibility("default")))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct enigma_machine enigma_machine;
+
+/* Function to create a machine and store it in *machine.
+   alphabet_size is ENIGMA_LETTERS or ENIGMA_BYTES.
+   plugboard, reflector and positions are null-terminated strings holding
+   the plugboard, reflector and rotor position settings.
+   rotors points to number_of_rotors strings holding the rotor settings,
+   from the leftmost rotor to the rightmost. */
+ENIGMA_API int enigma_create(int alphabet_size, char const* plugboard,
+			     char const* reflector, char const* const* rotors,
+			     int number_of_rotors, char const* positions,
+			     enigma_machine** machine);
+
+/* Function to encode or decode length symbols from input into output,
+   which may be the same buffer. For ENIGMA_LETTERS every input symbol
+   must be an upper case letter; coding stops at the first one which is
+   not, returning INVALID_INPUT_CHARACTER with the symbols before it
+   coded. */
+ENIGMA_API int enigma_code(enigma_machine* machine, char const* input,
+			   char* output, size_t length);
+
+/* Function to move the machine to the state it is in after keystroke
+   symbols have been coded from its starting positions. Seeking forwards
+   takes time proportional to the distance moved; seeking backwards
+   starts again from the starting positions. */
+ENIGMA_API int enigma_seek(enigma_machine* machine, uint64_t keystroke);
+
+/* Function to return the number of symbols coded since the starting
+   positions, allowing for seeks and restored states. */
+ENIGMA_API uint64_t enigma_tell(enigma_machine const* machine);
+
+/* Function to return the number of bytes needed to hold a snapshot of
+   the state of the machine. */
+ENIGMA_API size_t enigma_state_size(enigma_machine const* machine);
+
+/* Function to copy the state of the machine into state, which must hold
+   enigma_state_size bytes. */
+ENIGMA_API int enigma_save_state(enigma_machine const* machine,
+				 void* state);
+
+/* Function to return the machine to a state saved by enigma_save_state
+   from a machine with the same number of rotors and alphabet. */
+ENIGMA_API int enigma_restore_state(enigma_machine* machine,
+				    void const* state);
+
+/* Function to free the machine. machine may be null. */
+ENIGMA_API void enigma_destroy(enigma_machine* machine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,4 +10,7 @@
 #define INVALID_REFLECTOR_MAPPING                 9
 #define INCORRECT_NUMBER_OF_REFLECTOR_PARAMETERS  10
 #define ERROR_OPENING_CONFIGURATION_FILE          11
+#define INVALID_ARGUMENT                          12
+#define OUT_OF_MEMORY                             13
+#define ERROR_READING_OR_WRITING_FILE             14
 #define NO_ERROR                                  0
@@ -1,39 +1,1070 @@
 #include "Enigma.hpp"
+#include "Analyzer.hpp"
+#include "Pipeline.hpp"
+#include "Profiler.hpp"
+#include "CribIndex.hpp"
+#include "CribFilter.hpp"
+#include "CycleCatalog.hpp"
+#include "Catalog.hpp"
+#include "KeySheet.hpp"
+#include "EnigmaSpec.hpp"
+#include "EnigmaCursor.hpp"
+#include "SpecWatcher.hpp"
+#include "FileCoder.hpp"
+#include "KeySearch.hpp"
+#include "Tracer.hpp"
+#include "TableMemory.hpp"
 #include "errors.h"
 #include "constants.h"
 #include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
-int main(int argc, char** argv)
+/* Function to print the command line usage. */
+void printUsage()
+{
+  cerr << "usage: enigma [--bytes] [--pipeline | --profile[=json]]";
+  cerr << " [--trace=trace-file] [--engine=name]" << endl;
+  cerr << "              [--rings=ring-settings] [--double-step]";
+  cerr << " [--max-table-mem=size]" << endl;
+  cerr << "              plugboard-file reflector-file (<rotor-file>)*";
+  cerr << " rotor-positions" << endl;
+  cerr << "       enigma analyze [--bytes] [--rings=ring-settings]";
+  cerr << " [--double-step]" << endl;
+  cerr << "              plugboard-file reflector-file (<rotor-file>)*";
+  cerr << " rotor-positions" << endl;
+  cerr << "       enigma watch [--rings=ring-settings] [--double-step]";
+  cerr << endl;
+  cerr << "              plugboard-file reflector-file (<rotor-file>)*";
+  cerr << " rotor-positions" << endl;
+  cerr << "       enigma recode [--bytes] [--engine=name]";
+  cerr << " [--rings=ring-settings] [--double-step]" << endl;
+  cerr << "              plugboard-file reflector-file (<rotor-file>)*";
+  cerr << " rotor-positions < file-list" << endl;
+  cerr << "       enigma crib-index build [--keystrokes=N] index-file";
+  cerr << " plugboard-file reflector-file (<rotor-file>)*" << endl;
+  cerr << "       enigma crib-index find index-file plaintext ciphertext";
+  cerr << endl;
+  cerr << "       enigma crib-drag [--count] ciphertext-file crib..." << endl;
+  cerr << "       enigma cycles build [--slots=N] [--threads=N]";
+  cerr << " [--double-step]" << endl;
+  cerr << "              catalog-file reflector-file (<rotor-file>)+";
+  cerr << endl;
+  cerr << "       enigma cycles find catalog-file";
+  cerr << " (indicator-file | lengths lengths lengths)" << endl;
+  cerr << "       enigma [options] --key=NET:YYYY-MM-DD compiled-key-sheet";
+  cerr << endl;
+  cerr << "       enigma key-sheet build [--bytes] key-sheet";
+  cerr << " compiled-key-sheet" << endl;
+  cerr << "       enigma search split [--units=N] [--slots=N]";
+  cerr << " [--reflectors=N] [--keep=N]" << endl;
+  cerr << "              unit-prefix ciphertext-file plugboard-file";
+  cerr << " (<reflector-file>)+ (<rotor-file>)+" << endl;
+  cerr << "       enigma search run unit-file" << endl;
+  cerr << "       enigma search merge [--keep=N] checkpoint-file..." << endl;
+  cerr << "       enigma trace trace-file" << endl;
+  cerr << "       enigma bench [--bytes] [--profile[=json]] [--length=N]";
+  cerr << " [--engine=name]" << endl;
+  cerr << "              plugboard-file reflector-file (<rotor-file>)*";
+  cerr << " rotor-positions" << endl;
+  cerr << "engines: auto";
+  for (int engine = 0; engine < NUMBER_OF_ENGINES; engine++) {
+    cerr << ", " << Enigma::getEngineName(engine);
+  }
+  cerr << endl;
+  cerr << "any letter configuration file may be given as builtin:NAME";
+  cerr << endl;
+}
+
+/* Function to return the engine named name, ENGINE_AUTO for "auto" or
+   NUMBER_OF_ENGINES if there is no such engine. */
+int findEngine(char const* name)
+{
+  if (strcmp(name, "auto") == 0) {
+    return ENGINE_AUTO;
+  }
+  int engine = 0;
+  while (engine < NUMBER_OF_ENGINES
+	 && strcmp(name, Enigma::getEngineName(engine)) != 0) {
+    engine++;
+  }
+  return engine;
+}
+
+/* Function to read a number of bytes from text, which may end in K, M
+   or G for that many kibibytes, mebibytes or gibibytes, into size.
+   Returns false if text is not such a number. */
+bool parseMemorySize(char const* text, size_t& size)
+{
+  if (!isdigit(static_cast<unsigned char>(*text))) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  unsigned long long number = strtoull(text, &end, 10);
+  if (errno != 0) {
+    return false;
+  }
+
+  int shift = 0;
+  if (*end == 'K' || *end == 'k') {
+    shift = 10;
+  } else if (*end == 'M' || *end == 'm') {
+    shift = 20;
+  } else if (*end == 'G' || *end == 'g') {
+    shift = 30;
+  }
+  if (shift > 0) {
+    end++;
+  }
+  if (*end != '\0' || number > (SIZE_MAX >> shift)) {
+    return false;
+  }
+
+  size = static_cast<size_t>(number) << shift;
+  return true;
+}
+
+/* Function to return the size of standard input if it is a regular file,
+   or 0 if its length is not known in advance. */
+uint64_t getInputLength()
 {
-  if (argc < 4) {
-    cerr << "usage: enigma plugboard-file reflector-file (<rotor-file>)*";
-    cerr << " rotor-positions" << endl;
+  struct stat status;
+  if (fstat(STDIN_FILENO, &status) != 0 || !S_ISREG(status.st_mode)) {
+    return 0;
+  }
+  return status.st_size;
+}
+
+/* Function to set up enigma from the configuration files like
+   Enigma::setUp, then choose engine for expected_length symbols (see
+   Enigma::setEngine). If key is not nullptr the only configuration file
+   is a compiled key sheet and enigma is set up with the key named key
+   from it instead. If ring_file_name is not nullptr the ring settings
+   are read from it, and is_double_stepping chooses the stepping (see
+   Enigma::setDoubleStepping).
+   The function returns an error code corresponding to those in 'errors.h' */
+template <int ALPHABET_SIZE>
+int setUpEnigma(BasicEnigma<ALPHABET_SIZE>& enigma, int number_of_files,
+		char** configuration_files, char const* key,
+		char const* ring_file_name, bool is_double_stepping,
+		int engine, uint64_t expected_length,
+		Profiler* profiler = nullptr)
+{
+  enigma.setDoubleStepping(is_double_stepping);
+  int error_code;
+  if (key != nullptr) {
+    KeySheet key_sheet;
+    error_code = key_sheet.setUp(configuration_files[0]);
+    if (error_code == NO_ERROR) {
+      error_code = key_sheet.setUpEnigma(key, enigma, profiler);
+    }
+  } else {
+    error_code = enigma.setUp(number_of_files, configuration_files,
+			      profiler);
+  }
+  if (error_code == NO_ERROR && ring_file_name != nullptr) {
+    error_code = enigma.setUpRingSettings(ring_file_name);
+  }
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+  if (engine == ENGINE_AUTO && expected_length == 0) {
+    return NO_ERROR;
+  }
+  return enigma.setEngine(engine, expected_length);
+}
+
+/* Function to write the totals of profiler to out, as JSON if is_json is
+   set and as a table otherwise. */
+void printProfile(Profiler const& profiler, bool is_json, ostream& out)
+{
+  if (is_json) {
+    profiler.printJson(out);
+  } else {
+    profiler.printTable(out);
+  }
+}
+
+/* Function to run the 'analyze' command, which reports the stepping
+   period and carry points of a configuration without encoding anything.
+   argc and argv are the configuration file arguments, and ring_file_name
+   and is_double_stepping are as for setUpEnigma. */
+template <int ALPHABET_SIZE>
+int analyze(int argc, char** argv, char const* ring_file_name,
+	    bool is_double_stepping)
+{
+  auto enigma = BasicEnigma<ALPHABET_SIZE>();
+  int error_code = setUpEnigma(enigma, argc, argv, nullptr, ring_file_name,
+			       is_double_stepping, ENGINE_AUTO, 0);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  BasicAnalyzer<ALPHABET_SIZE> analyzer(enigma);
+  analyzer.printReport(cout, argv + 2);
+
+  return NO_ERROR;
+}
+
+/* Function to run the 'bench' command, which codes length pseudo-random
+   symbols held in memory and reports the throughput, so the cost of the
+   machine can be measured without any input or output.
+   If profiler is not nullptr the setup, stepping and signal path are
+   recorded in it.
+   argc and argv are the configuration file arguments, and key,
+   ring_file_name, is_double_stepping and engine are as for
+   setUpEnigma. */
+template <int ALPHABET_SIZE>
+int benchmark(int argc, char** argv, char const* key,
+	      char const* ring_file_name, bool is_double_stepping,
+	      long length, int engine, Profiler* profiler)
+{
+  auto enigma = BasicEnigma<ALPHABET_SIZE>();
+  int error_code = setUpEnigma(enigma, argc, argv, key, ring_file_name,
+			       is_double_stepping, engine, length, profiler);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  // A fixed xorshift sequence, so every run codes the same input.
+  vector<char> symbols(length);
+  uint32_t state = 2463534242u;
+  for (long i = 0; i < length; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    symbols[i] = static_cast<char>(BasicEnigma<ALPHABET_SIZE>::FIRST_SYMBOL
+				   + state % ALPHABET_SIZE);
+  }
+
+  timespec start, finish;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (profiler != nullptr) {
+    for (long i = 0; i < length; i++) {
+      symbols[i] = enigma.codeProfiled(symbols[i], *profiler);
+    }
+  } else {
+    enigma.codeBlock(symbols.data(), length);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &finish);
+
+  double seconds = (finish.tv_sec - start.tv_sec)
+    + (finish.tv_nsec - start.tv_nsec) / 1e9;
+  cout << "Coded " << length << " symbols in " << seconds << " s (";
+  cout << ((seconds > 0) ? length / seconds / 1e6 : 0.0);
+  cout << " million symbols per second) with the ";
+  cout << BasicEnigma<ALPHABET_SIZE>::getEngineName(enigma.getEngine());
+  cout << " engine" << endl;
+
+  return NO_ERROR;
+}
+
+/* Function to run the 'crib-index build' command, which writes the crib
+   index for a plugboard, reflector and rotor order. argc and argv are
+   the arguments after 'build'. No rotor position file is needed because
+   every starting position is indexed.
+   The function returns an error code corresponding to those in 'errors.h' */
+int buildCribIndex(int argc, char** argv)
+{
+  int number_of_keystrokes = CRIB_INDEX_KEYSTROKES;
+  if (argc > 0 && strncmp(argv[0], "--keystrokes=", 13) == 0) {
+    number_of_keystrokes = atoi(argv[0] + 13);
+    argc--;
+    argv++;
+  }
+  if (argc < 3 || number_of_keystrokes <= 0) {
+    printUsage();
     return INSUFFICIENT_NUMBER_OF_PARAMETERS;
   }
-    
+
+  char const* index_file_name = argv[0];
+  int number_of_files = argc - 1;
+  char** configuration_files = argv + 1;
+  int number_of_rotors = number_of_files - 2;
+
+  // Built-in components are written out as the text of their files.
+  vector<ifstream> files(number_of_files);
+  vector<stringstream> builtins(number_of_files);
+  vector<istream*> settings;
+  vector<char const*> setting_names;
+  for (int i = 0; i < number_of_files; i++) {
+    if (isBuiltinName(configuration_files[i])) {
+      if (!writeBuiltinSetting(min(i, SETTING_ROTOR), configuration_files[i],
+			       builtins[i])) {
+	builtins[i].setstate(ios::failbit);
+      }
+      settings.push_back(&builtins[i]);
+    } else {
+      files[i].open(configuration_files[i]);
+      settings.push_back(&files[i]);
+    }
+    setting_names.push_back(configuration_files[i]);
+  }
+
+  string zero_positions;
+  for (int i = 0; i < number_of_rotors; i++) {
+    zero_positions += "0 ";
+  }
+  istringstream positions(zero_positions);
+  settings.push_back(&positions);
+  setting_names.push_back("starting positions");
+
   auto enigma = Enigma();
-  int error_code = enigma.setUp(argc - 1, argv + 1);
+  int error_code = enigma.setUp(settings.size(), settings.data(),
+				setting_names.data());
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  return CribIndex::write(enigma, number_of_keystrokes, index_file_name);
+}
+
+/* Function to run the 'key-sheet build' command, which compiles a text
+   key sheet. argc and argv are the arguments after 'build'.
+   The function returns an error code corresponding to those in 'errors.h' */
+int buildKeySheet(int argc, char** argv)
+{
+  int alphabet_size = ALPHABET_LENGTH;
+  if (argc > 0 && strcmp(argv[0], "--bytes") == 0) {
+    alphabet_size = BYTE_ALPHABET_LENGTH;
+    argc--;
+    argv++;
+  }
+  if (argc != 2) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  return KeySheet::write(argv[0], alphabet_size, argv[1]);
+}
+
+/* Function to run the 'search split' command, which describes a key
+   search and writes it out as work units. argc and argv are the
+   arguments after 'split'.
+   The function returns an error code corresponding to those in 'errors.h' */
+int splitKeySearch(int argc, char** argv)
+{
+  int number_of_units = 1;
+  int number_of_slots = 3;
+  int number_of_reflectors = 1;
+  int number_to_keep = SEARCH_KEEP;
+  for (; argc > 0 && strncmp(argv[0], "--", 2) == 0; argc--, argv++) {
+    if (strncmp(argv[0], "--units=", 8) == 0) {
+      number_of_units = atoi(argv[0] + 8);
+    } else if (strncmp(argv[0], "--slots=", 8) == 0) {
+      number_of_slots = atoi(argv[0] + 8);
+    } else if (strncmp(argv[0], "--reflectors=", 13) == 0) {
+      number_of_reflectors = atoi(argv[0] + 13);
+    } else if (strncmp(argv[0], "--keep=", 7) == 0) {
+      number_to_keep = atoi(argv[0] + 7);
+    } else {
+      cerr << "Unknown option " << argv[0] << endl;
+      printUsage();
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+  }
+  if (number_of_reflectors < 1 || argc < 4 + number_of_reflectors) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  KeySearch search;
+  int error_code = search.setUp(argv[1], argv[2], number_of_reflectors,
+				argv + 3, argc - 3 - number_of_reflectors,
+				argv + 3 + number_of_reflectors,
+				number_of_slots, number_to_keep);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+  return search.split(number_of_units, argv[0], cout);
+}
+
+/* Function to run the 'search merge' command, which prints the best
+   candidates found by the units whose checkpoint files are named in
+   argv. argc and argv are the arguments after 'merge'.
+   The function returns an error code corresponding to those in 'errors.h' */
+int mergeKeySearch(int argc, char** argv)
+{
+  int number_to_keep = SEARCH_KEEP;
+  if (argc > 0 && strncmp(argv[0], "--keep=", 7) == 0) {
+    number_to_keep = atoi(argv[0] + 7);
+    argc--;
+    argv++;
+  }
+  if (argc < 1 || number_to_keep < 1) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  return KeySearch::merge(argc, argv, number_to_keep, cout);
+}
+
+/* Function to run the 'crib-index find' command, which prints every
+   starting position consistent with a crib, one per line in the layout
+   of a rotor position file. argc and argv are the arguments after
+   'find'.
+   The function returns an error code corresponding to those in 'errors.h' */
+int findCribPositions(int argc, char** argv)
+{
+  if (argc != 3) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  CribIndex index;
+  int error_code = index.setUp(argv[0]);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  vector<uint32_t> positions;
+  error_code = index.findPositions(argv[1], argv[2], positions);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  vector<int> rotor_positions(index.getNumberOfRotors());
+  for (size_t i = 0; i < positions.size(); i++) {
+    index.getRotorPositions(positions[i], rotor_positions.data());
+    for (size_t j = 0; j < rotor_positions.size(); j++) {
+      cout << ((j == 0) ? "" : " ") << rotor_positions[j];
+    }
+    cout << endl;
+  }
+
+  return NO_ERROR;
+}
+
+/* Function to run the 'cycles build' command, which builds the cycle
+   catalog for a reflector and set of rotors. argc and argv are the
+   arguments after 'build'.
+   The function returns an error code corresponding to those in 'errors.h' */
+int buildCycleCatalog(int argc, char** argv)
+{
+  int number_of_slots = 3;
+  int number_of_threads = max(1u, thread::hardware_concurrency());
+  bool is_double_stepping = false;
+  for (; argc > 0 && strncmp(argv[0], "--", 2) == 0; argc--, argv++) {
+    if (strncmp(argv[0], "--slots=", 8) == 0) {
+      number_of_slots = atoi(argv[0] + 8);
+    } else if (strncmp(argv[0], "--threads=", 10) == 0) {
+      number_of_threads = atoi(argv[0] + 10);
+    } else if (strcmp(argv[0], "--double-step") == 0) {
+      is_double_stepping = true;
+    } else {
+      cerr << "Unknown option " << argv[0] << endl;
+      printUsage();
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+  }
+  if (argc < 3) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  return CycleCatalog::write(argv[1], argc - 2, argv + 2, number_of_slots,
+			     is_double_stepping, number_of_threads, argv[0]);
+}
+
+/* Function to run the 'cycles find' command, which prints every setting
+   in a cycle catalog with the signature of a day's indicators, or of the
+   cycle lengths given, one per line as ROTOR... | POSITION... in the
+   layout of the rotor position file. argc and argv are the arguments
+   after 'find'.
+   The function returns an error code corresponding to those in 'errors.h' */
+int findCycleSettings(int argc, char** argv)
+{
+  if (argc != 2 && argc != 1 + INDICATOR_LENGTH / 2) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  CycleCatalog catalog;
+  int error_code = catalog.setUp(argv[0]);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  uint64_t signature;
+  error_code = (argc == 2) ? CycleCatalog::readIndicators(argv[1], signature)
+    : CycleCatalog::parseSignature(argv + 1, signature);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  vector<uint32_t> settings;
+  catalog.findSettings(signature, settings);
+  if (settings.empty()) {
+    cerr << "No setting has the cycle lengths ";
+    CycleCatalog::writeSignature(signature, cerr);
+    cerr << endl;
+  }
+
+  int number_of_slots = catalog.getNumberOfSlots();
+  vector<int> rotor_indices(number_of_slots);
+  vector<int> positions(number_of_slots);
+  for (size_t i = 0; i < settings.size(); i++) {
+    if (!catalog.getSetting(settings[i], rotor_indices.data(),
+			    positions.data())) {
+      cerr << "Cycle catalog file " << argv[0] << " is corrupt" << endl;
+      return INVALID_ARGUMENT;
+    }
+    for (int j = 0; j < number_of_slots; j++) {
+      cout << catalog.getRotorName(rotor_indices[j]) << " ";
+    }
+    cout << "|";
+    for (int j = 0; j < number_of_slots; j++) {
+      cout << " " << positions[j];
+    }
+    cout << endl;
+  }
+
+  return NO_ERROR;
+}
+
+/* Function to run the 'crib-drag' command, which prints every offset in
+   a ciphertext file at which one of the cribs could start, one per line
+   as OFFSET CRIB in ascending order of offset, or with --count only the
+   number of offsets left for each crib. argc and argv are the arguments
+   after the command.
+   The function returns an error code corresponding to those in 'errors.h' */
+int dragCribs(int argc, char** argv)
+{
+  bool is_counting = (argc > 0 && strcmp(argv[0], "--count") == 0);
+  if (is_counting) {
+    argc--;
+    argv++;
+  }
+  if (argc < 2) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  CribFilter filter;
+  int error_code = filter.setUp(argv[0]);
+  for (int i = 1; i < argc && error_code == NO_ERROR; i++) {
+    error_code = filter.addCrib(argv[i]);
+  }
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+
+  // The ciphertext is filtered a block of offsets at a time, so the
+  // offsets left never need to be held all at once.
+  vector<CribOffset> offsets;
+  vector<uint64_t> counts(filter.getNumberOfCribs());
+  for (uint64_t first = 0; first < filter.getLength(); first += BLOCK_SIZE) {
+    uint64_t last = min<uint64_t>(first + BLOCK_SIZE, filter.getLength());
+    if (is_counting) {
+      filter.countOffsets(first, last, counts.data());
+      continue;
+    }
+    filter.findOffsets(first, last, offsets);
+    for (CribOffset const& offset : offsets) {
+      cout << offset.offset << ' ';
+      cout << filter.getCrib(offset.crib_index) << '\n';
+    }
+  }
+
+  if (is_counting) {
+    for (int i = 0; i < filter.getNumberOfCribs(); i++) {
+      cout << filter.getCrib(i) << ' ' << counts[i] << '\n';
+    }
+  }
+  cout.flush();
+
+  return NO_ERROR;
+}
+
+/* Function to report an input character which is not an upper case
+   letter. */
+void printInvalidCharacter(char next)
+{
+  cerr << next << " is not a valid input character (input characters must be";
+  cerr << " upper case letters A-Z)!" << endl;
+}
+
+/* Function to code upper case letters read from standard input and write
+   them to standard output. Whitespace in the input is skipped.
+   Standard input is read with the read system call, which returns as
+   soon as a line has been typed at a terminal, so the machine can still
+   be used interactively.
+   The function returns an error code corresponding to those in 'errors.h' */
+int codeLetters(Enigma& enigma)
+{
+  static char buffer[BLOCK_SIZE];
+  ssize_t length;
+  while ((length = read(STDIN_FILENO, buffer, BLOCK_SIZE)) != 0) {
+    if (length < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      break;
+    }
+
+    // The letters are gathered first so that they can be coded as a block.
+    // The letters before an invalid character are still written out.
+    ssize_t letters_length = 0;
+    ssize_t i = 0;
+    for (; i < length; i++) {
+      char next = buffer[i];
+      if (isspace(static_cast<unsigned char>(next))) {
+	continue;
+      }
+      if (next < ASCII_A || next > ASCII_Z) {
+	break;
+      }
+      buffer[letters_length++] = next;
+    }
+    char next = (i < length) ? buffer[i] : 0;
+
+    enigma.codeBlock(buffer, letters_length);
+    cout.write(buffer, letters_length);
+    cout.flush();
+    if (i < length) {
+      printInvalidCharacter(next);
+      return INVALID_INPUT_CHARACTER;
+    }
+  }
+
+  return NO_ERROR;
+}
+
+/* Function to code every byte read from standard input and write the
+   result to standard output. Every byte value is a valid input.
+   The function returns an error code corresponding to those in 'errors.h' */
+int codeBytes(ByteEnigma& enigma)
+{
+  static char buffer[BLOCK_SIZE];
+  while (cin.read(buffer, BLOCK_SIZE) || cin.gcount() > 0) {
+    streamsize length = cin.gcount();
+    enigma.codeBlock(buffer, length);
+    cout.write(buffer, length);
+  }
+
+  return NO_ERROR;
+}
+
+/* Function to code standard input to standard output like codeLetters
+   and codeBytes, recording the reading and writing, the stepping and the
+   signal path as separate phases in profiler.
+   The function returns an error code corresponding to those in 'errors.h' */
+template <int ALPHABET_SIZE>
+int codeProfiled(BasicEnigma<ALPHABET_SIZE>& enigma, Profiler& profiler)
+{
+  static char buffer[BLOCK_SIZE];
+  int error_code = NO_ERROR;
+  while (error_code == NO_ERROR) {
+    profiler.begin(PROFILE_INPUT_OUTPUT);
+    bool is_read = cin.read(buffer, BLOCK_SIZE) || cin.gcount() > 0;
+    profiler.end(PROFILE_INPUT_OUTPUT);
+    if (!is_read) {
+      break;
+    }
+
+    streamsize length = cin.gcount();
+    streamsize coded_length = 0;
+    for (streamsize i = 0; i < length; i++) {
+      char next = buffer[i];
+      if (ALPHABET_SIZE == ALPHABET_LENGTH) {
+	if (isspace(static_cast<unsigned char>(next))) {
+	  continue;
+	}
+	if (next < ASCII_A || next > ASCII_Z) {
+	  printInvalidCharacter(next);
+	  error_code = INVALID_INPUT_CHARACTER;
+	  break;
+	}
+      }
+      buffer[coded_length++] = enigma.codeProfiled(next, profiler);
+    }
+
+    profiler.begin(PROFILE_INPUT_OUTPUT);
+    cout.write(buffer, coded_length);
+    cout.flush();
+    profiler.end(PROFILE_INPUT_OUTPUT);
+  }
+
+  return error_code;
+}
+
+/* Function to code standard input to standard output with code,
+   recording every keystroke in the trace file named trace_file_name
+   unless it is nullptr. Tracing is only possible in builds with
+   ENIGMA_TRACE defined.
+   The function returns an error code corresponding to those in 'errors.h' */
+template <int ALPHABET_SIZE>
+int codeTraced(BasicEnigma<ALPHABET_SIZE>& enigma,
+	       int (*code)(BasicEnigma<ALPHABET_SIZE>&),
+	       char const* trace_file_name)
+{
+#ifdef ENIGMA_TRACE
+  if (trace_file_name != nullptr) {
+    Tracer tracer(ALPHABET_SIZE, enigma.getNumberOfRotors());
+    enigma.setTracer(&tracer);
+    int error_code = code(enigma);
+    enigma.setTracer(nullptr);
+
+    int trace_error = tracer.write(trace_file_name);
+    return (error_code != NO_ERROR) ? error_code : trace_error;
+  }
+#else
+  (void) trace_file_name;
+#endif
+  return code(enigma);
+}
+
+/* Function to code standard input to standard output with separate
+   reader, encoder and writer threads.
+   The function returns an error code corresponding to those in 'errors.h' */
+template <int ALPHABET_SIZE>
+int codePipelined(BasicEnigma<ALPHABET_SIZE>& enigma)
+{
+  BasicPipeline<ALPHABET_SIZE> pipeline(enigma, STDIN_FILENO, STDOUT_FILENO);
+  int error_code = pipeline.run();
+  if (error_code == INVALID_INPUT_CHARACTER) {
+    printInvalidCharacter(pipeline.getInvalidCharacter());
+  }
+  return error_code;
+}
+
+/* Function to run the 'watch' command, which codes each line of standard
+   input as a separate message from the rotor positions in the position
+   file, writing one line of output for each, and keeps coding with the
+   configuration files as they change. A message is coded with the
+   configuration that was current when its line was read, so a key
+   change never splits a message. Whitespace within a line is skipped.
+   argc and argv are the configuration file arguments, and ring_file_name
+   and is_double_stepping are as for setUpEnigma. */
+int watchConfiguration(int argc, char** argv, char const* ring_file_name,
+		       bool is_double_stepping)
+{
+  SpecWatcher watcher;
+  int error_code = watcher.start(argc, argv, ring_file_name,
+				 is_double_stepping);
   if (error_code != NO_ERROR) {
     return error_code;
   }
 
-  char next;
-  cin >> ws;
-  cin.get(next);
-  while (next >= ASCII_A && next <= ASCII_Z && cin) {
-    cout << enigma.code(next);
-    cin >> ws;
-    cin.get(next);
+  string line;
+  while (getline(cin, line)) {
+    shared_ptr<EnigmaSpec const> spec = watcher.getSpec();
+    EnigmaCursor cursor(*spec);
+    string message;
+    for (char next : line) {
+      if (isspace(static_cast<unsigned char>(next))) {
+	continue;
+      }
+      if (next < ASCII_A || next > ASCII_Z) {
+	cout << message << endl;
+	printInvalidCharacter(next);
+	return INVALID_INPUT_CHARACTER;
+      }
+      message.push_back(cursor.code(next));
+    }
+    cout << message << endl;
   }
 
-  if (next < ASCII_A || next > ASCII_Z) {
-    cerr << next << " is not a valid input character (input characters must be";
-    cerr << " upper case letters A-Z)!" << endl;
-    return INVALID_INPUT_CHARACTER;
+  return NO_ERROR;
+}
+
+/* Function to run the 'recode' command, which reads lines naming an input
+   file and an output file from standard input and codes each input file
+   into its output file as a separate message from the rotor positions,
+   keeping several reads and writes in flight (see FileCoder). Coding
+   stops at the first file which fails. The arguments are as for
+   setUpEnigma.
+   The function returns an error code corresponding to those in 'errors.h' */
+template <int ALPHABET_SIZE>
+int recodeFiles(int number_of_files, char** configuration_files,
+		char const* key, char const* ring_file_name,
+		bool is_double_stepping, int engine)
+{
+  BasicEnigma<ALPHABET_SIZE> enigma;
+  int error_code = setUpEnigma(enigma, number_of_files, configuration_files,
+			       key, ring_file_name, is_double_stepping,
+			       engine, 0);
+  if (error_code != NO_ERROR) {
+    return error_code;
   }
 
-  return NO_ERROR;  
+  BasicFileCoder<ALPHABET_SIZE> coder(enigma);
+  string line;
+  while (getline(cin, line)) {
+    istringstream fields(line);
+    string input_file_name, output_file_name, extra_field;
+    if (!(fields >> input_file_name)) {
+      continue;
+    }
+    if (!(fields >> output_file_name) || fields >> extra_field) {
+      cerr << "Expected an input file and an output file in the line '";
+      cerr << line << "'" << endl;
+      return INVALID_ARGUMENT;
+    }
+    error_code = coder.codeFile(input_file_name.c_str(),
+				output_file_name.c_str());
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
+  }
+
+  return NO_ERROR;
 }
 
+int main(int argc, char** argv)
+{
+  if (argc > 2 && strcmp(argv[1], "crib-index") == 0) {
+    if (strcmp(argv[2], "build") == 0) {
+      return buildCribIndex(argc - 3, argv + 3);
+    } else if (strcmp(argv[2], "find") == 0) {
+      return findCribPositions(argc - 3, argv + 3);
+    }
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  if (argc > 1 && strcmp(argv[1], "crib-drag") == 0) {
+    return dragCribs(argc - 2, argv + 2);
+  }
+
+  if (argc > 2 && strcmp(argv[1], "cycles") == 0) {
+    if (strcmp(argv[2], "build") == 0) {
+      return buildCycleCatalog(argc - 3, argv + 3);
+    } else if (strcmp(argv[2], "find") == 0) {
+      return findCycleSettings(argc - 3, argv + 3);
+    }
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  if (argc > 2 && strcmp(argv[1], "search") == 0) {
+    if (strcmp(argv[2], "split") == 0) {
+      return splitKeySearch(argc - 3, argv + 3);
+    } else if (strcmp(argv[2], "run") == 0 && argc == 4) {
+      KeySearch search;
+      return search.run(argv[3]);
+    } else if (strcmp(argv[2], "merge") == 0) {
+      return mergeKeySearch(argc - 3, argv + 3);
+    }
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  if (argc > 2 && strcmp(argv[1], "key-sheet") == 0 &&
+      strcmp(argv[2], "build") == 0) {
+    return buildKeySheet(argc - 3, argv + 3);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "trace") == 0) {
+    if (argc != 3) {
+      printUsage();
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+    return Tracer::printTrace(argv[2], cout);
+  }
+
+  bool is_analysis = (argc > 1 && strcmp(argv[1], "analyze") == 0);
+  bool is_benchmark = (argc > 1 && strcmp(argv[1], "bench") == 0);
+  bool is_watching = (argc > 1 && strcmp(argv[1], "watch") == 0);
+  bool is_recoding = (argc > 1 && strcmp(argv[1], "recode") == 0);
+  int first_argument = (is_analysis || is_benchmark || is_watching
+			|| is_recoding) ? 2 : 1;
+  bool is_bytes = false;
+  bool is_pipelined = false;
+  bool is_profiled = false;
+  bool is_json = false;
+  long benchmark_length = 1000000;
+  int engine = ENGINE_AUTO;
+  char const* key = nullptr;
+  char const* ring_file_name = nullptr;
+  bool is_double_stepping = false;
+  char const* trace_file_name = nullptr;
+
+  for (; argc > first_argument && strncmp(argv[first_argument], "--", 2) == 0;
+       first_argument++) {
+    if (strcmp(argv[first_argument], "--bytes") == 0) {
+      is_bytes = true;
+    } else if (strcmp(argv[first_argument], "--pipeline") == 0) {
+      is_pipelined = true;
+    } else if (strcmp(argv[first_argument], "--profile") == 0) {
+      is_profiled = true;
+    } else if (strcmp(argv[first_argument], "--profile=json") == 0) {
+      is_profiled = true;
+      is_json = true;
+    } else if (is_benchmark &&
+	       strncmp(argv[first_argument], "--length=", 9) == 0 &&
+	       atol(argv[first_argument] + 9) > 0) {
+      benchmark_length = atol(argv[first_argument] + 9);
+    } else if (!is_analysis &&
+	       strncmp(argv[first_argument], "--key=", 6) == 0) {
+      key = argv[first_argument] + 6;
+    } else if (strncmp(argv[first_argument], "--rings=", 8) == 0) {
+      ring_file_name = argv[first_argument] + 8;
+    } else if (strcmp(argv[first_argument], "--double-step") == 0) {
+      is_double_stepping = true;
+    } else if (strncmp(argv[first_argument], "--engine=", 9) == 0) {
+      engine = findEngine(argv[first_argument] + 9);
+      if (engine == NUMBER_OF_ENGINES) {
+	cerr << "Unknown engine " << argv[first_argument] + 9 << endl;
+	printUsage();
+	return INVALID_ARGUMENT;
+      }
+    } else if (strncmp(argv[first_argument], "--max-table-mem=", 16) == 0) {
+      size_t budget = 0;
+      if (!parseMemorySize(argv[first_argument] + 16, budget)) {
+	cerr << "Invalid table memory size " << argv[first_argument] + 16;
+	cerr << endl;
+	printUsage();
+	return INVALID_ARGUMENT;
+      }
+      TableMemory::setBudget(budget);
+    } else if (strncmp(argv[first_argument], "--trace=", 8) == 0) {
+#ifdef ENIGMA_TRACE
+      trace_file_name = argv[first_argument] + 8;
+#else
+      cerr << "This build cannot trace; rebuild with 'make TRACE=1'" << endl;
+      return INVALID_ARGUMENT;
+#endif
+    } else {
+      cerr << "Unknown option " << argv[first_argument] << endl;
+      printUsage();
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+  }
+
+  int number_of_files = argc - first_argument;
+  char** configuration_files = argv + first_argument;
+
+  if ((key == nullptr) ? number_of_files < 3 : number_of_files != 1) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  if (is_pipelined && is_profiled) {
+    printUsage();
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+  }
+
+  if (is_watching) {
+    if (is_bytes || is_pipelined || is_profiled || key != nullptr) {
+      printUsage();
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+    return watchConfiguration(number_of_files, configuration_files,
+			      ring_file_name, is_double_stepping);
+  }
+
+  if (is_recoding) {
+    if (is_pipelined || is_profiled || trace_file_name != nullptr) {
+      printUsage();
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+    if (is_bytes) {
+      return recodeFiles<BYTE_ALPHABET_LENGTH>(number_of_files,
+					       configuration_files, key,
+					       ring_file_name,
+					       is_double_stepping, engine);
+    }
+    return recodeFiles<ALPHABET_LENGTH>(number_of_files, configuration_files,
+					key, ring_file_name,
+					is_double_stepping, engine);
+  }
+
+  if (is_analysis) {
+    if (is_pipelined || is_profiled || trace_file_name != nullptr
+	|| key != nullptr) {
+      printUsage();
+      return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+    if (is_bytes) {
+      return analyze<BYTE_ALPHABET_LENGTH>(number_of_files,
+					   configuration_files,
+					   ring_file_name,
+					   is_double_stepping);
+    }
+    return analyze<ALPHABET_LENGTH>(number_of_files, configuration_files,
+				    ring_file_name, is_double_stepping);
+  }
+
+  if (is_benchmark) {
+    Profiler profiler;
+    Profiler* benchmark_profiler = (is_profiled) ? &profiler : nullptr;
+    int error_code = (is_bytes)
+      ? benchmark<BYTE_ALPHABET_LENGTH>(number_of_files, configuration_files,
+					key, ring_file_name,
+					is_double_stepping, benchmark_length,
+					engine, benchmark_profiler)
+      : benchmark<ALPHABET_LENGTH>(number_of_files, configuration_files,
+				   key, ring_file_name, is_double_stepping,
+				   benchmark_length, engine,
+				   benchmark_profiler);
+    if (error_code == NO_ERROR && is_profiled) {
+      printProfile(profiler, is_json, cout);
+    }
+    return error_code;
+  }
+
+  uint64_t input_length = getInputLength();
+  if (is_profiled) {
+    Profiler profiler;
+    int error_code;
+    if (is_bytes) {
+      auto enigma = ByteEnigma();
+      error_code = setUpEnigma(enigma, number_of_files, configuration_files,
+			       key, ring_file_name, is_double_stepping,
+			       engine, input_length, &profiler);
+      if (error_code == NO_ERROR) {
+	error_code = codeProfiled(enigma, profiler);
+      }
+    } else {
+      auto enigma = Enigma();
+      error_code = setUpEnigma(enigma, number_of_files, configuration_files,
+			       key, ring_file_name, is_double_stepping,
+			       engine, input_length, &profiler);
+      if (error_code == NO_ERROR) {
+	error_code = codeProfiled(enigma, profiler);
+      }
+    }
+    printProfile(profiler, is_json, cerr);
+    return error_code;
+  }
+
+  if (is_bytes) {
+    auto enigma = ByteEnigma();
+    int error_code = setUpEnigma(enigma, number_of_files,
+				 configuration_files, key, ring_file_name,
+				 is_double_stepping, engine, input_length);
+    if (error_code != NO_ERROR) {
+      return error_code;
+    }
+    return codeTraced(enigma, (is_pipelined)
+		      ? codePipelined<BYTE_ALPHABET_LENGTH> : codeBytes,
+		      trace_file_name);
+  }
+
+  auto enigma = Enigma();
+  int error_code = setUpEnigma(enigma, number_of_files, configuration_files,
+			       key, ring_file_name, is_double_stepping,
+			       engine, input_length);
+  if (error_code != NO_ERROR) {
+    return error_code;
+  }
+  return codeTraced(enigma, (is_pipelined)
+		    ? codePipelined<ALPHABET_LENGTH> : codeLetters,
+		    trace_file_name);
+}
@@ -0,0 +1 @@
+254 242 46 230 175 206 5 210 142 246 36 99 27 12 75 155 85 234 111 28 94 0 25 108 255 154 192 207 139 174 136 102 227 109 249 178 93 148 95 182